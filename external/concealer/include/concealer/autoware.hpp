@@ -25,6 +25,7 @@
 #include <geometry_msgs/msg/pose.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <string>
 
 namespace concealer
 {
@@ -44,7 +45,12 @@ protected:
   std::atomic<geometry_msgs::msg::Pose> current_pose;
 
 public:
-  CONCEALER_PUBLIC explicit Autoware();
+  /**
+   * @param base_link_frame_id frame of the vehicle, broadcast relative to `map`
+   */
+  CONCEALER_PUBLIC explicit Autoware(const std::string & base_link_frame_id = "base_link");
+
+  const std::string base_link_frame_id;
 
   virtual auto getAcceleration() const -> double = 0;
 
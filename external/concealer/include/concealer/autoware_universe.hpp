@@ -27,6 +27,7 @@
 #include <concealer/subscriber_wrapper.hpp>
 #include <geometry_msgs/msg/accel_with_covariance_stamped.hpp>
 #include <nav_msgs/msg/odometry.hpp>
+#include <string>
 
 namespace concealer
 {
@@ -66,7 +67,13 @@ class AutowareUniverse : public Autoware
   auto stopAndJoin() -> void;
 
 public:
-  CONCEALER_PUBLIC explicit AutowareUniverse();
+  /**
+   * @param topic_namespace prepended to every topic, so that several instances do not share them
+   * @param base_link_frame_id frame of the vehicle, distinct for each instance for the same reason
+   */
+  CONCEALER_PUBLIC explicit AutowareUniverse(
+    const std::string & topic_namespace = "",
+    const std::string & base_link_frame_id = "base_link");
 
   ~AutowareUniverse();
 
@@ -21,6 +21,7 @@
 
 #include <chrono>
 #include <geometry_msgs/msg/pose.hpp>
+#include <string>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 
 namespace concealer
@@ -34,6 +35,8 @@ class ContinuousTransformBroadcaster
 
   geometry_msgs::msg::TransformStamped current_transform;
 
+  const std::string child_frame_id;
+
   const rclcpp::TimerBase::SharedPtr timer;
 
   void updateTransform()
@@ -52,7 +55,7 @@ public:
   {
     current_transform.header.stamp = static_cast<Node &>(*this).get_clock()->now();
     current_transform.header.frame_id = "map";
-    current_transform.child_frame_id = "base_link";
+    current_transform.child_frame_id = child_frame_id;
     current_transform.transform.translation.x = pose.position.x;
     current_transform.transform.translation.y = pose.position.y;
     current_transform.transform.translation.z = pose.position.z;
@@ -61,9 +64,10 @@ public:
     return current_transform;
   }
 
-  explicit ContinuousTransformBroadcaster()
+  explicit ContinuousTransformBroadcaster(const std::string & child_frame_id = "base_link")
   : transform_buffer(static_cast<Node &>(*this).get_clock()),
     transform_broadcaster(static_cast<Node *>(this)),
+    child_frame_id(child_frame_id),
     timer(static_cast<Node &>(*this).create_wall_timer(
       std::chrono::milliseconds(5), [this]() { return updateTransform(); }))
   {
@@ -16,11 +16,13 @@
 
 namespace concealer
 {
-Autoware::Autoware()
+Autoware::Autoware(const std::string & base_link_frame_id)
 : rclcpp::Node("concealer", "simulation", rclcpp::NodeOptions().use_global_arguments(false)),
+  ContinuousTransformBroadcaster<Autoware>(base_link_frame_id),
   current_acceleration(geometry_msgs::msg::Accel()),
   current_twist(geometry_msgs::msg::Twist()),
-  current_pose(geometry_msgs::msg::Pose())
+  current_pose(geometry_msgs::msg::Pose()),
+  base_link_frame_id(base_link_frame_id)
 {
 }
 
@@ -16,20 +16,25 @@
 
 namespace concealer
 {
-AutowareUniverse::AutowareUniverse()
-: getAckermannControlCommand("/control/command/control_cmd", rclcpp::QoS(1), *this),
-  getGearCommandImpl("/control/command/gear_cmd", rclcpp::QoS(1), *this),
-  getTurnIndicatorsCommand("/control/command/turn_indicators_cmd", rclcpp::QoS(1), *this),
+AutowareUniverse::AutowareUniverse(
+  const std::string & topic_namespace, const std::string & base_link_frame_id)
+: Autoware(base_link_frame_id),
+  getAckermannControlCommand(
+    topic_namespace + "/control/command/control_cmd", rclcpp::QoS(1), *this),
+  getGearCommandImpl(topic_namespace + "/control/command/gear_cmd", rclcpp::QoS(1), *this),
+  getTurnIndicatorsCommand(
+    topic_namespace + "/control/command/turn_indicators_cmd", rclcpp::QoS(1), *this),
   getPathWithLaneId(
-    "/planning/scenario_planning/lane_driving/behavior_planning/path_with_lane_id", rclcpp::QoS(1),
-    *this),
-  setAcceleration("/localization/acceleration", *this),
-  setOdometry("/localization/kinematic_state", *this),
-  setSteeringReport("/vehicle/status/steering_status", *this),
-  setGearReport("/vehicle/status/gear_status", *this),
-  setControlModeReport("/vehicle/status/control_mode", *this),
-  setVelocityReport("/vehicle/status/velocity_status", *this),
-  setTurnIndicatorsReport("/vehicle/status/turn_indicators_status", *this),
+    topic_namespace +
+      "/planning/scenario_planning/lane_driving/behavior_planning/path_with_lane_id",
+    rclcpp::QoS(1), *this),
+  setAcceleration(topic_namespace + "/localization/acceleration", *this),
+  setOdometry(topic_namespace + "/localization/kinematic_state", *this),
+  setSteeringReport(topic_namespace + "/vehicle/status/steering_status", *this),
+  setGearReport(topic_namespace + "/vehicle/status/gear_status", *this),
+  setControlModeReport(topic_namespace + "/vehicle/status/control_mode", *this),
+  setVelocityReport(topic_namespace + "/vehicle/status/velocity_status", *this),
+  setTurnIndicatorsReport(topic_namespace + "/vehicle/status/turn_indicators_status", *this),
   // Autoware.Universe requires localization topics to send data at 50Hz
   localization_update_timer(rclcpp::create_timer(
     this, get_clock(), std::chrono::milliseconds(20), [this]() { updateLocalization(); })),
@@ -84,7 +89,7 @@ auto AutowareUniverse::updateLocalization() -> void
   setAcceleration([this]() {
     geometry_msgs::msg::AccelWithCovarianceStamped message;
     message.header.stamp = get_clock()->now();
-    message.header.frame_id = "/base_link";
+    message.header.frame_id = "/" + base_link_frame_id;
     message.accel.accel = current_acceleration.load();
     message.accel.covariance.at(6 * 0 + 0) = 0.001;  // linear x
     message.accel.covariance.at(6 * 1 + 1) = 0.001;  // linear y
@@ -134,7 +139,7 @@ auto AutowareUniverse::updateVehicleState() -> void
     const auto twist = current_twist.load();
     autoware_auto_vehicle_msgs::msg::VelocityReport message;
     message.header.stamp = get_clock()->now();
-    message.header.frame_id = "base_link";
+    message.header.frame_id = base_link_frame_id;
     message.longitudinal_velocity = twist.linear.x;
     message.lateral_velocity = twist.linear.y;
     message.heading_rate = twist.angular.z;
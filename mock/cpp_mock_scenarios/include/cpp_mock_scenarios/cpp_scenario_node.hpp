@@ -56,6 +56,14 @@ public:
 
   auto isPedestrian(const std::string & name) const -> bool;
 
+private:
+  /*
+     simple_sensor_simulator running in this process if the parameter
+     "embed_simple_sensor_simulator" is set, which api_ then calls without
+     serializing the messages. Constructed first, so that api_ finds it.
+  */
+  const std::shared_ptr<rclcpp::Node> embedded_simulator_;
+
 protected:
   traffic_simulator::API api_;
   common::junit::JUnit5 junit_;
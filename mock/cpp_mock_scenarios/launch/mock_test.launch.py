@@ -33,6 +33,7 @@ from launch.event_handlers import OnProcessExit, OnProcessIO
 from launch.actions import EmitEvent, RegisterEventHandler, LogInfo, TimerAction, OpaqueFunction
 from launch.actions.declare_launch_argument import DeclareLaunchArgument
 from launch.substitutions.launch_configuration import LaunchConfiguration
+from launch.substitutions import PythonExpression
 
 from launch_ros.actions import Node
 
@@ -104,6 +105,7 @@ def launch_setup(context, *args, **kwargs):
     autoware_launch_package             = LaunchConfiguration("autoware_launch_package",                default=default_autoware_launch_package_of(architecture_type.perform(context)))
     consider_acceleration_by_road_slope = LaunchConfiguration("consider_acceleration_by_road_slope",    default=False)
     consider_pose_by_road_slope         = LaunchConfiguration("consider_pose_by_road_slope",            default=True)
+    embed_simple_sensor_simulator       = LaunchConfiguration("embed_simple_sensor_simulator",          default=False)
     global_frame_rate                   = LaunchConfiguration("global_frame_rate",                      default=20.0)
     global_real_time_factor             = LaunchConfiguration("global_real_time_factor",                default=1.0)
     global_timeout                      = LaunchConfiguration("global_timeout",                         default=180)
@@ -130,6 +132,7 @@ def launch_setup(context, *args, **kwargs):
     print(f"autoware_launch_package             := {autoware_launch_package.perform(context)}")
     print(f"consider_acceleration_by_road_slope := {consider_acceleration_by_road_slope.perform(context)}")
     print(f"consider_pose_by_road_slope         := {consider_pose_by_road_slope.perform(context)}")
+    print(f"embed_simple_sensor_simulator       := {embed_simple_sensor_simulator.perform(context)}")
     print(f"global_frame_rate                   := {global_frame_rate.perform(context)}")
     print(f"global_real_time_factor             := {global_real_time_factor.perform(context)}")
     print(f"global_timeout                      := {global_timeout.perform(context)}")
@@ -156,6 +159,7 @@ def launch_setup(context, *args, **kwargs):
             {"autoware_launch_package": autoware_launch_package},
             {"consider_acceleration_by_road_slope": consider_acceleration_by_road_slope},
             {"consider_pose_by_road_slope": consider_pose_by_road_slope},
+            {"embed_simple_sensor_simulator": embed_simple_sensor_simulator},
             {"initialize_duration": initialize_duration},
             {"launch_autoware": launch_autoware},
             {"port": port},
@@ -210,6 +214,7 @@ def launch_setup(context, *args, **kwargs):
         DeclareLaunchArgument("autoware_launch_package",             default_value=autoware_launch_package            ),
         DeclareLaunchArgument("consider_acceleration_by_road_slope", default_value=consider_acceleration_by_road_slope),
         DeclareLaunchArgument("consider_pose_by_road_slope",         default_value=consider_pose_by_road_slope        ),
+        DeclareLaunchArgument("embed_simple_sensor_simulator",       default_value=embed_simple_sensor_simulator      ),
         DeclareLaunchArgument("global_frame_rate",                   default_value=global_frame_rate                  ),
         DeclareLaunchArgument("global_real_time_factor",             default_value=global_real_time_factor            ),
         DeclareLaunchArgument("global_timeout",                      default_value=global_timeout                     ),
@@ -233,7 +238,7 @@ def launch_setup(context, *args, **kwargs):
             namespace="simulation",
             output="screen",
             parameters=make_parameters() + [{"use_sim_time": use_sim_time}],
-            condition=IfCondition(launch_simple_sensor_simulator),
+            condition=IfCondition(PythonExpression([launch_simple_sensor_simulator, " and not ", embed_simple_sensor_simulator])),
         ),
         Node(
             package="traffic_simulator",
@@ -14,6 +14,7 @@
 
 #include <cpp_mock_scenarios/cpp_scenario_node.hpp>
 #include <iostream>
+#include <simple_sensor_simulator/simple_sensor_simulator.hpp>
 
 namespace cpp_mock_scenarios
 {
@@ -22,6 +23,14 @@ CppScenarioNode::CppScenarioNode(
   const std::string & lanelet2_map_file, const std::string & scenario_filename, const bool verbose,
   const rclcpp::NodeOptions & option)
 : Node(node_name, option),
+  embedded_simulator_([this]() -> std::shared_ptr<rclcpp::Node> {
+    if (declare_parameter<bool>("embed_simple_sensor_simulator", false)) {
+      // reads the parameters given to this process, as the node launched on its own would
+      return std::make_shared<simple_sensor_simulator::ScenarioSimulator>(rclcpp::NodeOptions());
+    } else {
+      return nullptr;
+    }
+  }()),
   api_(
     this, configure(map_path, lanelet2_map_file, scenario_filename, verbose),
     declare_parameter<double>("global_real_time_factor", 1.0),
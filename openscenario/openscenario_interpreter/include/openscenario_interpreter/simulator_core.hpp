@@ -408,6 +408,9 @@ public:
           configuration.set_object_recognition_delay(controller.properties.template get<Double>("detectedObjectPublishingDelay"));
           configuration.set_pos_noise_stddev(controller.properties.template get<Double>("detectedObjectPositionStandardDeviation"));
           configuration.set_probability_of_lost(controller.properties.template get<Double>("detectedObjectMissingProbability"));
+          configuration.set_probability_of_false_positive(controller.properties.template get<Double>("detectedObjectFalsePositiveProbability"));
+          configuration.set_yaw_noise_stddev(controller.properties.template get<Double>("detectedObjectYawStandardDeviation"));
+          configuration.set_shape_noise_stddev(controller.properties.template get<Double>("detectedObjectShapeStandardDeviation"));
           configuration.set_random_seed(controller.properties.template get<UnsignedInteger>("randomSeed"));
           configuration.set_range(controller.properties.template get<Double>("detectionSensorRange",300.0));
           configuration.set_object_recognition_ground_truth_delay(controller.properties.template get<Double>("detectedObjectGroundTruthPublishingDelay"));
@@ -422,6 +425,7 @@ public:
           configuration.set_architecture_type(core->getROS2Parameter<std::string>("architecture_type", "awf/universe"));
           configuration.set_entity(entity_ref);
           configuration.set_filter_by_range(controller.properties.template get<Boolean>("isClairvoyant"));
+          configuration.set_ray_traced_occlusion(controller.properties.template get<Boolean>("occupancyGridRayTracedOcclusion"));
           configuration.set_height(200);
           configuration.set_range(300);
           configuration.set_resolution(0.5);
@@ -0,0 +1,245 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DELAY_LINE_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DELAY_LINE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief First-in first-out buffer over a fixed set of slots, doubled only when it runs full
+ * @note Slots are never destroyed while the buffer lives. A slot handed out by `push` holds
+ * whatever the element that last used it left behind, so the caller must overwrite all of it.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  explicit RingBuffer(std::size_t capacity = 1) : slots_(std::max<std::size_t>(capacity, 1)) {}
+
+  auto empty() const -> bool { return size_ == 0; }
+
+  auto size() const -> std::size_t { return size_; }
+
+  auto capacity() const -> std::size_t { return slots_.size(); }
+
+  /**
+   * @brief Element `i` counted from the oldest one
+   */
+  auto operator[](std::size_t i) -> T & { return slots_[(head_ + i) % slots_.size()]; }
+
+  auto operator[](std::size_t i) const -> const T & { return slots_[(head_ + i) % slots_.size()]; }
+
+  auto front() -> T & { return (*this)[0]; }
+
+  auto front() const -> const T & { return (*this)[0]; }
+
+  auto back() -> T & { return (*this)[size_ - 1]; }
+
+  auto back() const -> const T & { return (*this)[size_ - 1]; }
+
+  /**
+   * @brief Append a slot and return it to be filled in
+   */
+  auto push() -> T &
+  {
+    if (size_ == slots_.size()) {
+      std::rotate(slots_.begin(), slots_.begin() + head_, slots_.end());
+      head_ = 0;
+      slots_.resize(slots_.size() * 2);
+    }
+    return (*this)[size_++];
+  }
+
+  /**
+   * @brief Move the oldest element out and free its slot
+   * @note The buffer must not be empty.
+   */
+  auto pop() -> T
+  {
+    T value = std::move(front());
+    drop();
+    return value;
+  }
+
+  /**
+   * @brief Free the slot of the oldest element without moving it out
+   * @note The buffer must not be empty.
+   */
+  auto drop() -> void
+  {
+    head_ = (head_ + 1) % slots_.size();
+    --size_;
+  }
+
+  /**
+   * @brief Free the slot of the newest element, undoing the last push
+   * @note The buffer must not be empty.
+   */
+  auto unpush() -> void { --size_; }
+
+private:
+  std::vector<T> slots_;
+
+  std::size_t head_ = 0;
+
+  std::size_t size_ = 0;
+};
+
+/**
+ * @brief Messages of one sensor held back until they are `delay` seconds old
+ * @note The slots are allocated up front for as many messages as can be in flight when the sensor
+ * updates every `period` seconds, so steady operation allocates no bookkeeping per message.
+ */
+template <typename T>
+class DelayLine
+{
+public:
+  explicit DelayLine(double delay, double period = 0)
+  : delay_(delay),
+    slots_(
+      0 < delay and 0 < period ? static_cast<std::size_t>(std::ceil(delay / period)) + 1 : 1)
+  {
+  }
+
+  auto getDelay() const -> double { return delay_; }
+
+  auto empty() const -> bool { return slots_.empty(); }
+
+  auto size() const -> std::size_t { return slots_.size(); }
+
+  auto capacity() const -> std::size_t { return slots_.capacity(); }
+
+  /**
+   * @brief Append a message created at `time` and return it to be written in place
+   * @note The slot may hold a message published from it earlier, moved-from or not, so every
+   * field of the returned message must be assigned.
+   */
+  auto push(double time) -> T &
+  {
+    auto & slot = slots_.push();
+    slot.time = time;
+    return slot.message;
+  }
+
+  /**
+   * @brief Whether the oldest message has been delayed enough to be published at `time`
+   */
+  auto ready(double time) const -> bool
+  {
+    return not slots_.empty() and time - slots_.front().time >= delay_;
+  }
+
+  /**
+   * @brief Move the oldest message out to be published
+   * @note The delay line must not be empty.
+   */
+  auto pop() -> T { return std::move(slots_.pop().message); }
+
+  /**
+   * @brief Take back the newest message, which failed to be written after `push`
+   * @note The delay line must not be empty.
+   */
+  auto unpush() -> void { slots_.unpush(); }
+
+private:
+  struct Slot
+  {
+    T message;
+    double time = 0;
+  };
+
+  double delay_;
+
+  RingBuffer<Slot> slots_;
+};
+
+/**
+ * @brief Timestamped values shared by several readers, each looking back by its own delay
+ * @note Unlike a DelayLine, an entry is stored once however many readers publish it, and each
+ * reader picks the newest entry that is old enough for it instead of draining a queue of its own.
+ * Entries must be pushed in non-decreasing order of time.
+ */
+template <typename T>
+class History
+{
+public:
+  struct Entry
+  {
+    double time;
+    std::shared_ptr<const T> value;
+  };
+
+  /**
+   * @param delay longest delay of the readers
+   * @param period interval at which entries are pushed, which sizes the preallocated slots
+   */
+  explicit History(double delay = 0, double period = 0)
+  : entries_(
+      0 < delay and 0 < period ? static_cast<std::size_t>(std::ceil(delay / period)) + 2 : 2)
+  {
+  }
+
+  auto empty() const -> bool { return entries_.empty(); }
+
+  auto size() const -> std::size_t { return entries_.size(); }
+
+  auto push(double time, std::shared_ptr<const T> value) -> void
+  {
+    entries_.push() = Entry{time, std::move(value)};
+  }
+
+  /**
+   * @brief Find the newest entry that is at least `delay` seconds old at `time`
+   * @return pointer to the entry, or nullptr if every entry is younger than that
+   */
+  auto find(double time, double delay) const -> const Entry *
+  {
+    // number of entries that are old enough, compared the same way as DelayLine::ready
+    std::size_t lower = 0, upper = entries_.size();
+    while (lower < upper) {
+      if (const auto middle = (lower + upper) / 2; time - entries_[middle].time >= delay) {
+        lower = middle + 1;
+      } else {
+        upper = middle;
+      }
+    }
+    return lower == 0 ? nullptr : &entries_[lower - 1];
+  }
+
+  /**
+   * @brief Drop the entries older than the one `find(time, delay)` returns, which no reader with
+   * a delay of `delay` or less can reach any more
+   */
+  auto prune(double time, double delay) -> void
+  {
+    while (1 < entries_.size() and time - entries_[1].time >= delay) {
+      entries_.front().value.reset();
+      entries_.drop();
+    }
+  }
+
+private:
+  RingBuffer<Entry> entries_;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DELAY_LINE_HPP_
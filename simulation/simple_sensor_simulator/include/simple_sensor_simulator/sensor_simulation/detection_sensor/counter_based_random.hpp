@@ -0,0 +1,132 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__COUNTER_BASED_RANDOM_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__COUNTER_BASED_RANDOM_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Philox4x32-10 block function (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+ * 3", SC 2011)
+ * @note The output is a pure function of the counter and the key, so any number can be drawn in
+ * any order without carrying generator state between them.
+ */
+struct Philox4x32
+{
+  using Counter = std::array<std::uint32_t, 4>;
+
+  using Key = std::array<std::uint32_t, 2>;
+
+  static auto generate(Counter counter, Key key) -> Counter
+  {
+    for (int round = 0; round < 10; ++round) {
+      if (round != 0) {
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+      }
+      const auto product0 = std::uint64_t(0xD2511F53) * counter[0];
+      const auto product1 = std::uint64_t(0xCD9E8D57) * counter[2];
+      counter = {
+        static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+        static_cast<std::uint32_t>(product1),
+        static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+        static_cast<std::uint32_t>(product0)};
+    }
+    return counter;
+  }
+};
+
+/**
+ * @brief Stable 64-bit FNV-1a hash of an entity name, used to key the random numbers of an entity
+ */
+inline auto hashEntityName(const std::string & name) -> std::uint64_t
+{
+  auto hash = std::uint64_t(0xCBF29CE484222325);
+  for (const auto c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * std::uint64_t(0x100000001B3);
+  }
+  return hash;
+}
+
+/**
+ * @brief Random numbers addressed by (seed, stream, frame, entity) instead of drawn in sequence
+ * @note The same entity gets the same numbers in the same frame however many other entities there
+ * are and whatever order they come in. Each noise model draws from its own stream, so enabling one
+ * does not shift the numbers of another.
+ */
+class CounterBasedRandom
+{
+public:
+  explicit CounterBasedRandom(std::uint32_t seed = 0) : seed_(seed) {}
+
+  auto operator()(std::uint32_t stream, std::uint64_t frame, std::uint64_t entity) const
+    -> Philox4x32::Counter
+  {
+    return Philox4x32::generate(
+      {static_cast<std::uint32_t>(frame), static_cast<std::uint32_t>(frame >> 32),
+       static_cast<std::uint32_t>(entity), static_cast<std::uint32_t>(entity >> 32)},
+      {seed_, stream});
+  }
+
+  /**
+   * @brief Map a 32-bit word to the open interval (0, 1)
+   */
+  static auto uniform(std::uint32_t word) -> double { return (word + 0.5) * 0x1p-32; }
+
+  /**
+   * @brief Fill `values` with one uniform number in (0, 1) per entity
+   */
+  auto fillUniform(
+    std::uint32_t stream, std::uint64_t frame, const std::vector<std::uint64_t> & entities,
+    std::vector<double> & values) const -> void
+  {
+    values.resize(entities.size());
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+      values[i] = uniform((*this)(stream, frame, entities[i])[0]);
+    }
+  }
+
+  /**
+   * @brief Fill `values0` and `values1` with two independent standard normal numbers per entity
+   * @note Box-Muller transform of the first two words of each block.
+   */
+  auto fillNormal(
+    std::uint32_t stream, std::uint64_t frame, const std::vector<std::uint64_t> & entities,
+    std::vector<double> & values0, std::vector<double> & values1) const -> void
+  {
+    values0.resize(entities.size());
+    values1.resize(entities.size());
+    for (std::size_t i = 0; i < entities.size(); ++i) {
+      const auto block = (*this)(stream, frame, entities[i]);
+      const auto radius = std::sqrt(-2 * std::log(uniform(block[0])));
+      const auto angle = 2 * M_PI * uniform(block[1]);
+      values0[i] = radius * std::cos(angle);
+      values1[i] = radius * std::sin(angle);
+    }
+  }
+
+private:
+  std::uint32_t seed_;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__COUNTER_BASED_RANDOM_HPP_
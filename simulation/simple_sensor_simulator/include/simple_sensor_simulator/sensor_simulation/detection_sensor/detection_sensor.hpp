@@ -17,11 +17,21 @@
 
 #include <simulation_api_schema.pb.h>
 
+#include <algorithm>
+#include <autoware_auto_perception_msgs/msg/detected_objects.hpp>
+#include <autoware_auto_perception_msgs/msg/tracked_objects.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
-#include <queue>
-#include <random>
 #include <rclcpp/rclcpp.hpp>
+#include <simple_sensor_simulator/sensor_simulation/delay_line.hpp>
+#include <simple_sensor_simulator/sensor_simulation/detection_sensor/noise_model.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_status_view.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -44,17 +54,27 @@ protected:
   auto isEgoEntityStatusToWhichThisSensorIsAttached(
     const traffic_simulator_msgs::EntityStatus &) const -> bool;
 
-  auto findEgoEntityStatusToWhichThisSensorIsAttached(
-    const std::vector<traffic_simulator_msgs::EntityStatus> &) const
-    -> std::vector<traffic_simulator_msgs::EntityStatus>::const_iterator;
+  auto findEgoEntityStatusToWhichThisSensorIsAttached(const EntityStatusView &) const
+    -> EntityStatusView::const_iterator;
 
 public:
   virtual ~DetectionSensorBase() = default;
 
+  auto getEntity() const -> const std::string & { return configuration_.entity(); }
+
+  auto getRange() const -> double { return configuration_.range(); }
+
   virtual void update(
-    const double current_simulation_time, const std::vector<traffic_simulator_msgs::EntityStatus> &,
+    const double current_simulation_time, const EntityStatusView &,
     const rclcpp::Time & current_ros_time,
-    const std::vector<std::string> & lidar_detected_entities) = 0;
+    const std::unordered_set<std::string> & lidar_detected_entities) = 0;
+
+  /**
+   * @brief Drop what is kept of the entities that no longer exist
+   * @param exists whether an entity of the name exists, culled out of range or not
+   */
+  virtual auto forgetDespawnedEntities(const std::function<bool(const std::string &)> & exists)
+    -> void = 0;
 };
 
 template <typename T, typename U = autoware_auto_perception_msgs::msg::TrackedObjects>
@@ -64,32 +84,102 @@ class DetectionSensor : public DetectionSensorBase
 
   const typename rclcpp::Publisher<U>::SharedPtr ground_truth_objects_publisher;
 
-  std::default_random_engine random_engine_;
+  const std::shared_ptr<ThreadPool> publishing_thread_;
+
+  NoiseModelPipeline noise_models_;
+
+  struct Frame
+  {
+    autoware_auto_perception_msgs::msg::DetectedObjects detected_objects;
+
+    autoware_auto_perception_msgs::msg::TrackedObjects ground_truth_objects;
+
+    // hashEntityName of the entity of each detected object
+    std::vector<std::uint64_t> entities;
+  };
+
+  // read by both the detected objects and the ground truth objects, each with its own delay
+  History<Frame> frames_;
+
+  // frames that are reused once History and the noise application no longer hold them
+  std::vector<std::shared_ptr<Frame>> frame_pool_;
+
+  /**
+   * @brief Everything of the detection of an entity that does not change from frame to frame
+   * @note Built when the entity is first detected and rebuilt when its bounding box or subtype
+   * changes. Each update only patches the pose and the twist into a copy of it.
+   */
+  struct DetectionTemplate
+  {
+    traffic_simulator_msgs::BoundingBox bounding_box;
+
+    std::int32_t subtype;
+
+    std::uint64_t entity;
+
+    autoware_auto_perception_msgs::msg::DetectedObject detected_object;
 
-  std::queue<std::pair<autoware_auto_perception_msgs::msg::DetectedObjects, double>>
-    detected_objects_queue;
+    autoware_auto_perception_msgs::msg::TrackedObject ground_truth_object;
+  };
 
-  std::queue<std::pair<autoware_auto_perception_msgs::msg::TrackedObjects, double>>
-    ground_truth_objects_queue;
+  /*
+     Kept while the entity is out of range too, so that an entity moving in
+     and out of range near the edge is not built again each time. Cleared of
+     the entities that were despawned.
+  */
+  std::unordered_map<std::string, DetectionTemplate> templates_;
+
+  auto acquireFrame() -> std::shared_ptr<Frame>
+  {
+    for (const auto & frame : frame_pool_) {
+      if (frame.use_count() == 1) {
+        return frame;
+      }
+    }
+    return frame_pool_.emplace_back(std::make_shared<Frame>());
+  }
+
+  double detected_objects_time_ = -std::numeric_limits<double>::infinity();
+
+  double ground_truth_objects_time_ = -std::numeric_limits<double>::infinity();
 
 public:
   explicit DetectionSensor(
     const double current_simulation_time,
     const simulation_api_schema::DetectionSensorConfiguration & configuration,
     const typename rclcpp::Publisher<T>::SharedPtr & publisher,
-    const typename rclcpp::Publisher<U>::SharedPtr & ground_truth_publisher = nullptr)
+    const typename rclcpp::Publisher<U>::SharedPtr & ground_truth_publisher = nullptr,
+    const std::shared_ptr<ThreadPool> & publishing_thread = nullptr)
   : DetectionSensorBase(current_simulation_time, configuration),
     detected_objects_publisher(publisher),
     ground_truth_objects_publisher(ground_truth_publisher),
-    random_engine_(configuration.random_seed())
+    publishing_thread_(publishing_thread),
+    noise_models_(configuration),
+    frames_(
+      std::max(
+        configuration.object_recognition_delay(),
+        configuration.object_recognition_ground_truth_delay()),
+      configuration.update_duration())
   {
   }
 
   ~DetectionSensor() override = default;
 
   auto update(
-    const double, const std::vector<traffic_simulator_msgs::EntityStatus> &, const rclcpp::Time &,
-    const std::vector<std::string> & lidar_detected_entities) -> void override;
+    const double, const EntityStatusView &, const rclcpp::Time &,
+    const std::unordered_set<std::string> & lidar_detected_entities) -> void override;
+
+  auto forgetDespawnedEntities(const std::function<bool(const std::string &)> & exists)
+    -> void override
+  {
+    for (auto iter = templates_.begin(); iter != templates_.end();) {
+      if (exists(iter->first)) {
+        ++iter;
+      } else {
+        iter = templates_.erase(iter);
+      }
+    }
+  }
 };
 }  // namespace simple_sensor_simulator
 
@@ -0,0 +1,171 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__NOISE_MODEL_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__NOISE_MODEL_HPP_
+
+#include <simulation_api_schema.pb.h>
+
+#include <autoware_auto_perception_msgs/msg/detected_objects.hpp>
+#include <cstdint>
+#include <geometry_msgs/msg/pose.hpp>
+#include <memory>
+#include <simple_sensor_simulator/sensor_simulation/detection_sensor/counter_based_random.hpp>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Detected objects of one frame in structure-of-arrays layout, which the noise models edit
+ * @note Rows past `DetectedObjects::objects.size()` are false positives, which are appended as new
+ * objects when the frame is written back.
+ */
+struct NoiseTarget
+{
+  std::vector<std::uint64_t> entities;
+
+  std::vector<double> x, y, yaw_offset, length, width;
+
+  std::vector<std::uint8_t> lost;
+
+  // scratch space for the random numbers of one model, reused across frames
+  std::vector<double> random0, random1;
+
+  double ego_x = 0, ego_y = 0, range = 0;
+
+  auto size() const -> std::size_t { return entities.size(); }
+
+  auto resize(std::size_t) -> void;
+
+  auto read(
+    const autoware_auto_perception_msgs::msg::DetectedObjects &,
+    const std::vector<std::uint64_t> & entities) -> void;
+
+  auto write(autoware_auto_perception_msgs::msg::DetectedObjects &) const -> void;
+};
+
+enum NoiseStream : std::uint32_t {
+  POSITION,
+  YAW,
+  SHAPE,
+  MISDETECTION,
+  FALSE_POSITIVE,
+};
+
+/**
+ * @brief One stage of the detection noise pipeline
+ * @note A model draws its random numbers through CounterBasedRandom from its own stream, so the
+ * noise of an entity depends only on the seed, the frame and the entity.
+ */
+class NoiseModel
+{
+public:
+  virtual ~NoiseModel() = default;
+
+  virtual auto apply(const CounterBasedRandom &, std::uint64_t frame, NoiseTarget &) const
+    -> void = 0;
+};
+
+class PositionNoiseModel : public NoiseModel
+{
+  const double standard_deviation_;
+
+public:
+  explicit PositionNoiseModel(double standard_deviation) : standard_deviation_(standard_deviation)
+  {
+  }
+
+  auto apply(const CounterBasedRandom &, std::uint64_t, NoiseTarget &) const -> void override;
+};
+
+class YawNoiseModel : public NoiseModel
+{
+  const double standard_deviation_;
+
+public:
+  explicit YawNoiseModel(double standard_deviation) : standard_deviation_(standard_deviation) {}
+
+  auto apply(const CounterBasedRandom &, std::uint64_t, NoiseTarget &) const -> void override;
+};
+
+class ShapeNoiseModel : public NoiseModel
+{
+  const double standard_deviation_;
+
+public:
+  explicit ShapeNoiseModel(double standard_deviation) : standard_deviation_(standard_deviation) {}
+
+  auto apply(const CounterBasedRandom &, std::uint64_t, NoiseTarget &) const -> void override;
+};
+
+class MisdetectionNoiseModel : public NoiseModel
+{
+  const double probability_;
+
+public:
+  explicit MisdetectionNoiseModel(double probability) : probability_(probability) {}
+
+  auto apply(const CounterBasedRandom &, std::uint64_t, NoiseTarget &) const -> void override;
+};
+
+/**
+ * @brief Add a car-sized object of unknown class at a uniformly random point in the sensor range
+ */
+class FalsePositiveNoiseModel : public NoiseModel
+{
+  const double probability_;
+
+public:
+  explicit FalsePositiveNoiseModel(double probability) : probability_(probability) {}
+
+  auto apply(const CounterBasedRandom &, std::uint64_t, NoiseTarget &) const -> void override;
+};
+
+/**
+ * @brief Noise models applied in order to each frame of detected objects
+ */
+class NoiseModelPipeline
+{
+public:
+  /**
+   * @brief Build the models enabled in `configuration`, seeded with its random seed
+   */
+  explicit NoiseModelPipeline(const simulation_api_schema::DetectionSensorConfiguration &);
+
+  auto add(std::unique_ptr<NoiseModel> model) -> void { models_.push_back(std::move(model)); }
+
+  auto empty() const -> bool { return models_.empty(); }
+
+  /**
+   * @param entities hashEntityName of the entity of each object, in the same order
+   */
+  auto operator()(
+    autoware_auto_perception_msgs::msg::DetectedObjects &,
+    const std::vector<std::uint64_t> & entities, const geometry_msgs::msg::Pose & ego_pose)
+    -> void;
+
+private:
+  CounterBasedRandom random_;
+
+  double range_;
+
+  std::vector<std::unique_ptr<NoiseModel>> models_;
+
+  std::uint64_t frame_ = 0;
+
+  NoiseTarget target_;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__DETECTION_SENSOR__NOISE_MODEL_HPP_
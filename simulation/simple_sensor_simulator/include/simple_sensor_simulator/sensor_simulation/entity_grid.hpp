@@ -0,0 +1,95 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_GRID_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_GRID_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Uniform grid over the horizontal positions of the entities, used to find the entities
+ * in range of a sensor without visiting every entity of the scenario.
+ * @note Each entity is stored as a circle that encloses its bounding box, so a query never misses
+ * an entity whose box reaches into the queried range.
+ */
+class EntityGrid
+{
+public:
+  explicit EntityGrid(double cell_size = 50.0);
+
+  auto getCellSize() const -> double { return cell_size_; }
+
+  /**
+   * @brief Add the entity, or replace it if it already exists
+   * @param radius radius of the circle around (x, y) that encloses the bounding box of the entity
+   */
+  auto insert(const std::string & name, double x, double y, double radius) -> void;
+
+  /**
+   * @brief Move an existing entity, keeping its radius
+   * @exception std::out_of_range if the entity does not exist
+   */
+  auto move(const std::string & name, double x, double y) -> void;
+
+  auto erase(const std::string & name) -> void;
+
+  auto clear() -> void;
+
+  auto contains(const std::string & name) const -> bool;
+
+  auto size() const -> std::size_t { return entries_.size(); }
+
+  /**
+   * @brief List the entities whose circle overlaps the circle of `range` around (x, y)
+   * @note The result is unordered.
+   */
+  auto query(double x, double y, double range) const -> std::vector<std::string>;
+
+private:
+  using CellKey = std::uint64_t;
+
+  struct Entry
+  {
+    double x;
+    double y;
+    double radius;
+    CellKey cell;
+  };
+
+  auto cellIndex(double value) const -> std::int32_t;
+
+  static auto cellKey(std::int32_t x, std::int32_t y) -> CellKey;
+
+  auto link(const std::string & name, CellKey cell) -> void;
+
+  auto unlink(const std::string & name, CellKey cell) -> void;
+
+  double cell_size_;
+
+  std::unordered_map<std::string, Entry> entries_;
+
+  std::unordered_map<CellKey, std::vector<std::string>> cells_;
+
+  // largest radius ever inserted, by which every query is widened to reach neighboring cells
+  double max_radius_ = 0;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_GRID_HPP_
@@ -0,0 +1,130 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_STATUS_VIEW_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_STATUS_VIEW_HPP_
+
+#include <simulation_api_schema.pb.h>
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Statuses of the entities given to a sensor, referred to instead of copied
+ * @note Made implicitly from a vector of statuses, which it then refers to as a whole. A view of
+ * some of the statuses refers to them by their indices in the vector. In both cases, the vector
+ * must outlive the view.
+ */
+class EntityStatusView
+{
+public:
+  using value_type = traffic_simulator_msgs::EntityStatus;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EntityStatusView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    explicit const_iterator(pointer data, const std::size_t * indices, std::size_t position)
+    : data_(data), indices_(indices), position_(position)
+    {
+    }
+
+    auto operator*() const -> reference
+    {
+      return data_[indices_ ? indices_[position_] : position_];
+    }
+
+    auto operator->() const -> pointer { return &**this; }
+
+    auto operator++() -> const_iterator &
+    {
+      ++position_;
+      return *this;
+    }
+
+    auto operator++(int) -> const_iterator
+    {
+      auto copy = *this;
+      ++position_;
+      return copy;
+    }
+
+    auto operator==(const const_iterator & other) const { return position_ == other.position_; }
+
+    auto operator!=(const const_iterator & other) const { return position_ != other.position_; }
+
+  private:
+    pointer data_ = nullptr;
+
+    const std::size_t * indices_ = nullptr;
+
+    std::size_t position_ = 0;
+  };
+
+  using iterator = const_iterator;
+
+  EntityStatusView() = default;
+
+  // implicit, so that a vector of statuses is given wherever a view is taken
+  EntityStatusView(const std::vector<value_type> & statuses)
+  : data_(statuses.data()), size_(statuses.size())
+  {
+  }
+
+  /**
+   * @param indices of the statuses in `statuses`, in the order they are iterated
+   */
+  explicit EntityStatusView(
+    const std::vector<value_type> & statuses, std::vector<std::size_t> && indices)
+  : data_(statuses.data()), size_(indices.size()), indices_(std::move(indices)), indexed_(true)
+  {
+  }
+
+  auto size() const noexcept -> std::size_t { return size_; }
+
+  auto empty() const noexcept -> bool { return size_ == 0; }
+
+  auto begin() const noexcept -> const_iterator
+  {
+    return const_iterator(data_, indexed_ ? indices_.data() : nullptr, 0);
+  }
+
+  auto end() const noexcept -> const_iterator
+  {
+    return const_iterator(data_, indexed_ ? indices_.data() : nullptr, size_);
+  }
+
+private:
+  const value_type * data_ = nullptr;
+
+  std::size_t size_ = 0;
+
+  std::vector<std::size_t> indices_;
+
+  bool indexed_ = false;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__ENTITY_STATUS_VIEW_HPP_
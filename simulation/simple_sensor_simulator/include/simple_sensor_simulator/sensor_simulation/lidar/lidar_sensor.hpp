@@ -19,10 +19,14 @@
 
 #include <geometry/quaternion/get_rotation_matrix.hpp>
 #include <memory>
-#include <queue>
 #include <rclcpp/rclcpp.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <simple_sensor_simulator/sensor_simulation/delay_line.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_status_view.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
 #include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
+#include <simple_sensor_simulator/sensor_simulation/publish.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
 #include <string>
 #include <vector>
 
@@ -35,13 +39,21 @@ protected:
 
   simulation_api_schema::LidarConfiguration configuration_;
 
-  Raycaster raycaster_;
+  // of the point clouds, which are relative to the entity the sensor is attached to
+  const std::string frame_id_;
+
+  // shared with an occupancy grid sensor attached to the same entity, if any
+  const std::shared_ptr<Raycaster> raycaster_;
   std::vector<std::string> detected_objects_;
 
   explicit LidarSensorBase(
     const double current_simulation_time,
-    const simulation_api_schema::LidarConfiguration & configuration)
-  : previous_simulation_time_(current_simulation_time), configuration_(configuration)
+    const simulation_api_schema::LidarConfiguration & configuration,
+    const std::shared_ptr<ThreadPool> & thread_pool, const std::string & frame_id)
+  : previous_simulation_time_(current_simulation_time),
+    configuration_(configuration),
+    frame_id_(frame_id),
+    raycaster_(std::make_shared<Raycaster>(thread_pool))
   {
   }
 
@@ -49,10 +61,24 @@ public:
   virtual ~LidarSensorBase() = default;
 
   virtual auto update(
-    const double current_simulation_time, const std::vector<traffic_simulator_msgs::EntityStatus> &,
+    const double current_simulation_time, const EntityStatusView &,
     const rclcpp::Time & current_ros_time) -> void = 0;
 
   auto getDetectedObjects() const -> const std::vector<std::string> & { return detected_objects_; }
+
+  auto getEntity() const -> const std::string & { return configuration_.entity(); }
+
+  auto getRaycaster() const -> const std::shared_ptr<Raycaster> & { return raycaster_; }
+
+  /**
+   * @brief Distance up to which rays are traced
+   */
+  auto getRange() const -> double { return 300.0; }
+
+  auto setPointCloudMap(const std::shared_ptr<const PointCloudMap> & point_cloud_map) -> void
+  {
+    raycaster_->setPointCloudMap(point_cloud_map);
+  }
 };
 
 template <typename T>
@@ -60,55 +86,69 @@ class LidarSensor : public LidarSensorBase
 {
   const typename rclcpp::Publisher<T>::SharedPtr publisher_ptr_;
 
-  std::queue<std::pair<sensor_msgs::msg::PointCloud2, double>> queue_pointcloud_;
+  const std::shared_ptr<ThreadPool> publishing_thread_;
+
+  DelayLine<T> delayed_pointclouds_;
 
-  auto raycast(const std::vector<traffic_simulator_msgs::EntityStatus> &, const rclcpp::Time &)
-    -> T;
+  auto raycast(const EntityStatusView &, const rclcpp::Time &, T &) -> void;
 
 public:
   explicit LidarSensor(
     const double current_simulation_time,
     const simulation_api_schema::LidarConfiguration & configuration,
-    const typename rclcpp::Publisher<T>::SharedPtr & publisher_ptr)
-  : LidarSensorBase(current_simulation_time, configuration), publisher_ptr_(publisher_ptr)
+    const typename rclcpp::Publisher<T>::SharedPtr & publisher_ptr,
+    const std::shared_ptr<ThreadPool> & thread_pool,
+    const std::shared_ptr<ThreadPool> & publishing_thread = nullptr,
+    const std::string & frame_id = "base_link")
+  : LidarSensorBase(current_simulation_time, configuration, thread_pool, frame_id),
+    publisher_ptr_(publisher_ptr),
+    publishing_thread_(publishing_thread),
+    delayed_pointclouds_(configuration.lidar_sensor_delay(), configuration.scan_duration())
   {
-    raycaster_.setDirection(configuration);
+    raycaster_->setDirection(configuration);
   }
 
   auto update(
-    const double current_simulation_time,
-    const std::vector<traffic_simulator_msgs::EntityStatus> & status,
+    const double current_simulation_time, const EntityStatusView & status,
     const rclcpp::Time & current_ros_time) -> void override
   {
     if (
       current_simulation_time - previous_simulation_time_ - configuration_.scan_duration() >=
       -0.002) {
       previous_simulation_time_ = current_simulation_time;
-      queue_pointcloud_.push(
-        std::make_pair(raycast(status, current_ros_time), current_simulation_time));
+      if (configuration_.lidar_sensor_delay() <= 0) {
+        /*
+           Without delay the scan is written straight into the message handed
+           over to the publisher, which takes it without a copy. PointCloud2 is
+           not of a fixed size, so it is never loaned by the middleware.
+        */
+        auto pointcloud = std::make_unique<T>();
+        raycast(status, current_ros_time, *pointcloud);
+        publish(publishing_thread_, publisher_ptr_, std::move(pointcloud));
+        return;
+      }
+      // a scan that fails must not be left in the delay line to be published later
+      auto & pointcloud = delayed_pointclouds_.push(current_simulation_time);
+      try {
+        raycast(status, current_ros_time, pointcloud);
+      } catch (...) {
+        delayed_pointclouds_.unpush();
+        throw;
+      }
     } else {
       detected_objects_.clear();
     }
 
-    if (
-      not queue_pointcloud_.empty() and
-      current_simulation_time - queue_pointcloud_.front().second >=
-        configuration_.lidar_sensor_delay()) {
-      const auto pointcloud = queue_pointcloud_.front().first;
-      queue_pointcloud_.pop();
-      publisher_ptr_->publish(pointcloud);
+    if (delayed_pointclouds_.ready(current_simulation_time)) {
+      publish(
+        publishing_thread_, publisher_ptr_, std::make_unique<T>(delayed_pointclouds_.pop()));
     }
   }
-
-private:
-  // Override
-  Raycaster raycaster_;
 };
 
 template <>
 auto LidarSensor<sensor_msgs::msg::PointCloud2>::raycast(
-  const std::vector<traffic_simulator_msgs::EntityStatus> &, const rclcpp::Time &)
-  -> sensor_msgs::msg::PointCloud2;
+  const EntityStatusView &, const rclcpp::Time &, sensor_msgs::msg::PointCloud2 &) -> void;
 }  // namespace simple_sensor_simulator
 
 #endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__LIDAR__LIDAR_SENSOR_HPP_
@@ -0,0 +1,75 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__LIDAR__POINT_CLOUD_MAP_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__LIDAR__POINT_CLOUD_MAP_HPP_
+
+#include <embree4/rtcore.h>
+
+#include <filesystem>
+#include <mutex>
+#include <simple_sensor_simulator/sensor_simulation/primitives/primitive.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Static world geometry built from the pointcloud map (.pcd) of the scenario
+ * @note The map is reduced to one point per occupied voxel, and each point is traced by Embree as a
+ * sphere enclosing its voxel. The voxels are cached in a file next to the map, so later runs on
+ * the same map skip loading and voxelizing the whole pointcloud.
+ */
+class PointCloudMap
+{
+public:
+  explicit PointCloudMap(const std::filesystem::path & pcd_path, float voxel_size);
+
+  ~PointCloudMap();
+
+  PointCloudMap(const PointCloudMap &) = delete;
+
+  PointCloudMap & operator=(const PointCloudMap &) = delete;
+
+  const float voxel_size;
+
+  auto getVoxels() const -> const std::vector<Vertex> & { return voxels_; }
+
+  /**
+   * @brief Scene of the voxels as a single sphere point geometry, for the raycasters on `device`
+   * to instance
+   * @note The map never moves, so its BVH is built once per device with the highest quality, on
+   * the first call, and shared by every raycaster afterwards. The scene is owned by the map.
+   */
+  auto getScene(RTCDevice device) const -> RTCScene;
+
+  static auto cachePath(const std::filesystem::path & pcd_path, float voxel_size)
+    -> std::filesystem::path;
+
+private:
+  auto load(const std::filesystem::path & pcd_path) -> void;
+
+  auto loadCache(const std::filesystem::path & pcd_path) -> bool;
+
+  auto saveCache(const std::filesystem::path & pcd_path) const -> void;
+
+  std::vector<Vertex> voxels_;
+
+  mutable std::mutex scenes_mutex_;
+
+  mutable std::unordered_map<RTCDevice, RTCScene> scenes_;
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__LIDAR__POINT_CLOUD_MAP_HPP_
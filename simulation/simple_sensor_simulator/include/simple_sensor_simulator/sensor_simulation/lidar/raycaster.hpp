@@ -16,19 +16,24 @@
 #define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__LIDAR__RAYCASTER_HPP_
 
 #include <embree4/rtcore.h>
-#include <pcl_conversions/pcl_conversions.h>
+#include <simulation_api_schema.pb.h>
 
-#include <geometry/quaternion/euler_to_quaternion.hpp>
+#include <cstdint>
 #include <geometry/quaternion/get_rotation_matrix.hpp>
 #include <geometry_msgs/msg/pose.hpp>
 #include <geometry_msgs/msg/vector3.hpp>
 #include <memory>
 #include <random>
+#include <rclcpp/time.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_status_view.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
 #include <simple_sensor_simulator/sensor_simulation/primitives/box.hpp>
 #include <simple_sensor_simulator/sensor_simulation/primitives/primitive.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -37,85 +42,127 @@ namespace simple_sensor_simulator
 class Raycaster
 {
 public:
-  Raycaster();
-  explicit Raycaster(std::string embree_config);
+  /**
+   * @param thread_pool traces the rays, and is meant to be shared by every raycaster of the
+   * simulator so that sensors do not oversubscribe the CPU
+   */
+  explicit Raycaster(std::shared_ptr<ThreadPool> thread_pool);
+  explicit Raycaster(std::string embree_config, std::shared_ptr<ThreadPool> thread_pool);
   ~Raycaster();
   template <typename T, typename... Ts>
   void addPrimitive(std::string name, Ts &&... xs)
   {
-    if (primitive_ptrs_.count(name) != 0) {
+    if (instances_.count(name) != 0) {
       throw std::runtime_error("primitive " + name + " already exist.");
     }
-    auto primitive_ptr = std::make_unique<T>(std::forward<Ts>(xs)...);
-    primitive_ptrs_.emplace(name, std::move(primitive_ptr));
+    attachInstance(name, std::make_unique<T>(std::forward<Ts>(xs)...));
   }
+  template <typename T>
+  auto getPrimitive(const std::string & name) const -> const T *
+  {
+    if (const auto instance = instances_.find(name); instance != instances_.end()) {
+      return dynamic_cast<const T *>(instance->second.primitive_ptr.get());
+    } else {
+      return nullptr;
+    }
+  }
+  void setPrimitivePose(const std::string & name, const geometry_msgs::msg::Pose & pose);
+  void removePrimitive(const std::string & name);
+  auto getPrimitiveNames() const -> std::vector<std::string>;
+  // Make the primitives match the bounding boxes of `entities`, except `ego_name`. Primitives of
+  // entities missing from `entities` are removed, or only disabled until the next update if
+  // `disable_missing` is set, so that another sensor sharing the scene keeps them.
+  void updatePrimitives(
+    const EntityStatusView & entities, const std::string & ego_name, bool disable_missing = false);
+  // Static geometry hit by the rays but never reported as a detected object.
+  void setPointCloudMap(const std::shared_ptr<const PointCloudMap> & point_cloud_map);
   const sensor_msgs::msg::PointCloud2 raycast(
     const std::string & frame_id, const rclcpp::Time & stamp,
     const geometry_msgs::msg::Pose & origin, double max_distance = 300, double min_distance = 0);
+  // Write the scan directly into the data buffer of an existing message (e.g. a loaned message).
+  void raycast(
+    sensor_msgs::msg::PointCloud2 & pointcloud_msg, const std::string & frame_id,
+    const rclcpp::Time & stamp, const geometry_msgs::msg::Pose & origin,
+    double max_distance = 300, double min_distance = 0);
+  // Trace `ray_count` rays evenly spread over the horizontal plane through `origin`, the i-th one
+  // at the yaw of 2 * pi * i / ray_count in the map frame. Returns the distance to the first hit
+  // of every ray, or infinity if the ray hits nothing within `max_distance`.
+  auto raycastHorizontally(
+    const geometry_msgs::msg::Point & origin, std::size_t ray_count, double max_distance)
+    -> const std::vector<float> &;
   const std::vector<std::string> & getDetectedObject() const;
   void setDirection(
     const simulation_api_schema::LidarConfiguration & configuration,
     double horizontal_angle_start = 0, double horizontal_angle_end = 2 * M_PI);
 
 private:
-  std::vector<geometry_msgs::msg::Quaternion> getDirections(
+  // Each primitive keeps its mesh in its own scene, built once in the local frame of the
+  // primitive. The top level scene only refers to it through an instance, so moving the primitive
+  // updates the instance transform instead of rebuilding the mesh.
+  struct Instance
+  {
+    std::unique_ptr<primitives::Primitive> primitive_ptr;
+    RTCScene scene;
+    RTCGeometry geometry;
+    unsigned int geometry_id;
+    bool enabled = true;
+  };
+  void attachInstance(
+    const std::string & name, std::unique_ptr<primitives::Primitive> primitive_ptr);
+  // unit direction vectors of the rays in structure-of-arrays layout
+  struct Directions
+  {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    auto size() const -> std::size_t { return x.size(); }
+    auto resize(std::size_t size) -> void
+    {
+      x.resize(size);
+      y.resize(size);
+      z.resize(size);
+    }
+  };
+  // Tables are shared between every raycaster created with the same configuration.
+  static auto getDirections(
     const std::vector<double> & vertical_angles, double horizontal_angle_start,
-    double horizontal_angle_end, double horizontal_resolution);
-  std::vector<geometry_msgs::msg::Quaternion> directions_;
-  double previous_horizontal_angle_start_;
-  double previous_horizontal_angle_end_;
-  double previous_horizontal_resolution_;
-  std::vector<double> previous_vertical_angles_;
-  std::unordered_map<std::string, std::unique_ptr<primitives::Primitive>> primitive_ptrs_;
+    double horizontal_angle_end, double horizontal_resolution)
+    -> std::shared_ptr<const Directions>;
+  // directions in the sensor frame
+  std::shared_ptr<const Directions> directions_;
+  // directions in the map frame, updated at every scan
+  Directions rotated_directions_;
+  std::unordered_map<std::string, Instance> instances_;
   RTCDevice device_;
   RTCScene scene_;
   std::random_device seed_gen_;
   std::default_random_engine engine_;
   std::vector<std::string> detected_objects_;
   std::unordered_map<unsigned int, std::string> geometry_ids_;
-  std::vector<Eigen::Matrix3d> rotation_matrices_;
 
-  static void intersect(
-    int thread_id, int thread_count, RTCScene scene,
-    pcl::PointCloud<pcl::PointXYZI>::Ptr thread_cloud, geometry_msgs::msg::Pose origin,
-    std::reference_wrapper<std::set<unsigned int>> ref_thread_detected_ids, double max_distance,
-    double min_distance,
-    std::reference_wrapper<const std::vector<Eigen::Matrix3d>> ref_rotation_matrices)
-  {
-    auto & rotation_matrices = ref_rotation_matrices.get();
-    auto & thread_detected_ids = ref_thread_detected_ids.get();
-    const auto orientation_matrix = math::geometry::getRotationMatrix(origin.orientation);
-    for (unsigned int i = thread_id; i < rotation_matrices.size(); i += thread_count) {
-      RTCRayHit rayhit = {};
-      rayhit.ray.org_x = origin.position.x;
-      rayhit.ray.org_y = origin.position.y;
-      rayhit.ray.org_z = origin.position.z;
-      // make raycast interact with all objects
-      rayhit.ray.mask = 0b11111111'11111111'11111111'11111111;
-      rayhit.ray.tfar = max_distance;
-      rayhit.ray.tnear = min_distance;
-      rayhit.ray.flags = false;
+  template <std::size_t PacketSize>
+  auto intersect(
+    std::uint8_t * data, std::size_t begin, std::size_t end,
+    const geometry_msgs::msg::Pose & origin, double max_distance, double min_distance)
+    -> std::size_t;
 
-      const auto rotation_mat = orientation_matrix * rotation_matrices.at(i);
-      rayhit.ray.dir_x = rotation_mat(0);
-      rayhit.ray.dir_y = rotation_mat(1);
-      rayhit.ray.dir_z = rotation_mat(2);
-      rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
-      rtcIntersect1(scene, &rayhit);
+  template <std::size_t PacketSize>
+  auto intersectHorizontally(
+    std::size_t begin, std::size_t end, const geometry_msgs::msg::Point & origin,
+    std::size_t ray_count, double max_distance) -> void;
 
-      if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
-        double distance = rayhit.ray.tfar;
-        pcl::PointXYZI p;
-        {
-          p.x = rotation_matrices.at(i)(0) * distance;
-          p.y = rotation_matrices.at(i)(1) * distance;
-          p.z = rotation_matrices.at(i)(2) * distance;
-        }
-        thread_cloud->emplace_back(p);
-        thread_detected_ids.insert(rayhit.hit.geomID);
-      }
-    }
-  }
+  // number of rays traced by one task of the thread pool
+  static constexpr std::size_t rays_per_task_ = 256;
+  std::shared_ptr<ThreadPool> thread_pool_;
+  std::size_t packet_size_;
+  std::vector<unsigned int> hit_ids_;
+  std::vector<std::size_t> task_hit_counts_;
+  std::unordered_set<unsigned int> detected_ids_;
+  std::vector<float> horizontal_distances_;
+  // instances the scene of the map, which is shared with every other raycaster of the device
+  std::shared_ptr<const PointCloudMap> point_cloud_map_;
+  RTCGeometry point_cloud_map_geometry_ = nullptr;
+  unsigned int point_cloud_map_geometry_id_ = RTC_INVALID_GEOMETRY_ID;
 };
 }  // namespace simple_sensor_simulator
 
@@ -29,12 +29,22 @@ namespace simple_sensor_simulator
 class OccupancyGridBuilder
 {
   using MarkerCounterType = int16_t;
-  using MarkerGridType = std::vector<MarkerCounterType>;
+  using MarkerGridType = std::vector<int32_t>;
   using OccupancyGridType = std::vector<int8_t>;
   using PointType = geometry_msgs::msg::Point;
   using PoseType = geometry_msgs::msg::Pose;
   using PrimitiveType = primitives::Primitive;
-  using PolygonType = std::vector<PointType>;
+
+  /**
+   * @brief Point in grid cells, relative to the center of the grid
+   */
+  struct CellPoint
+  {
+    double x;
+    double y;
+  };
+
+  using PolygonType = std::vector<CellPoint>;
 
 public:
   OccupancyGridBuilder(
@@ -53,6 +63,23 @@ public:
    */
   auto add(const PrimitiveType & primitive) -> void;
 
+  /**
+   * @brief Mark occupied area of primitive only, leaving the visibility to `addVisibleArea`
+   * @param primitive
+   */
+  auto addOccupiedArea(const PrimitiveType & primitive) -> void;
+
+  /**
+   * @brief Mark the area seen by rays cast from the origin of the grid as visible, and the cells
+   * where the rays hit something as occupied
+   * @param distances Distance to the first hit of each ray, or infinity if the ray hits nothing.
+   * The i-th ray points at the angle of 2 * pi * i / distances.size() from the x axis of the grid.
+   * @param max_distance Length of the rays that hit nothing
+   * @note Once a visible area is added, every cell outside of it is invisible and the shadows
+   * marked by `add` have no effect until the next `reset`.
+   */
+  auto addVisibleArea(const std::vector<float> & distances, double max_distance) -> void;
+
   /**
    * @brief Reset all internal state
    * @param origin
@@ -75,22 +102,28 @@ private:
    */
   PoseType origin_;
 
+  /**
+   * @brief Inverse of the rotation of `origin_`
+   */
+  Eigen::Matrix3d inverse_rotation_ = Eigen::Matrix3d::Identity();
+
   /**
    * @brief The number of added primitives
    */
   MarkerCounterType primitive_count_ = 0;
 
   /**
-   * @brief A vector of occupied area
-   * @note This vector is declared as a member to reuse allocated memory
+   * @brief Whether `addVisibleArea` has been called since the last `reset`
    */
-  MarkerGridType occupied_grid_;
+  bool has_visible_area_ = false;
 
   /**
-   * @brief A vector of invisible area
-   * @note This vector is declared as a member to reuse allocated memory
+   * @brief Row-wise differences of the number of occupied areas (upper 16 bits) and invisible
+   * areas, or visible areas if `has_visible_area_`, (lower 16 bits) covering each cell
+   * @note Both counts are never negative once summed up, so a single prefix sum over the packed
+   * values yields both of them. This vector is declared as a member to reuse allocated memory
    */
-  MarkerGridType invisible_grid_;
+  MarkerGridType marker_grid_;
 
   /**
    * @brief A vector of grid values
@@ -99,54 +132,60 @@ private:
   OccupancyGridType values_;
 
   /**
-   * @brief Vectors to hold min or max column of rasterized polygon
+   * @brief Vectors to hold the leftmost and rightmost x coordinates of a polygon in each row
+   * @note These vectors are declared as members to reuse allocated memory
+   */
+  std::vector<double> min_xs_, max_xs_;
+
+  /**
+   * @brief Polygons of the primitive being added
    * @note These vectors are declared as members to reuse allocated memory
    */
-  std::vector<int32_t> min_cols_, max_cols_;
+  PolygonType occupied_area_, invisible_area_, visible_area_, clipping_buffer_;
+
+  /**
+   * @brief Indices of the cells where the rays of `addVisibleArea` hit something
+   * @note This vector is declared as a member to reuse allocated memory
+   */
+  std::vector<size_t> hit_cells_;
 
   /**
-   * @brief Mark grid area of convex hull
-   * @param grid Grid to be marked
-   * @param convex_hull Convex hull to mark
+   * @brief Mark grid cells covered by a convex polygon
+   * @param convex_hull Convex polygon inside of the grid
+   * @param mark Value added to the counters of the covered cells
    */
-  inline auto addPolygon(MarkerGridType & grid, const PolygonType & convex_hull) -> void;
+  auto addPolygon(const PolygonType & convex_hull, int32_t mark) -> void;
 
   /**
-   * @brief Convert point in world coordinate to point in grid coordinate
+   * @brief Convert point in world coordinate to point in grid cells
    * @param world_point
-   * @return Point in grid coordinate
+   * @return Point in grid cells, relative to the center of the grid
    */
-  inline auto transformToGrid(const PointType & world_point) const -> PointType;
+  auto transformToCell(const PointType & world_point) const -> CellPoint;
 
   /**
-   * @brief Rasterize point in grid coordinate
-   * @param grid_point
-   * @return Rasterized point
+   * @brief Clip a convex polygon to the grid area
+   * @param polygon Polygon to be clipped in place
    */
-  inline auto transformToPixel(const PointType & grid_point) const -> PointType;
+  auto clip(PolygonType & polygon) -> void;
 
   /**
-   * @brief Construct a point
-   * @param x
-   * @param y
-   * @param z
-   * @return point
+   * @brief Count a primitive against the capacity of `marker_grid_`
+   * @exception std::runtime_error if the grid already holds as many primitives as it can count
    */
-  inline auto makePoint(double x, double y, double z = 0) const -> PointType;
+  auto countPrimitive() -> void;
 
   /**
-   * @brief Construct a convex hull of the area occupied with primitive
+   * @brief Construct a convex polygon of the area occupied with primitive into `occupied_area_`
    * @param primitive
-   * @return Convex hull polygon
    */
-  inline auto makeOccupiedArea(const PrimitiveType & primitive) const -> PolygonType;
+  auto makeOccupiedArea(const PrimitiveType & primitive) -> void;
 
   /**
-   * @brief Construct a convex hull of the area made invisible by the occupied area
-   * @param occupied_polygon Convex hull of occupied area
-   * @return Convex hull polygon
+   * @brief Construct a convex polygon of the area made invisible by `occupied_area_` into
+   * `invisible_area_`
    */
-  inline auto makeInvisibleArea(const PolygonType & occupied_polygon) const -> PolygonType;
+  auto makeInvisibleArea() -> void;
 };
 }  // namespace simple_sensor_simulator
 
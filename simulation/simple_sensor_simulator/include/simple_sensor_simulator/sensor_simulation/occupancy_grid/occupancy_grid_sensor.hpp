@@ -20,8 +20,14 @@
 #include <memory>
 #include <nav_msgs/msg/occupancy_grid.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_status_view.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
 #include <simple_sensor_simulator/sensor_simulation/occupancy_grid/occupancy_grid_builder.hpp>
+#include <simple_sensor_simulator/sensor_simulation/publish.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace simple_sensor_simulator
@@ -38,6 +44,18 @@ protected:
 
   std::vector<std::string> detected_objects_;
 
+  /**
+   * @brief Scene in which rays are cast to find invisible cells if `ray_traced_occlusion` is set
+   */
+  std::shared_ptr<Raycaster> raycaster_;
+
+  /**
+   * @brief Whether `raycaster_` belongs to a LiDAR attached to the same entity
+   * @note The primitives of entities out of the range of this sensor are then only disabled while
+   * tracing, since the LiDAR still needs them.
+   */
+  bool shares_raycaster_ = false;
+
   explicit OccupancyGridSensorBase(
     const double current_simulation_time,
     const simulation_api_schema::OccupancyGridSensorConfiguration & configuration)
@@ -48,13 +66,44 @@ protected:
 public:
   virtual ~OccupancyGridSensorBase() = default;
 
+  auto getEntity() const -> const std::string & { return configuration_.entity(); }
+
+  /**
+   * @brief Distance beyond which entities cannot affect the occupancy grid
+   * @return distance from the center to the corners of the grid, or the sensor detection range
+   * if `filter_by_range` is set and the range is shorter
+   */
+  auto getRange() const -> double;
+
+  auto getRaycaster() const -> const std::shared_ptr<Raycaster> & { return raycaster_; }
+
+  /**
+   * @brief Set the scene in which rays are cast to find invisible cells
+   * @param shared whether `raycaster` belongs to a LiDAR attached to the same entity
+   */
+  auto setRaycaster(const std::shared_ptr<Raycaster> & raycaster, bool shared) -> void
+  {
+    raycaster_ = raycaster;
+    shares_raycaster_ = shared;
+  }
+
+  /**
+   * @brief Set the pointcloud map traced along with the entities, unless the scene is shared
+   */
+  auto setPointCloudMap(const std::shared_ptr<const PointCloudMap> & point_cloud_map) -> void
+  {
+    if (raycaster_ and not shares_raycaster_) {
+      raycaster_->setPointCloudMap(point_cloud_map);
+    }
+  }
+
   /**
    * @brief Update sensor status
    */
   virtual void update(
-    const double current_simulation_time, const std::vector<traffic_simulator_msgs::EntityStatus> &,
+    const double current_simulation_time, const EntityStatusView &,
     const rclcpp::Time & current_ros_time,
-    const std::vector<std::string> & lidar_detected_entities) = 0;
+    const std::unordered_set<std::string> & lidar_detected_entities) = 0;
 
   /**
    * @brief List all objects in range of sensor sight
@@ -62,8 +111,8 @@ public:
    * @return names of objects in range of sensor sight
    */
   const std::vector<std::string> getDetectedObjects(
-    const std::vector<traffic_simulator_msgs::EntityStatus> & status,
-    const std::vector<std::string> & lidar_detected_entities) const;
+    const EntityStatusView & status,
+    const std::unordered_set<std::string> & lidar_detected_entities) const;
 
   /**
    * @brief Extract sensor pose from entity statuses
@@ -71,8 +120,7 @@ public:
    * @warning `status` must contain EGO object
    * @exception SimulationRuntimeError if `status` does not contain EGO object
    */
-  geometry_msgs::Pose getSensorPose(
-    const std::vector<traffic_simulator_msgs::EntityStatus> &) const;
+  geometry_msgs::Pose getSensorPose(const EntityStatusView &) const;
 };
 
 /**
@@ -83,36 +131,39 @@ class OccupancyGridSensor : public OccupancyGridSensorBase
 {
   const typename rclcpp::Publisher<T>::SharedPtr publisher_ptr_;
 
+  const std::shared_ptr<ThreadPool> publishing_thread_;
+
   /**
    * @brief construct occupancy grid from entity list
    * @return occupancy grid of specified type
    */
   auto getOccupancyGrid(
-    const std::vector<traffic_simulator_msgs::EntityStatus> &, const rclcpp::Time &,
-    const std::vector<std::string> &) -> T;
+    const EntityStatusView &, const rclcpp::Time &, const std::unordered_set<std::string> &) -> T;
 
 public:
   explicit OccupancyGridSensor(
     const double current_simulation_time,
     const simulation_api_schema::OccupancyGridSensorConfiguration & configuration,
-    const typename rclcpp::Publisher<T>::SharedPtr & publisher_ptr)
+    const typename rclcpp::Publisher<T>::SharedPtr & publisher_ptr,
+    const std::shared_ptr<ThreadPool> & publishing_thread = nullptr)
   : OccupancyGridSensorBase(current_simulation_time, configuration),
     publisher_ptr_(publisher_ptr),
+    publishing_thread_(publishing_thread),
     builder_(configuration.resolution(), configuration.height(), configuration.width())
   {
   }
 
   auto update(
-    const double current_simulation_time,
-    const std::vector<traffic_simulator_msgs::EntityStatus> & entities,
-    const rclcpp::Time & current_ros_time, const std::vector<std::string> & lidar_detected_entities)
-    -> void override
+    const double current_simulation_time, const EntityStatusView & entities,
+    const rclcpp::Time & current_ros_time,
+    const std::unordered_set<std::string> & lidar_detected_entities) -> void override
   {
     if (
       current_simulation_time - previous_simulation_time_ - configuration_.update_duration() >=
       -0.002) {
       previous_simulation_time_ = current_simulation_time;
-      publisher_ptr_->publish(
+      publish(
+        publishing_thread_, publisher_ptr_,
         getOccupancyGrid(entities, current_ros_time, lidar_detected_entities));
     } else {
       detected_objects_ = {};
@@ -125,8 +176,9 @@ private:
 
 template <>
 auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & status, const rclcpp::Time & stamp,
-  const std::vector<std::string> & lidar_detected_entities) -> nav_msgs::msg::OccupancyGrid;
+  const EntityStatusView & status, const rclcpp::Time & stamp,
+  const std::unordered_set<std::string> & lidar_detected_entities)
+  -> nav_msgs::msg::OccupancyGrid;
 }  // namespace simple_sensor_simulator
 
 #endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__OCCUPANCY_GRID__OCCUPANCY_GRID_SENSOR_HPP_
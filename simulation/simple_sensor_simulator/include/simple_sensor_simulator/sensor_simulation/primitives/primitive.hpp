@@ -55,6 +55,9 @@ public:
   const std::string type;
   const geometry_msgs::msg::Pose pose;
   unsigned int addToScene(RTCDevice device, RTCScene scene);
+  // Attach the mesh in the local frame of the primitive (pose is not applied), so it can be
+  // referenced by an instance whose transform is updated every frame.
+  unsigned int addLocalGeometryToScene(RTCDevice device, RTCScene scene) const;
   std::vector<Vertex> getVertex() const;
   std::vector<Triangle> getTriangles() const;
   std::vector<geometry_msgs::msg::Point> get2DConvexHull() const;
@@ -74,6 +77,8 @@ protected:
   std::vector<Triangle> triangles_;
 
 private:
+  unsigned int attachMesh(
+    RTCDevice device, RTCScene scene, const std::vector<Vertex> & vertices) const;
   Vertex transform(const Vertex & v) const;
   Vertex transform(const Vertex & v, const geometry_msgs::msg::Pose & sensor_pose) const;
 };
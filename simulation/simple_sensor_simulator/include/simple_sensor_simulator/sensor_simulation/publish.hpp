@@ -0,0 +1,53 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__PUBLISH_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__PUBLISH_HPP_
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <simple_sensor_simulator/thread_pool.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Publish `message` on `publishing_thread`, or on the calling thread if it is null
+ * @note `publishing_thread` is expected to have a single worker, which keeps the messages of every
+ * publisher in the order they were given. Nobody waits for a message published on it, so an error
+ * in publishing is reported there instead of being left in the discarded future.
+ */
+template <typename Publisher, typename Message>
+auto publish(
+  const std::shared_ptr<ThreadPool> & publishing_thread, const Publisher & publisher,
+  Message && message) -> void
+{
+  if (publishing_thread) {
+    publishing_thread->submit(
+      [publisher, message = std::decay_t<Message>(std::forward<Message>(message))]() mutable {
+        try {
+          publisher->publish(std::move(message));
+        } catch (const std::exception & exception) {
+          std::cerr << "failed to publish a sensor message: " << exception.what() << std::endl;
+        }
+      });
+  } else {
+    publisher->publish(std::forward<Message>(message));
+  }
+}
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SENSOR_SIMULATION__PUBLISH_HPP_
@@ -25,10 +25,15 @@
 #include <memory>
 #include <rclcpp/rclcpp.hpp>
 #include <simple_sensor_simulator/sensor_simulation/detection_sensor/detection_sensor.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_grid.hpp>
 #include <simple_sensor_simulator/sensor_simulation/imu/imu_sensor.hpp>
 #include <simple_sensor_simulator/sensor_simulation/lidar/lidar_sensor.hpp>
 #include <simple_sensor_simulator/sensor_simulation/occupancy_grid/occupancy_grid_sensor.hpp>
 #include <simple_sensor_simulator/sensor_simulation/traffic_lights/traffic_lights_detector.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace simple_sensor_simulator
@@ -36,6 +41,16 @@ namespace simple_sensor_simulator
 class SensorSimulation
 {
 public:
+  /**
+   * @param thread_pool shared by every sensor
+   * @param topic_namespace prepended to the topic of every sensor
+   */
+  explicit SensorSimulation(
+    std::shared_ptr<ThreadPool> thread_pool, const std::string & topic_namespace = "")
+  : thread_pool_(std::move(thread_pool)), topic_namespace_(topic_namespace)
+  {
+  }
+
   auto attachLidarSensor(
     const double current_simulation_time,
     const simulation_api_schema::LidarConfiguration & configuration, rclcpp::Node & node) -> void
@@ -44,7 +59,9 @@ public:
       lidar_sensors_.push_back(std::make_unique<LidarSensor<sensor_msgs::msg::PointCloud2>>(
         current_simulation_time, configuration,
         node.create_publisher<sensor_msgs::msg::PointCloud2>(
-          "/perception/obstacle_segmentation/pointcloud", 1)));
+          getTopic(configuration.entity(), "/perception/obstacle_segmentation/pointcloud"), 1),
+        thread_pool_, publishing_thread_, getFrameId(configuration.entity(), "base_link")));
+      lidar_sensors_.back()->setPointCloudMap(point_cloud_map_);
     } else {
       std::stringstream ss;
       ss << "Unexpected architecture_type " << std::quoted(configuration.architecture_type())
@@ -63,9 +80,13 @@ public:
       using GroundTruthMessage = autoware_auto_perception_msgs::msg::TrackedObjects;
       detection_sensors_.push_back(std::make_unique<DetectionSensor<Message>>(
         current_simulation_time, configuration,
-        node.create_publisher<Message>("/perception/object_recognition/detection/objects", 1),
+        node.create_publisher<Message>(
+          getTopic(configuration.entity(), "/perception/object_recognition/detection/objects"), 1),
         node.create_publisher<GroundTruthMessage>(
-          "/perception/object_recognition/ground_truth/objects", 1)));
+          getTopic(
+            configuration.entity(), "/perception/object_recognition/ground_truth/objects"),
+          1),
+        publishing_thread_));
     } else {
       std::stringstream ss;
       ss << "Unexpected architecture_type " << std::quoted(configuration.architecture_type())
@@ -83,7 +104,12 @@ public:
       using Message = nav_msgs::msg::OccupancyGrid;
       occupancy_grid_sensors_.push_back(std::make_unique<OccupancyGridSensor<Message>>(
         current_simulation_time, configuration,
-        node.create_publisher<Message>("/perception/occupancy_grid_map/map", 1)));
+        node.create_publisher<Message>(
+          getTopic(configuration.entity(), "/perception/occupancy_grid_map/map"), 1),
+        publishing_thread_));
+      if (configuration.ray_traced_occlusion()) {
+        setRaycaster(*occupancy_grid_sensors_.back());
+      }
     } else {
       std::stringstream ss;
       ss << "Unexpected architecture_type " << std::quoted(configuration.architecture_type())
@@ -101,12 +127,14 @@ public:
       using Message = autoware_auto_perception_msgs::msg::TrafficSignalArray;
       traffic_lights_detectors_.push_back(std::make_unique<traffic_lights::TrafficLightsDetector>(
         std::make_shared<traffic_simulator::TrafficLightPublisher<Message>>(
-          "/perception/traffic_light_recognition/traffic_signals", &node, hdmap_utils)));
+          topic_namespace_ + "/perception/traffic_light_recognition/traffic_signals", &node,
+          hdmap_utils)));
     } else if (configuration.architecture_type() >= "awf/universe/20230906") {
       using Message = autoware_perception_msgs::msg::TrafficSignalArray;
       traffic_lights_detectors_.push_back(std::make_unique<traffic_lights::TrafficLightsDetector>(
         std::make_shared<traffic_simulator::TrafficLightPublisher<Message>>(
-          "/perception/traffic_light_recognition/internal/traffic_signals", &node, hdmap_utils)));
+          topic_namespace_ + "/perception/traffic_light_recognition/internal/traffic_signals",
+          &node, hdmap_utils)));
     } else {
       std::stringstream ss;
       ss << "Unexpected architecture_type " << std::quoted(configuration.architecture_type())
@@ -121,15 +149,78 @@ public:
     -> void
   {
     imu_sensors_.push_back(std::make_unique<ImuSensor<sensor_msgs::msg::Imu>>(
-      configuration, node.create_publisher<sensor_msgs::msg::Imu>("/sensing/imu/imu_data", 1)));
+      configuration,
+      node.create_publisher<sensor_msgs::msg::Imu>(
+        getTopic(configuration.entity(), "/sensing/imu/imu_data"), 1)));
   }
 
+  /**
+   * @brief Give the ego `entity` a namespace of its own, under which the sensors attached to it
+   * afterwards publish
+   * @return the namespace of this simulation followed by that of the ego, which is the same every
+   * time an ego of that name is added: empty for the first ego, which keeps the usual topics, and
+   * `/<entity>` for any other, with every character not allowed in a topic replaced by `_`
+   * @exception SimulationRuntimeError if the namespace is that of another ego
+   */
+  auto addEgo(const std::string & entity) -> std::string;
+
+  /**
+   * @brief `frame_id` of `entity`, prefixed by the namespace of this simulation and that of the
+   * entity, if any
+   */
+  auto getFrameId(const std::string & entity, const std::string & frame_id) const -> std::string;
+
+  /**
+   * @brief Detach every sensor with its scene, and forget the namespaces of the egos, as for a
+   * new scenario
+   * @note Messages already produced are still published.
+   */
+  auto clear() -> void;
+
+  auto setPointCloudMap(const std::shared_ptr<const PointCloudMap> & point_cloud_map) -> void
+  {
+    point_cloud_map_ = point_cloud_map;
+    for (auto & sensor : lidar_sensors_) {
+      sensor->setPointCloudMap(point_cloud_map_);
+    }
+    for (auto & sensor : occupancy_grid_sensors_) {
+      sensor->setPointCloudMap(point_cloud_map_);
+    }
+  }
+
+  /**
+   * @brief Update every sensor with the entities in its range
+   * @param entity_grid positions of all `entities`, used to hand each sensor only the entities that
+   * can be seen from the entity it is attached to
+   */
   auto updateSensorFrame(
     double current_simulation_time, const rclcpp::Time & current_ros_time,
     const std::vector<traffic_simulator_msgs::EntityStatus> &,
-    const simulation_api_schema::UpdateTrafficLightsRequest &) -> void;
+    const simulation_api_schema::UpdateTrafficLightsRequest &, const EntityGrid & entity_grid)
+    -> void;
 
 private:
+  auto getTopic(const std::string & entity, const std::string & topic) const -> std::string
+  {
+    const auto iter = entity_topic_namespaces_.find(entity);
+    return topic_namespace_ + (iter != entity_topic_namespaces_.end() ? iter->second : "") + topic;
+  }
+
+  /**
+   * @brief Give an occupancy grid sensor the scene of a LiDAR attached to the same entity, or a
+   * scene of its own if there is no such LiDAR
+   * @note A scene is shared with one occupancy grid sensor at most, since the occupancy grid
+   * sensors are updated concurrently.
+   */
+  auto setRaycaster(OccupancyGridSensorBase & occupancy_grid_sensor) -> void;
+
+  const std::shared_ptr<ThreadPool> thread_pool_;
+  const std::string topic_namespace_;
+  // of every ego ever added, kept after it is despawned so that it is the same if respawned
+  std::unordered_map<std::string, std::string> entity_topic_namespaces_;
+  // A single thread publishes the messages of every sensor, in the order they were produced.
+  const std::shared_ptr<ThreadPool> publishing_thread_ = std::make_shared<ThreadPool>(1);
+  std::shared_ptr<const PointCloudMap> point_cloud_map_;
   std::vector<std::unique_ptr<ImuSensorBase>> imu_sensors_;
   std::vector<std::unique_ptr<LidarSensorBase>> lidar_sensors_;
   std::vector<std::unique_ptr<DetectionSensorBase>> detection_sensors_;
@@ -15,25 +15,12 @@
 #ifndef SIMPLE_SENSOR_SIMULATOR__SIMPLE_SENSOR_SIMULATOR_HPP_
 #define SIMPLE_SENSOR_SIMULATOR__SIMPLE_SENSOR_SIMULATOR_HPP_
 
-#include <tf2/LinearMath/Quaternion.h>
-#include <tf2_ros/transform_broadcaster.h>
-
-#include <geographic_msgs/msg/geo_point.hpp>
-#include <geometry_msgs/msg/pose_stamped.hpp>
-#include <geometry_msgs/msg/transform_stamped.hpp>
-#include <map>
+#include <cstdint>
 #include <memory>
 #include <rclcpp/rclcpp.hpp>
-#include <simple_sensor_simulator/sensor_simulation/lidar/lidar_sensor.hpp>
-#include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
-#include <simple_sensor_simulator/sensor_simulation/sensor_simulation.hpp>
-#include <simple_sensor_simulator/vehicle_simulation/ego_entity_simulation.hpp>
+#include <simple_sensor_simulator/simulation_session.hpp>
 #include <simulation_interface/zmq_multi_server.hpp>
-#include <string>
-#include <thread>
-#include <traffic_simulator/hdmap_utils/hdmap_utils.hpp>
-#include <vector>
-#include <visualization_msgs/msg/marker_array.hpp>
+#include <unordered_map>
 
 #if __cplusplus
 extern "C" {
@@ -80,6 +67,12 @@ extern "C" {
 
 namespace simple_sensor_simulator
 {
+/**
+ * @brief Node serving the sessions of the simulator
+ * @note Each session runs a scenario of its own, for the client that sends the ID of the session
+ * with its requests. Requests of all sessions are handled one at a time. A session lives from the
+ * first request of its ID until its FinalizeRequest.
+ */
 class ScenarioSimulator : public rclcpp::Node
 {
 public:
@@ -88,78 +81,25 @@ public:
   ~ScenarioSimulator();
 
 private:
-  SensorSimulation sensor_sim_;
-
-  auto initialize(const simulation_api_schema::InitializeRequest &)
-    -> simulation_api_schema::InitializeResponse;
-
-  auto updateFrame(const simulation_api_schema::UpdateFrameRequest &)
-    -> simulation_api_schema::UpdateFrameResponse;
-
-  auto updateStepTime(const simulation_api_schema::UpdateStepTimeRequest &)
-    -> simulation_api_schema::UpdateStepTimeResponse;
-
-  auto updateEntityStatus(const simulation_api_schema::UpdateEntityStatusRequest &)
-    -> simulation_api_schema::UpdateEntityStatusResponse;
-
-  auto spawnVehicleEntity(const simulation_api_schema::SpawnVehicleEntityRequest &)
-    -> simulation_api_schema::SpawnVehicleEntityResponse;
-
-  template <typename SpawnRequestType>
-  auto insertEntitySpawnedStatus(
-    const SpawnRequestType & spawn_request, const traffic_simulator_msgs::EntityType::Enum & type,
-    const traffic_simulator_msgs::EntitySubtype::Enum & subtype) -> void;
-
-  auto spawnPedestrianEntity(const simulation_api_schema::SpawnPedestrianEntityRequest &)
-    -> simulation_api_schema::SpawnPedestrianEntityResponse;
-
-  auto spawnMiscObjectEntity(const simulation_api_schema::SpawnMiscObjectEntityRequest &)
-    -> simulation_api_schema::SpawnMiscObjectEntityResponse;
+  /**
+   * @brief Get the session of `id`, creating it on the first request of its client
+   */
+  auto getSession(std::uint32_t id) -> SimulationSession &;
+
+  /**
+   * @brief End the session of `id`, releasing its sensors, egos and maps
+   * @note A later request of that ID starts a new session.
+   */
+  auto finalizeSession(std::uint32_t id, const simulation_api_schema::FinalizeRequest &)
+    -> simulation_api_schema::FinalizeResponse;
 
-  auto despawnEntity(const simulation_api_schema::DespawnEntityRequest &)
-    -> simulation_api_schema::DespawnEntityResponse;
-
-  auto attachImuSensor(const simulation_api_schema::AttachImuSensorRequest &)
-    -> simulation_api_schema::AttachImuSensorResponse;
-
-  auto attachDetectionSensor(const simulation_api_schema::AttachDetectionSensorRequest &)
-    -> simulation_api_schema::AttachDetectionSensorResponse;
-
-  auto attachLidarSensor(const simulation_api_schema::AttachLidarSensorRequest &)
-    -> simulation_api_schema::AttachLidarSensorResponse;
-
-  auto attachOccupancyGridSensor(const simulation_api_schema::AttachOccupancyGridSensorRequest &)
-    -> simulation_api_schema::AttachOccupancyGridSensorResponse;
-
-  auto updateTrafficLights(const simulation_api_schema::UpdateTrafficLightsRequest &)
-    -> simulation_api_schema::UpdateTrafficLightsResponse;
+  int getSocketPort();
 
-  auto attachPseudoTrafficLightDetector(
-    const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest &)
-    -> simulation_api_schema::AttachPseudoTrafficLightDetectorResponse;
+  SharedResources shared_resources_;
 
-  int getSocketPort();
+  std::unordered_map<std::uint32_t, std::unique_ptr<SimulationSession>> sessions_;
 
-  std::vector<traffic_simulator_msgs::VehicleParameters> ego_vehicles_;
-  std::vector<traffic_simulator_msgs::VehicleParameters> vehicles_;
-  std::vector<traffic_simulator_msgs::PedestrianParameters> pedestrians_;
-  std::vector<traffic_simulator_msgs::MiscObjectParameters> misc_objects_;
-  double realtime_factor_;
-  double step_time_;
-  double current_simulation_time_;
-  double current_scenario_time_;
-  rclcpp::Time current_ros_time_;
-  bool initialized_;
-  std::map<std::string, simulation_api_schema::EntityStatus> entity_status_;
-  simulation_api_schema::UpdateTrafficLightsRequest traffic_signals_states_;
-  traffic_simulator_msgs::BoundingBox getBoundingBox(const std::string & name);
   zeromq::MultiServer server_;
-  geographic_msgs::msg::GeoPoint getOrigin();
-  std::shared_ptr<hdmap_utils::HdMapUtils> hdmap_utils_;
-  std::shared_ptr<vehicle_simulation::EgoEntitySimulation> ego_entity_simulation_;
-
-  bool isEgo(const std::string & name);
-  bool isEntityExists(const std::string & name);
 };
 }  // namespace simple_sensor_simulator
 
@@ -0,0 +1,201 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMPLE_SENSOR_SIMULATOR__SIMULATION_SESSION_HPP_
+#define SIMPLE_SENSOR_SIMULATOR__SIMULATION_SESSION_HPP_
+
+#include <simulation_api_schema.pb.h>
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <geographic_msgs/msg/geo_point.hpp>
+#include <map>
+#include <memory>
+#include <rclcpp/rclcpp.hpp>
+#include <simple_sensor_simulator/sensor_simulation/entity_grid.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
+#include <simple_sensor_simulator/sensor_simulation/sensor_simulation.hpp>
+#include <simple_sensor_simulator/thread_pool.hpp>
+#include <simple_sensor_simulator/vehicle_simulation/ego_entity_simulation.hpp>
+#include <string>
+#include <traffic_simulator/hdmap_utils/hdmap_utils.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+/**
+ * @brief Read-only data shared by every session of the simulator
+ * @note Maps are cached while a session holds them, so the sessions of a batch run on the same
+ * map load it once. A pointcloud map keeps its scene too, which every raycaster then instances.
+ */
+class SharedResources
+{
+public:
+  auto getHdMapUtils(
+    const std::string & lanelet2_map_path, const geographic_msgs::msg::GeoPoint & origin)
+    -> std::shared_ptr<hdmap_utils::HdMapUtils>;
+
+  auto getPointCloudMap(const std::string & pcd_path, float voxel_size)
+    -> std::shared_ptr<const PointCloudMap>;
+
+  // Sensors and egos of every session are simulated on this pool.
+  const std::shared_ptr<ThreadPool> thread_pool = std::make_shared<ThreadPool>();
+
+private:
+  std::map<std::string, std::weak_ptr<hdmap_utils::HdMapUtils>> hdmap_utils_;
+
+  std::map<std::pair<std::string, float>, std::weak_ptr<const PointCloudMap>> point_cloud_maps_;
+};
+
+/**
+ * @brief State of one scenario run by the simulator, and the handlers of its requests
+ * @note A scenario may have any number of egos, each simulated with a vehicle model of its own.
+ * The egos and sensors of session 0 use the usual topics and frames, and those of any other
+ * session use the same topics under `/session_<ID>`, and the same frames under `session_<ID>/`.
+ */
+class SimulationSession
+{
+public:
+  explicit SimulationSession(
+    rclcpp::Node & node, std::uint32_t id, SharedResources & shared_resources);
+
+  ~SimulationSession();
+
+  auto initialize(const simulation_api_schema::InitializeRequest &)
+    -> simulation_api_schema::InitializeResponse;
+
+  /**
+   * @brief Wait for the sensors to finish the last frame, before the session is destroyed
+   * @note Reports the error of the sensors in that frame, if any, as a failure.
+   */
+  auto finalize(const simulation_api_schema::FinalizeRequest &)
+    -> simulation_api_schema::FinalizeResponse;
+
+  auto updateFrame(const simulation_api_schema::UpdateFrameRequest &)
+    -> simulation_api_schema::UpdateFrameResponse;
+
+  auto updateStepTime(const simulation_api_schema::UpdateStepTimeRequest &)
+    -> simulation_api_schema::UpdateStepTimeResponse;
+
+  auto updateEntityStatus(const simulation_api_schema::UpdateEntityStatusRequest &)
+    -> simulation_api_schema::UpdateEntityStatusResponse;
+
+  auto spawnVehicleEntity(const simulation_api_schema::SpawnVehicleEntityRequest &)
+    -> simulation_api_schema::SpawnVehicleEntityResponse;
+
+  auto spawnPedestrianEntity(const simulation_api_schema::SpawnPedestrianEntityRequest &)
+    -> simulation_api_schema::SpawnPedestrianEntityResponse;
+
+  auto spawnMiscObjectEntity(const simulation_api_schema::SpawnMiscObjectEntityRequest &)
+    -> simulation_api_schema::SpawnMiscObjectEntityResponse;
+
+  auto despawnEntity(const simulation_api_schema::DespawnEntityRequest &)
+    -> simulation_api_schema::DespawnEntityResponse;
+
+  auto attachImuSensor(const simulation_api_schema::AttachImuSensorRequest &)
+    -> simulation_api_schema::AttachImuSensorResponse;
+
+  auto attachDetectionSensor(const simulation_api_schema::AttachDetectionSensorRequest &)
+    -> simulation_api_schema::AttachDetectionSensorResponse;
+
+  auto attachLidarSensor(const simulation_api_schema::AttachLidarSensorRequest &)
+    -> simulation_api_schema::AttachLidarSensorResponse;
+
+  auto attachOccupancyGridSensor(const simulation_api_schema::AttachOccupancyGridSensorRequest &)
+    -> simulation_api_schema::AttachOccupancyGridSensorResponse;
+
+  auto updateTrafficLights(const simulation_api_schema::UpdateTrafficLightsRequest &)
+    -> simulation_api_schema::UpdateTrafficLightsResponse;
+
+  auto attachPseudoTrafficLightDetector(
+    const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest &)
+    -> simulation_api_schema::AttachPseudoTrafficLightDetectorResponse;
+
+private:
+  template <typename SpawnRequestType>
+  auto insertEntitySpawnedStatus(
+    const SpawnRequestType & spawn_request, const traffic_simulator_msgs::EntityType::Enum & type,
+    const traffic_simulator_msgs::EntitySubtype::Enum & subtype) -> std::uint32_t;
+
+  geographic_msgs::msg::GeoPoint getOrigin();
+
+  // gives the parameters and creates the publishers of the session
+  rclcpp::Node & node_;
+
+  SharedResources & shared_resources_;
+
+  SensorSimulation sensor_sim_;
+
+  std::vector<traffic_simulator_msgs::VehicleParameters> ego_vehicles_;
+  std::vector<traffic_simulator_msgs::VehicleParameters> vehicles_;
+  std::vector<traffic_simulator_msgs::PedestrianParameters> pedestrians_;
+  std::vector<traffic_simulator_msgs::MiscObjectParameters> misc_objects_;
+  double realtime_factor_;
+  double step_time_;
+  double current_simulation_time_;
+  double current_scenario_time_;
+  rclcpp::Time current_ros_time_;
+  bool initialized_ = false;
+  // the status of every entity with its static fields, copied as is into each sensor frame
+  std::map<std::string, traffic_simulator_msgs::EntityStatus> entity_status_;
+  // entities by the handle given when they were spawned, 0 being no entity
+  std::unordered_map<std::uint32_t, traffic_simulator_msgs::EntityStatus *> entity_handles_;
+  // the handle of every entity by its name, for despawning
+  std::unordered_map<std::string, std::uint32_t> entity_handle_by_name_;
+  std::uint32_t next_entity_handle_ = 1;
+  EntityGrid entity_grid_;
+
+  /**
+   * @brief Everything the sensors read in one frame, captured so that they can run after
+   * `updateFrame` has replied
+   * @note With synchronous sensor updates, only the statuses are gathered here, since the sensors
+   * need them in a vector. The rest is read in place.
+   */
+  struct SensorFrame
+  {
+    double simulation_time;
+    rclcpp::Time ros_time;
+    std::vector<traffic_simulator_msgs::EntityStatus> entity_status;
+    simulation_api_schema::UpdateTrafficLightsRequest traffic_signals_states;
+    EntityGrid entity_grid;
+  };
+  /*
+     With asynchronous sensor updates, the next frame is captured into one buffer while the
+     sensors still work on the other one. At most one frame is in flight, and frames are handed to
+     the sensors strictly in order, so the output is the same as with synchronous updates.
+  */
+  bool asynchronous_sensor_update_ = false;
+  std::array<SensorFrame, 2> sensor_frames_;
+  std::size_t sensor_frame_index_ = 0;
+  std::future<void> sensor_frame_future_;
+  ThreadPool sensor_thread_{1};
+  /**
+   * @brief Wait until the sensors have finished the frame in flight
+   * @note Rethrows the exception thrown by the sensors, if any.
+   */
+  auto waitForSensorFrame() -> void;
+  simulation_api_schema::UpdateTrafficLightsRequest traffic_signals_states_;
+  std::shared_ptr<hdmap_utils::HdMapUtils> hdmap_utils_;
+  std::unordered_map<std::string, std::shared_ptr<vehicle_simulation::EgoEntitySimulation>>
+    ego_entity_simulations_;
+
+  bool isEgo(const std::string & name);
+  bool isEntityExists(const std::string & name);
+};
+}  // namespace simple_sensor_simulator
+
+#endif  // SIMPLE_SENSOR_SIMULATOR__SIMULATION_SESSION_HPP_
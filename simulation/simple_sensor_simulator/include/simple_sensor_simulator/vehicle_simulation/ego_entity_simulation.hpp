@@ -18,6 +18,7 @@
 #include <concealer/autoware.hpp>
 #include <memory>
 #include <simple_sensor_simulator/vehicle_simulation/vehicle_model/sim_model.hpp>
+#include <string>
 #include <traffic_simulator/data_type/entity_status.hpp>
 #include <traffic_simulator/data_type/lanelet_pose.hpp>
 #include <traffic_simulator/hdmap_utils/hdmap_utils.hpp>
@@ -85,11 +86,16 @@ private:
 public:
   auto setAutowareStatus() -> void;
 
+  /**
+   * @param topic_namespace prepended to the topics exchanged with the Autoware driving this ego
+   * @param base_link_frame_id frame of this ego, broadcast relative to `map`
+   */
   explicit EgoEntitySimulation(
     const traffic_simulator_msgs::msg::EntityStatus &,
     const traffic_simulator_msgs::msg::VehicleParameters &, double,
     const std::shared_ptr<hdmap_utils::HdMapUtils> &, const rclcpp::Parameter & use_sim_time,
-    const bool consider_acceleration_by_road_slope);
+    const bool consider_acceleration_by_road_slope, const std::string & topic_namespace = "",
+    const std::string & base_link_frame_id = "base_link");
 
   auto overwrite(
     const traffic_simulator_msgs::msg::EntityStatus & status, const double current_time,
@@ -22,11 +22,13 @@
 #include <geometry/quaternion/get_rotation_matrix.hpp>
 #include <geometry/vector3/hypot.hpp>
 #include <memory>
-#include <random>
 #include <simple_sensor_simulator/exception.hpp>
 #include <simple_sensor_simulator/sensor_simulation/detection_sensor/detection_sensor.hpp>
+#include <simple_sensor_simulator/sensor_simulation/publish.hpp>
 #include <simulation_interface/conversions.hpp>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace simple_sensor_simulator
@@ -47,8 +49,7 @@ auto DetectionSensorBase::isEgoEntityStatusToWhichThisSensorIsAttached(
 }
 
 auto DetectionSensorBase::findEgoEntityStatusToWhichThisSensorIsAttached(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & statuses) const
-  -> std::vector<traffic_simulator_msgs::EntityStatus>::const_iterator
+  const EntityStatusView & statuses) const -> EntityStatusView::const_iterator
 {
   if (auto iter = std::find_if(
         statuses.begin(), statuses.end(),
@@ -217,105 +218,21 @@ auto make(
   return tracked_object;
 };
 
-struct DefaultNoiseApplicator
-{
-  const double current_simulation_time;
-
-  const rclcpp::Time & current_ros_time;
-
-  const traffic_simulator_msgs::EntityStatus & ego_entity_status;
-
-  std::default_random_engine & random_engine;
-
-  const simulation_api_schema::DetectionSensorConfiguration & detection_sensor_configuration;
-
-  explicit DefaultNoiseApplicator(
-    double current_simulation_time, const rclcpp::Time & current_ros_time,
-    const traffic_simulator_msgs::EntityStatus & ego_entity_status,
-    std::default_random_engine & random_engine,
-    const simulation_api_schema::DetectionSensorConfiguration & detection_sensor_configuration)
-  : current_simulation_time(current_simulation_time),
-    current_ros_time(current_ros_time),
-    ego_entity_status(ego_entity_status),
-    random_engine(random_engine),
-    detection_sensor_configuration(detection_sensor_configuration)
-  {
-  }
-
-  DefaultNoiseApplicator(const DefaultNoiseApplicator &) = delete;
-
-  DefaultNoiseApplicator(DefaultNoiseApplicator &&) = delete;
-
-  auto operator=(const DefaultNoiseApplicator &) = delete;
-
-  auto operator=(DefaultNoiseApplicator &&) = delete;
-
-  auto operator()(autoware_auto_perception_msgs::msg::DetectedObjects detected_objects)
-    -> decltype(auto)
-  {
-    auto position_noise_distribution =
-      std::normal_distribution<>(0.0, detection_sensor_configuration.pos_noise_stddev());
-
-    for (auto && detected_object : detected_objects.objects) {
-      detected_object.kinematics.pose_with_covariance.pose.position.x +=
-        position_noise_distribution(random_engine);
-      detected_object.kinematics.pose_with_covariance.pose.position.y +=
-        position_noise_distribution(random_engine);
-    }
-
-    detected_objects.objects.erase(
-      std::remove_if(
-        detected_objects.objects.begin(), detected_objects.objects.end(),
-        [this](auto &&) {
-          return std::uniform_real_distribution()(random_engine) <
-                 detection_sensor_configuration.probability_of_lost();
-        }),
-      detected_objects.objects.end());
-
-    return detected_objects;
-  }
-};
-
-struct CustomNoiseApplicator : public DefaultNoiseApplicator
-{
-  using DefaultNoiseApplicator::DefaultNoiseApplicator;
-
-  /*
-     NOTE: for Autoware developers
-
-     If you need to apply experimental noise to the DetectedObjects that the
-     simulator publishes, comment out the following member functions and
-     implement them.
-
-     See class DefaultNoiseApplicator for the default noise implementation.
-     This class inherits from DefaultNoiseApplicator, so you can use its data
-     members, or you can explicitly call DefaultNoiseApplicator::operator().
-  */
-  // auto operator()(autoware_auto_perception_msgs::msg::DetectedObjects detected_objects)
-  //   -> decltype(auto)
-  // {
-  //   return detected_objects;
-  // }
-};
-
 template <>
 auto DetectionSensor<autoware_auto_perception_msgs::msg::DetectedObjects>::update(
-  const double current_simulation_time,
-  const std::vector<traffic_simulator_msgs::EntityStatus> & statuses,
-  const rclcpp::Time & current_ros_time, const std::vector<std::string> & lidar_detected_entities)
-  -> void
+  const double current_simulation_time, const EntityStatusView & statuses,
+  const rclcpp::Time & current_ros_time,
+  const std::unordered_set<std::string> & lidar_detected_entities) -> void
 {
   if (
     current_simulation_time - previous_simulation_time_ - configuration_.update_duration() >=
     -0.002) {
     previous_simulation_time_ = current_simulation_time;
 
-    autoware_auto_perception_msgs::msg::DetectedObjects detected_objects;
-    detected_objects.header.stamp = current_ros_time;
-    detected_objects.header.frame_id = "map";
-
-    autoware_auto_perception_msgs::msg::TrackedObjects ground_truth_objects;
-    ground_truth_objects.header = detected_objects.header;
+    auto frame = acquireFrame();
+    frame->detected_objects.header.stamp = current_ros_time;
+    frame->detected_objects.header.frame_id = "map";
+    frame->ground_truth_objects.header = frame->detected_objects.header;
 
     const auto ego_entity_status = findEgoEntityStatusToWhichThisSensorIsAttached(statuses);
 
@@ -323,37 +240,90 @@ auto DetectionSensor<autoware_auto_perception_msgs::msg::DetectedObjects>::updat
       return not isEgoEntityStatusToWhichThisSensorIsAttached(status) and
              distance(status.pose(), ego_entity_status->pose()) <= configuration_.range() and
              (configuration_.detect_all_objects_in_range() or
-              std::find(
-                lidar_detected_entities.begin(), lidar_detected_entities.end(), status.name()) !=
-                lidar_detected_entities.end());
+              lidar_detected_entities.count(status.name()) != 0);
+    };
+
+    auto is_up_to_date = [](const auto & cache, const auto & status) {
+      const auto & center = cache.bounding_box.center();
+      const auto & dimensions = cache.bounding_box.dimensions();
+      return cache.subtype == status.subtype().value() and
+             center.x() == status.bounding_box().center().x() and
+             center.y() == status.bounding_box().center().y() and
+             center.z() == status.bounding_box().center().z() and
+             dimensions.x() == status.bounding_box().dimensions().x() and
+             dimensions.y() == status.bounding_box().dimensions().y() and
+             dimensions.z() == status.bounding_box().dimensions().z();
     };
 
+    auto & detected_objects = frame->detected_objects.objects;
+    auto & ground_truth_objects = frame->ground_truth_objects.objects;
+    std::size_t size = 0;
+
     for (const auto & status : statuses) {
       if (is_in_range(status)) {
-        const auto detected_object =
-          make<autoware_auto_perception_msgs::msg::DetectedObject>(status);
-        detected_objects.objects.push_back(detected_object);
-        ground_truth_objects.objects.push_back(
-          make<autoware_auto_perception_msgs::msg::TrackedObject>(status, detected_object));
+        auto cache = templates_.find(status.name());
+        if (cache == templates_.end() or not is_up_to_date(cache->second, status)) {
+          auto detection_template = DetectionTemplate();
+          detection_template.bounding_box = status.bounding_box();
+          detection_template.subtype = status.subtype().value();
+          detection_template.entity = hashEntityName(status.name());
+          detection_template.detected_object =
+            make<autoware_auto_perception_msgs::msg::DetectedObject>(status);
+          detection_template.ground_truth_object =
+            make<autoware_auto_perception_msgs::msg::TrackedObject>(
+              status, detection_template.detected_object);
+          cache = templates_.insert_or_assign(status.name(), std::move(detection_template)).first;
+        }
+
+        // copy-assign into the objects left in the reused frame, so their buffers are reused too
+        if (size < detected_objects.size()) {
+          detected_objects[size] = cache->second.detected_object;
+          ground_truth_objects[size] = cache->second.ground_truth_object;
+          frame->entities[size] = cache->second.entity;
+        } else {
+          detected_objects.push_back(cache->second.detected_object);
+          ground_truth_objects.push_back(cache->second.ground_truth_object);
+          frame->entities.push_back(cache->second.entity);
+        }
+
+        const auto pose = make<geometry_msgs::msg::Pose>(status);
+        const auto twist = make<geometry_msgs::msg::Twist>(status);
+        detected_objects[size].kinematics.pose_with_covariance.pose = pose;
+        detected_objects[size].kinematics.twist_with_covariance.twist = twist;
+        ground_truth_objects[size].kinematics.pose_with_covariance.pose = pose;
+        ground_truth_objects[size].kinematics.twist_with_covariance.twist = twist;
+        ++size;
       }
     }
 
-    if (detected_objects_queue.emplace(detected_objects, current_simulation_time);
-        current_simulation_time - detected_objects_queue.front().second >=
-        configuration_.object_recognition_delay()) {
-      auto apply_noise = CustomNoiseApplicator(
-        current_simulation_time, current_ros_time, *ego_entity_status, random_engine_,
-        configuration_);
-      detected_objects_publisher->publish(apply_noise(detected_objects_queue.front().first));
-      detected_objects_queue.pop();
+    detected_objects.resize(size);
+    ground_truth_objects.resize(size);
+    frame->entities.resize(size);
+
+    frames_.push(current_simulation_time, std::move(frame));
+
+    if (const auto entry =
+          frames_.find(current_simulation_time, configuration_.object_recognition_delay());
+        entry and detected_objects_time_ < entry->time) {
+      detected_objects_time_ = entry->time;
+      auto noisy_objects = entry->value->detected_objects;
+      noise_models_(
+        noisy_objects, entry->value->entities, make<geometry_msgs::msg::Pose>(*ego_entity_status));
+      publish(publishing_thread_, detected_objects_publisher, std::move(noisy_objects));
     }
 
-    if (ground_truth_objects_queue.emplace(ground_truth_objects, current_simulation_time);
-        current_simulation_time - ground_truth_objects_queue.front().second >=
-        configuration_.object_recognition_ground_truth_delay()) {
-      ground_truth_objects_publisher->publish(ground_truth_objects_queue.front().first);
-      ground_truth_objects_queue.pop();
+    if (const auto entry = frames_.find(
+          current_simulation_time, configuration_.object_recognition_ground_truth_delay());
+        entry and ground_truth_objects_time_ < entry->time) {
+      ground_truth_objects_time_ = entry->time;
+      publish(
+        publishing_thread_, ground_truth_objects_publisher, entry->value->ground_truth_objects);
     }
+
+    frames_.prune(
+      current_simulation_time, std::max(
+                                 configuration_.object_recognition_delay(),
+                                 configuration_.object_recognition_ground_truth_delay()));
   }
 }
 }  // namespace simple_sensor_simulator
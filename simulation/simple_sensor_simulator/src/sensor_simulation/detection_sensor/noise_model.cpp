@@ -0,0 +1,213 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <simple_sensor_simulator/sensor_simulation/detection_sensor/noise_model.hpp>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+auto NoiseTarget::resize(std::size_t size) -> void
+{
+  entities.resize(size);
+  x.resize(size);
+  y.resize(size);
+  yaw_offset.resize(size);
+  length.resize(size);
+  width.resize(size);
+  lost.resize(size);
+}
+
+auto NoiseTarget::read(
+  const autoware_auto_perception_msgs::msg::DetectedObjects & detected_objects,
+  const std::vector<std::uint64_t> & object_entities) -> void
+{
+  resize(detected_objects.objects.size());
+  for (std::size_t i = 0; i < size(); ++i) {
+    const auto & object = detected_objects.objects[i];
+    entities[i] = object_entities[i];
+    x[i] = object.kinematics.pose_with_covariance.pose.position.x;
+    y[i] = object.kinematics.pose_with_covariance.pose.position.y;
+    yaw_offset[i] = 0;
+    length[i] = object.shape.dimensions.x;
+    width[i] = object.shape.dimensions.y;
+    lost[i] = false;
+  }
+}
+
+auto NoiseTarget::write(
+  autoware_auto_perception_msgs::msg::DetectedObjects & detected_objects) const -> void
+{
+  const auto detected_size = detected_objects.objects.size();
+
+  for (std::size_t i = 0; i < detected_size; ++i) {
+    auto & object = detected_objects.objects[i];
+    auto & pose = object.kinematics.pose_with_covariance.pose;
+    pose.position.x = x[i];
+    pose.position.y = y[i];
+    if (yaw_offset[i] != 0) {
+      // rotate about the z axis of the map frame
+      const auto c = std::cos(yaw_offset[i] / 2), s = std::sin(yaw_offset[i] / 2);
+      const auto q = pose.orientation;
+      pose.orientation.w = c * q.w - s * q.z;
+      pose.orientation.x = c * q.x - s * q.y;
+      pose.orientation.y = c * q.y + s * q.x;
+      pose.orientation.z = c * q.z + s * q.w;
+    }
+    object.shape.dimensions.x = length[i];
+    object.shape.dimensions.y = width[i];
+  }
+
+  for (std::size_t i = detected_size; i < size(); ++i) {
+    if (not lost[i]) {
+      auto & object = detected_objects.objects.emplace_back();
+      object.existence_probability = 1;
+      auto & classification = object.classification.emplace_back();
+      classification.label = autoware_auto_perception_msgs::msg::ObjectClassification::UNKNOWN;
+      classification.probability = 1;
+      auto & pose = object.kinematics.pose_with_covariance.pose;
+      pose.position.x = x[i];
+      pose.position.y = y[i];
+      pose.orientation.z = std::sin(yaw_offset[i] / 2);
+      pose.orientation.w = std::cos(yaw_offset[i] / 2);
+      object.shape.type = autoware_auto_perception_msgs::msg::Shape::BOUNDING_BOX;
+      object.shape.dimensions.x = length[i];
+      object.shape.dimensions.y = width[i];
+      object.shape.dimensions.z = 1.5;
+    }
+  }
+
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < detected_size; ++i) {
+    if (not lost[i]) {
+      if (kept != i) {
+        detected_objects.objects[kept] = std::move(detected_objects.objects[i]);
+      }
+      ++kept;
+    }
+  }
+  detected_objects.objects.erase(
+    detected_objects.objects.begin() + kept, detected_objects.objects.begin() + detected_size);
+}
+
+auto PositionNoiseModel::apply(
+  const CounterBasedRandom & random, std::uint64_t frame, NoiseTarget & target) const -> void
+{
+  random.fillNormal(POSITION, frame, target.entities, target.random0, target.random1);
+  for (std::size_t i = 0; i < target.size(); ++i) {
+    target.x[i] += standard_deviation_ * target.random0[i];
+    target.y[i] += standard_deviation_ * target.random1[i];
+  }
+}
+
+auto YawNoiseModel::apply(
+  const CounterBasedRandom & random, std::uint64_t frame, NoiseTarget & target) const -> void
+{
+  random.fillNormal(YAW, frame, target.entities, target.random0, target.random1);
+  for (std::size_t i = 0; i < target.size(); ++i) {
+    target.yaw_offset[i] += standard_deviation_ * target.random0[i];
+  }
+}
+
+auto ShapeNoiseModel::apply(
+  const CounterBasedRandom & random, std::uint64_t frame, NoiseTarget & target) const -> void
+{
+  random.fillNormal(SHAPE, frame, target.entities, target.random0, target.random1);
+  for (std::size_t i = 0; i < target.size(); ++i) {
+    target.length[i] = std::max(0.0, target.length[i] + standard_deviation_ * target.random0[i]);
+    target.width[i] = std::max(0.0, target.width[i] + standard_deviation_ * target.random1[i]);
+  }
+}
+
+auto MisdetectionNoiseModel::apply(
+  const CounterBasedRandom & random, std::uint64_t frame, NoiseTarget & target) const -> void
+{
+  random.fillUniform(MISDETECTION, frame, target.entities, target.random0);
+  for (std::size_t i = 0; i < target.size(); ++i) {
+    target.lost[i] |= target.random0[i] < probability_;
+  }
+}
+
+auto FalsePositiveNoiseModel::apply(
+  const CounterBasedRandom & random, std::uint64_t frame, NoiseTarget & target) const -> void
+{
+  // a false positive belongs to no entity, so it is keyed by a hash no entity name should have
+  constexpr auto entity = std::numeric_limits<std::uint64_t>::max();
+  if (const auto block = random(FALSE_POSITIVE, frame, entity);
+      CounterBasedRandom::uniform(block[0]) < probability_) {
+    const auto radius = target.range * std::sqrt(CounterBasedRandom::uniform(block[1]));
+    const auto angle = 2 * M_PI * CounterBasedRandom::uniform(block[2]);
+    const auto i = target.size();
+    target.resize(i + 1);
+    target.entities[i] = entity;
+    target.x[i] = target.ego_x + radius * std::cos(angle);
+    target.y[i] = target.ego_y + radius * std::sin(angle);
+    target.yaw_offset[i] = 2 * M_PI * CounterBasedRandom::uniform(block[3]);
+    target.length[i] = 4.0;
+    target.width[i] = 1.8;
+    target.lost[i] = false;
+  }
+}
+
+NoiseModelPipeline::NoiseModelPipeline(
+  const simulation_api_schema::DetectionSensorConfiguration & configuration)
+: random_(configuration.random_seed()), range_(configuration.range())
+{
+  if (0 < configuration.pos_noise_stddev()) {
+    add(std::make_unique<PositionNoiseModel>(configuration.pos_noise_stddev()));
+  }
+  if (0 < configuration.yaw_noise_stddev()) {
+    add(std::make_unique<YawNoiseModel>(configuration.yaw_noise_stddev()));
+  }
+  if (0 < configuration.shape_noise_stddev()) {
+    add(std::make_unique<ShapeNoiseModel>(configuration.shape_noise_stddev()));
+  }
+  if (0 < configuration.probability_of_lost()) {
+    add(std::make_unique<MisdetectionNoiseModel>(configuration.probability_of_lost()));
+  }
+  if (0 < configuration.probability_of_false_positive()) {
+    add(std::make_unique<FalsePositiveNoiseModel>(configuration.probability_of_false_positive()));
+  }
+
+  /*
+     NOTE: for Autoware developers
+
+     If you need to apply experimental noise to the DetectedObjects that the
+     simulator publishes, implement a class derived from NoiseModel and add it
+     here. It edits the objects of a frame through NoiseTarget and should draw
+     its random numbers from a NoiseStream of its own.
+  */
+}
+
+auto NoiseModelPipeline::operator()(
+  autoware_auto_perception_msgs::msg::DetectedObjects & detected_objects,
+  const std::vector<std::uint64_t> & entities, const geometry_msgs::msg::Pose & ego_pose) -> void
+{
+  const auto frame = frame_++;
+  if (not models_.empty()) {
+    target_.read(detected_objects, entities);
+    target_.ego_x = ego_pose.position.x;
+    target_.ego_y = ego_pose.position.y;
+    target_.range = range_;
+    for (const auto & model : models_) {
+      model->apply(random_, frame, target_);
+    }
+    target_.write(detected_objects);
+  }
+}
+}  // namespace simple_sensor_simulator
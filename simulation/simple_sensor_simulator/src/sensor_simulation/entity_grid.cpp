@@ -0,0 +1,149 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <simple_sensor_simulator/sensor_simulation/entity_grid.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+EntityGrid::EntityGrid(double cell_size) : cell_size_(cell_size)
+{
+  if (not(cell_size > 0)) {
+    throw std::invalid_argument("cell size of the entity grid must be positive");
+  }
+}
+
+auto EntityGrid::cellIndex(double value) const -> std::int32_t
+{
+  constexpr double lowest = std::numeric_limits<std::int32_t>::lowest();
+  constexpr double highest = std::numeric_limits<std::int32_t>::max();
+  return static_cast<std::int32_t>(std::clamp(std::floor(value / cell_size_), lowest, highest));
+}
+
+auto EntityGrid::cellKey(std::int32_t x, std::int32_t y) -> CellKey
+{
+  return (static_cast<CellKey>(static_cast<std::uint32_t>(x)) << 32) |
+         static_cast<std::uint32_t>(y);
+}
+
+auto EntityGrid::link(const std::string & name, CellKey cell) -> void
+{
+  cells_[cell].push_back(name);
+}
+
+auto EntityGrid::unlink(const std::string & name, CellKey cell) -> void
+{
+  if (auto iter = cells_.find(cell); iter != cells_.end()) {
+    auto & names = iter->second;
+    if (auto found = std::find(names.begin(), names.end(), name); found != names.end()) {
+      *found = std::move(names.back());
+      names.pop_back();
+    }
+    if (names.empty()) {
+      cells_.erase(iter);
+    }
+  }
+}
+
+auto EntityGrid::insert(const std::string & name, double x, double y, double radius) -> void
+{
+  const auto cell = cellKey(cellIndex(x), cellIndex(y));
+  if (auto iter = entries_.find(name); iter != entries_.end()) {
+    if (iter->second.cell != cell) {
+      unlink(name, iter->second.cell);
+      link(name, cell);
+    }
+    iter->second = Entry{x, y, radius, cell};
+  } else {
+    entries_.emplace(name, Entry{x, y, radius, cell});
+    link(name, cell);
+  }
+  max_radius_ = std::max(max_radius_, radius);
+}
+
+auto EntityGrid::move(const std::string & name, double x, double y) -> void
+{
+  auto & entry = entries_.at(name);
+  // most entities stay in the same cell from one frame to the next, so this is usually cheap
+  if (const auto cell = cellKey(cellIndex(x), cellIndex(y)); entry.cell != cell) {
+    unlink(name, entry.cell);
+    link(name, cell);
+    entry.cell = cell;
+  }
+  entry.x = x;
+  entry.y = y;
+}
+
+auto EntityGrid::erase(const std::string & name) -> void
+{
+  if (auto iter = entries_.find(name); iter != entries_.end()) {
+    unlink(name, iter->second.cell);
+    entries_.erase(iter);
+  }
+}
+
+auto EntityGrid::clear() -> void
+{
+  entries_.clear();
+  cells_.clear();
+  max_radius_ = 0;
+}
+
+auto EntityGrid::contains(const std::string & name) const -> bool
+{
+  return entries_.find(name) != entries_.end();
+}
+
+auto EntityGrid::query(double x, double y, double range) const -> std::vector<std::string>
+{
+  std::vector<std::string> result;
+
+  auto collect = [&](const std::vector<std::string> & names) {
+    for (const auto & name : names) {
+      const auto & entry = entries_.at(name);
+      if (std::hypot(entry.x - x, entry.y - y) <= range + entry.radius) {
+        result.push_back(name);
+      }
+    }
+  };
+
+  const auto reach = range + max_radius_;
+  const auto x_min = cellIndex(x - reach), x_max = cellIndex(x + reach);
+  const auto y_min = cellIndex(y - reach), y_max = cellIndex(y + reach);
+  const auto cell_count = (static_cast<double>(x_max) - x_min + 1) *  //
+                          (static_cast<double>(y_max) - y_min + 1);
+
+  if (cell_count > cells_.size()) {
+    // the range covers more cells than are occupied, so visiting the occupied ones is cheaper
+    for (const auto & [cell, names] : cells_) {
+      collect(names);
+    }
+  } else {
+    for (std::int64_t i = x_min; i <= x_max; ++i) {
+      for (std::int64_t j = y_min; j <= y_max; ++j) {
+        if (auto iter = cells_.find(cellKey(i, j)); iter != cells_.end()) {
+          collect(iter->second);
+        }
+      }
+    }
+  }
+  return result;
+}
+}  // namespace simple_sensor_simulator
@@ -24,8 +24,8 @@ namespace simple_sensor_simulator
 {
 template <>
 auto LidarSensor<sensor_msgs::msg::PointCloud2>::raycast(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & entities,
-  const rclcpp::Time & current_ros_time) -> sensor_msgs::msg::PointCloud2
+  const EntityStatusView & entities, const rclcpp::Time & current_ros_time,
+  sensor_msgs::msg::PointCloud2 & pointcloud) -> void
 {
   std::optional<geometry_msgs::msg::Pose> ego_pose;
 
@@ -34,34 +34,14 @@ auto LidarSensor<sensor_msgs::msg::PointCloud2>::raycast(
       geometry_msgs::msg::Pose pose;
       simulation_interface::toMsg(entity.pose(), pose);
       ego_pose = pose;
-    } else {
-      geometry_msgs::msg::Pose pose;
-      simulation_interface::toMsg(entity.pose(), pose);
-      auto rotation = math::geometry::getRotationMatrix(pose.orientation);
-      geometry_msgs::msg::Point center_point;
-      simulation_interface::toMsg(entity.bounding_box().center(), center_point);
-      Eigen::Vector3d center(center_point.x, center_point.y, center_point.z);
-      center = rotation * center;
-      pose.position.x = pose.position.x + center.x();
-      pose.position.y = pose.position.y + center.y();
-      pose.position.z = pose.position.z + center.z();
-      raycaster_.addPrimitive<simple_sensor_simulator::primitives::Box>(
-        entity.name(),                           //
-        entity.bounding_box().dimensions().x(),  //
-        entity.bounding_box().dimensions().y(),  //
-        entity.bounding_box().dimensions().z(),  //
-        pose);
     }
   }
 
+  raycaster_->updatePrimitives(entities, configuration_.entity());
+
   if (ego_pose) {
-    std::vector<double> vertical_angles;
-    for (const auto vertical_angle : configuration_.vertical_angles()) {
-      vertical_angles.push_back(vertical_angle);
-    }
-    const auto pointcloud = raycaster_.raycast("base_link", current_ros_time, ego_pose.value());
-    detected_objects_ = raycaster_.getDetectedObject();
-    return pointcloud;
+    raycaster_->raycast(pointcloud, frame_id_, current_ros_time, ego_pose.value(), getRange());
+    detected_objects_ = raycaster_->getDetectedObject();
   } else {
     throw simple_sensor_simulator::SimulationRuntimeError("failed to find ego vehicle");
   }
@@ -0,0 +1,216 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <simple_sensor_simulator/exception.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+namespace
+{
+struct CacheHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  float voxel_size;
+  std::uint64_t pcd_size;
+  std::int64_t pcd_write_time;
+  std::uint64_t voxel_count;
+};
+
+constexpr char cache_magic[8] = {'S', 'S', 'S', 'V', 'O', 'X', 'E', 'L'};
+
+constexpr std::uint32_t cache_version = 1;
+
+auto makeCacheHeader(const std::filesystem::path & pcd_path, float voxel_size) -> CacheHeader
+{
+  CacheHeader header = {};
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = cache_version;
+  header.voxel_size = voxel_size;
+  header.pcd_size = std::filesystem::file_size(pcd_path);
+  header.pcd_write_time = std::filesystem::last_write_time(pcd_path).time_since_epoch().count();
+  return header;
+}
+
+auto isSameSource(const CacheHeader & lhs, const CacheHeader & rhs) -> bool
+{
+  return std::memcmp(lhs.magic, rhs.magic, sizeof(lhs.magic)) == 0 and
+         lhs.version == rhs.version and lhs.voxel_size == rhs.voxel_size and
+         lhs.pcd_size == rhs.pcd_size and lhs.pcd_write_time == rhs.pcd_write_time;
+}
+}  // namespace
+
+PointCloudMap::PointCloudMap(const std::filesystem::path & pcd_path, float voxel_size)
+: voxel_size(voxel_size)
+{
+  if (not std::filesystem::is_regular_file(pcd_path)) {
+    throw SimulationRuntimeError(
+      ("pointcloud map " + pcd_path.string() + " does not exist").c_str());
+  }
+  if (not loadCache(pcd_path)) {
+    load(pcd_path);
+    saveCache(pcd_path);
+  }
+}
+
+PointCloudMap::~PointCloudMap()
+{
+  for (const auto & [device, scene] : scenes_) {
+    rtcReleaseScene(scene);
+  }
+}
+
+auto PointCloudMap::cachePath(const std::filesystem::path & pcd_path, float voxel_size)
+  -> std::filesystem::path
+{
+  const auto voxel_size_in_millimeters = static_cast<int>(std::round(voxel_size * 1000));
+  return pcd_path.string() + "." + std::to_string(voxel_size_in_millimeters) + "mm.voxels";
+}
+
+auto PointCloudMap::load(const std::filesystem::path & pcd_path) -> void
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  if (pcl::io::loadPCDFile(pcd_path.string(), cloud) != 0) {
+    throw SimulationRuntimeError(("failed to load pointcloud map " + pcd_path.string()).c_str());
+  }
+
+  struct Centroid
+  {
+    double x = 0;
+    double y = 0;
+    double z = 0;
+    std::size_t count = 0;
+  };
+
+  // 21 bits per axis covers +-1048576 voxels, which is far larger than any map
+  auto toKey = [this](const pcl::PointXYZ & point) {
+    constexpr std::int64_t mask = (std::int64_t(1) << 21) - 1;
+    const auto index = [this](float value) {
+      return static_cast<std::int64_t>(std::floor(value / voxel_size));
+    };
+    return ((index(point.x) & mask) << 42) | ((index(point.y) & mask) << 21) |
+           (index(point.z) & mask);
+  };
+
+  std::unordered_map<std::int64_t, Centroid> centroids;
+  for (const auto & point : cloud) {
+    if (std::isfinite(point.x) and std::isfinite(point.y) and std::isfinite(point.z)) {
+      auto & centroid = centroids[toKey(point)];
+      centroid.x += point.x;
+      centroid.y += point.y;
+      centroid.z += point.z;
+      ++centroid.count;
+    }
+  }
+
+  voxels_.clear();
+  voxels_.reserve(centroids.size());
+  for (const auto & [voxel_key, centroid] : centroids) {
+    voxels_.push_back(Vertex{
+      static_cast<float>(centroid.x / centroid.count),
+      static_cast<float>(centroid.y / centroid.count),
+      static_cast<float>(centroid.z / centroid.count)});
+  }
+}
+
+auto PointCloudMap::loadCache(const std::filesystem::path & pcd_path) -> bool
+{
+  std::ifstream file(cachePath(pcd_path, voxel_size), std::ios::binary);
+  if (not file) {
+    return false;
+  }
+  CacheHeader header;
+  if (
+    not file.read(reinterpret_cast<char *>(&header), sizeof(header)) or
+    not isSameSource(header, makeCacheHeader(pcd_path, voxel_size))) {
+    return false;
+  }
+  voxels_.resize(header.voxel_count);
+  if (not file.read(
+        reinterpret_cast<char *>(voxels_.data()), voxels_.size() * sizeof(Vertex))) {
+    voxels_.clear();
+    return false;
+  }
+  return true;
+}
+
+auto PointCloudMap::saveCache(const std::filesystem::path & pcd_path) const -> void
+{
+  /*
+     The cache is only an optimization, so a read-only map directory is not an error. It is
+     written to a temporary file first, so that concurrent runs never read a partial cache.
+  */
+  const auto path = cachePath(pcd_path, voxel_size);
+  const auto temporary_path = path.string() + "." + std::to_string(::getpid());
+  auto header = makeCacheHeader(pcd_path, voxel_size);
+  header.voxel_count = voxels_.size();
+  {
+    std::ofstream file(temporary_path, std::ios::binary);
+    if (
+      not file or not file.write(reinterpret_cast<const char *>(&header), sizeof(header)) or
+      not file.write(
+        reinterpret_cast<const char *>(voxels_.data()), voxels_.size() * sizeof(Vertex))) {
+      std::error_code error;
+      std::filesystem::remove(temporary_path, error);
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+  }
+}
+
+auto PointCloudMap::getScene(RTCDevice device) const -> RTCScene
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  if (const auto iter = scenes_.find(device); iter != scenes_.end()) {
+    return iter->second;
+  }
+  RTCScene scene = rtcNewScene(device);
+  rtcSetSceneBuildQuality(scene, RTC_BUILD_QUALITY_HIGH);
+  // each sphere encloses its whole voxel, so that rays cannot slip between neighboring voxels
+  const float radius = 0.5f * std::sqrt(3.0f) * voxel_size;
+  RTCGeometry geometry = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_SPHERE_POINT);
+  float * points = static_cast<float *>(rtcSetNewGeometryBuffer(
+    geometry, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT4, 4 * sizeof(float), voxels_.size()));
+  for (size_t i = 0; i < voxels_.size(); i++) {
+    points[4 * i + 0] = voxels_[i].x;
+    points[4 * i + 1] = voxels_[i].y;
+    points[4 * i + 2] = voxels_[i].z;
+    points[4 * i + 3] = radius;
+  }
+  // enable raycasting
+  rtcSetGeometryMask(geometry, 0b11111111'11111111'11111111'11111111);
+  rtcCommitGeometry(geometry);
+  rtcAttachGeometry(scene, geometry);
+  rtcReleaseGeometry(geometry);
+  rtcCommitScene(scene);
+  return scenes_.emplace(device, scene).first->second;
+}
+}  // namespace simple_sensor_simulator
@@ -13,38 +13,271 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sensor_msgs/msg/point_field.hpp>
 #include <simple_sensor_simulator/sensor_simulation/lidar/lidar_sensor.hpp>
 #include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
+#include <simulation_interface/conversions.hpp>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace simple_sensor_simulator
 {
-Raycaster::Raycaster()
-: primitive_ptrs_(0),
-  device_(rtcNewDevice(nullptr)),
+namespace
+{
+/**
+ * @brief Device of every raycaster created without a configuration of its own
+ * @note Each device starts its own threads and allocators, so the sensors of every session share
+ * one. The device is retained for the caller, who releases it as usual.
+ */
+auto getSharedDevice() -> RTCDevice
+{
+  static const auto device = std::unique_ptr<RTCDeviceTy, decltype(&rtcReleaseDevice)>(
+    rtcNewDevice(nullptr), &rtcReleaseDevice);
+  rtcRetainDevice(device.get());
+  return device.get();
+}
+}  // namespace
+
+Raycaster::Raycaster(std::shared_ptr<ThreadPool> thread_pool)
+: instances_(0),
+  device_(getSharedDevice()),
   scene_(rtcNewScene(device_)),
-  engine_(seed_gen_())
+  engine_(seed_gen_()),
+  thread_pool_(std::move(thread_pool)),
+  packet_size_(rtcGetDeviceProperty(device_, RTC_DEVICE_PROPERTY_NATIVE_RAY16_SUPPORTED) ? 16 : 8)
 {
+  // Only instance transforms change between scans. The top level BVH holds one leaf per instance
+  // and is rebuilt with the fast builder, while the mesh BVH of each primitive is never rebuilt.
+  rtcSetSceneFlags(scene_, RTC_SCENE_FLAG_DYNAMIC);
+  rtcSetSceneBuildQuality(scene_, RTC_BUILD_QUALITY_LOW);
 }
 
-Raycaster::Raycaster(std::string embree_config)
-: primitive_ptrs_(0),
+Raycaster::Raycaster(std::string embree_config, std::shared_ptr<ThreadPool> thread_pool)
+: instances_(0),
   device_(rtcNewDevice(embree_config.c_str())),
   scene_(rtcNewScene(device_)),
-  engine_(seed_gen_())
+  engine_(seed_gen_()),
+  thread_pool_(std::move(thread_pool)),
+  packet_size_(rtcGetDeviceProperty(device_, RTC_DEVICE_PROPERTY_NATIVE_RAY16_SUPPORTED) ? 16 : 8)
 {
+  rtcSetSceneFlags(scene_, RTC_SCENE_FLAG_DYNAMIC);
+  rtcSetSceneBuildQuality(scene_, RTC_BUILD_QUALITY_LOW);
 }
 
 Raycaster::~Raycaster()
 {
+  for (auto & [name, instance] : instances_) {
+    rtcReleaseGeometry(instance.geometry);
+    rtcReleaseScene(instance.scene);
+  }
+  setPointCloudMap(nullptr);
   rtcReleaseScene(scene_);
   rtcReleaseDevice(device_);
 }
 
+namespace
+{
+template <std::size_t PacketSize>
+struct RayHitPacket;
+
+template <>
+struct RayHitPacket<8>
+{
+  using type = RTCRayHit8;
+  static auto intersect(const int * valid, RTCScene scene, type * rayhit) -> void
+  {
+    rtcIntersect8(valid, scene, rayhit);
+  }
+};
+
+template <>
+struct RayHitPacket<16>
+{
+  using type = RTCRayHit16;
+  static auto intersect(const int * valid, RTCScene scene, type * rayhit) -> void
+  {
+    rtcIntersect16(valid, scene, rayhit);
+  }
+};
+
+// x, y, z and intensity as consecutive float32 fields
+struct PointXYZI
+{
+  float x;
+  float y;
+  float z;
+  float intensity;
+};
+
+auto makePointField(const std::string & name, std::uint32_t offset) -> sensor_msgs::msg::PointField
+{
+  return sensor_msgs::build<sensor_msgs::msg::PointField>()
+    .name(name)
+    .offset(offset)
+    .datatype(sensor_msgs::msg::PointField::FLOAT32)
+    .count(1);
+}
+
+auto toInstanceTransform(const geometry_msgs::msg::Pose & pose) -> std::array<float, 12>
+{
+  const auto rotation = math::geometry::getRotationMatrix(pose.orientation);
+  // RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR
+  return {
+    static_cast<float>(rotation(0, 0)), static_cast<float>(rotation(1, 0)),
+    static_cast<float>(rotation(2, 0)), static_cast<float>(rotation(0, 1)),
+    static_cast<float>(rotation(1, 1)), static_cast<float>(rotation(2, 1)),
+    static_cast<float>(rotation(0, 2)), static_cast<float>(rotation(1, 2)),
+    static_cast<float>(rotation(2, 2)), static_cast<float>(pose.position.x),
+    static_cast<float>(pose.position.y), static_cast<float>(pose.position.z)};
+}
+}  // namespace
+
+void Raycaster::attachInstance(
+  const std::string & name, std::unique_ptr<primitives::Primitive> primitive_ptr)
+{
+  Instance instance;
+  instance.scene = rtcNewScene(device_);
+  primitive_ptr->addLocalGeometryToScene(device_, instance.scene);
+  rtcCommitScene(instance.scene);
+
+  instance.geometry = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_INSTANCE);
+  rtcSetGeometryInstancedScene(instance.geometry, instance.scene);
+  // enable raycasting
+  rtcSetGeometryMask(instance.geometry, 0b11111111'11111111'11111111'11111111);
+  const auto transform = toInstanceTransform(primitive_ptr->pose);
+  rtcSetGeometryTransform(
+    instance.geometry, 0, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+  rtcCommitGeometry(instance.geometry);
+  instance.geometry_id = rtcAttachGeometry(scene_, instance.geometry);
+  instance.primitive_ptr = std::move(primitive_ptr);
+
+  geometry_ids_.emplace(instance.geometry_id, name);
+  instances_.emplace(name, std::move(instance));
+}
+
+void Raycaster::setPrimitivePose(const std::string & name, const geometry_msgs::msg::Pose & pose)
+{
+  if (const auto iter = instances_.find(name); iter != instances_.end()) {
+    const auto transform = toInstanceTransform(pose);
+    rtcSetGeometryTransform(
+      iter->second.geometry, 0, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+    rtcCommitGeometry(iter->second.geometry);
+  } else {
+    throw std::runtime_error("primitive " + name + " does not exist.");
+  }
+}
+
+void Raycaster::removePrimitive(const std::string & name)
+{
+  if (const auto iter = instances_.find(name); iter != instances_.end()) {
+    rtcDetachGeometry(scene_, iter->second.geometry_id);
+    rtcReleaseGeometry(iter->second.geometry);
+    rtcReleaseScene(iter->second.scene);
+    geometry_ids_.erase(iter->second.geometry_id);
+    instances_.erase(iter);
+  }
+}
+
+void Raycaster::updatePrimitives(
+  const EntityStatusView & entities, const std::string & ego_name, bool disable_missing)
+{
+  std::unordered_set<std::string> entity_names;
+
+  for (const auto & entity : entities) {
+    if (ego_name != entity.name()) {
+      geometry_msgs::msg::Pose pose;
+      simulation_interface::toMsg(entity.pose(), pose);
+      auto rotation = math::geometry::getRotationMatrix(pose.orientation);
+      geometry_msgs::msg::Point center_point;
+      simulation_interface::toMsg(entity.bounding_box().center(), center_point);
+      Eigen::Vector3d center(center_point.x, center_point.y, center_point.z);
+      center = rotation * center;
+      pose.position.x = pose.position.x + center.x();
+      pose.position.y = pose.position.y + center.y();
+      pose.position.z = pose.position.z + center.z();
+      entity_names.insert(entity.name());
+      const auto & dimensions = entity.bounding_box().dimensions();
+      if (const auto box = getPrimitive<primitives::Box>(entity.name());
+          box and box->depth == static_cast<float>(dimensions.x()) and
+          box->width == static_cast<float>(dimensions.y()) and
+          box->height == static_cast<float>(dimensions.z())) {
+        setPrimitivePose(entity.name(), pose);
+        if (auto & instance = instances_.at(entity.name()); not instance.enabled) {
+          rtcEnableGeometry(instance.geometry);
+          instance.enabled = true;
+        }
+      } else {
+        removePrimitive(entity.name());
+        addPrimitive<primitives::Box>(
+          entity.name(),   //
+          dimensions.x(),  //
+          dimensions.y(),  //
+          dimensions.z(),  //
+          pose);
+      }
+    }
+  }
+
+  for (const auto & name : getPrimitiveNames()) {
+    if (entity_names.find(name) == entity_names.end()) {
+      if (not disable_missing) {
+        removePrimitive(name);
+      } else if (auto & instance = instances_.at(name); instance.enabled) {
+        rtcDisableGeometry(instance.geometry);
+        instance.enabled = false;
+      }
+    }
+  }
+}
+
+void Raycaster::setPointCloudMap(const std::shared_ptr<const PointCloudMap> & point_cloud_map)
+{
+  if (point_cloud_map_geometry_id_ != RTC_INVALID_GEOMETRY_ID) {
+    rtcDetachGeometry(scene_, point_cloud_map_geometry_id_);
+    rtcReleaseGeometry(point_cloud_map_geometry_);
+    point_cloud_map_geometry_ = nullptr;
+    point_cloud_map_geometry_id_ = RTC_INVALID_GEOMETRY_ID;
+  }
+
+  point_cloud_map_ = point_cloud_map;
+
+  if (point_cloud_map_ and not point_cloud_map_->getVoxels().empty()) {
+    point_cloud_map_geometry_ = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_INSTANCE);
+    rtcSetGeometryInstancedScene(point_cloud_map_geometry_, point_cloud_map_->getScene(device_));
+    // enable raycasting
+    rtcSetGeometryMask(point_cloud_map_geometry_, 0b11111111'11111111'11111111'11111111);
+    geometry_msgs::msg::Pose identity;
+    const auto transform = toInstanceTransform(identity);
+    rtcSetGeometryTransform(
+      point_cloud_map_geometry_, 0, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+    rtcCommitGeometry(point_cloud_map_geometry_);
+    point_cloud_map_geometry_id_ = rtcAttachGeometry(scene_, point_cloud_map_geometry_);
+  }
+}
+
+auto Raycaster::getPrimitiveNames() const -> std::vector<std::string>
+{
+  std::vector<std::string> names;
+  names.reserve(instances_.size());
+  for (const auto & [name, instance] : instances_) {
+    names.push_back(name);
+  }
+  return names;
+}
+
 void Raycaster::setDirection(
   const simulation_api_schema::LidarConfiguration & configuration, double horizontal_angle_start,
   double horizontal_angle_end)
@@ -54,96 +287,235 @@ void Raycaster::setDirection(
     vertical_angles.emplace_back(v);
   }
 
-  auto quat_directions = getDirections(
+  directions_ = getDirections(
     vertical_angles, horizontal_angle_start, horizontal_angle_end,
     configuration.horizontal_resolution());
-  rotation_matrices_.clear();
-  for (const auto & q : quat_directions) {
-    rotation_matrices_.push_back(math::geometry::getRotationMatrix(q));
-  }
 }
 
-std::vector<geometry_msgs::msg::Quaternion> Raycaster::getDirections(
+auto Raycaster::getDirections(
   const std::vector<double> & vertical_angles, double horizontal_angle_start,
-  double horizontal_angle_end, double horizontal_resolution)
-{
-  if (
-    directions_.empty() || previous_horizontal_angle_start_ != horizontal_angle_start ||
-    previous_horizontal_angle_end_ != horizontal_angle_end ||
-    previous_horizontal_resolution_ != horizontal_resolution ||
-    previous_vertical_angles_ != vertical_angles) {
-    std::vector<geometry_msgs::msg::Quaternion> directions;
+  double horizontal_angle_end, double horizontal_resolution) -> std::shared_ptr<const Directions>
+{
+  using Key = std::tuple<std::vector<double>, double, double, double>;
+  static std::map<Key, std::shared_ptr<const Directions>> cache;
+  static std::mutex mutex;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto & directions = cache[Key(
+    vertical_angles, horizontal_angle_start, horizontal_angle_end, horizontal_resolution)];
+  if (not directions) {
+    auto table = std::make_shared<Directions>();
     double horizontal_angle = horizontal_angle_start;
     while (horizontal_angle <= horizontal_angle_end) {
       horizontal_angle = horizontal_angle + horizontal_resolution;
       for (const auto vertical_angle : vertical_angles) {
-        geometry_msgs::msg::Vector3 rpy;
-        rpy.x = 0;
-        rpy.y = vertical_angle;
-        rpy.z = horizontal_angle;
-        auto quat = math::geometry::convertEulerAngleToQuaternion(rpy);
-        directions.emplace_back(quat);
+        // first column of the rotation matrix of roll = 0, pitch = vertical_angle and
+        // yaw = horizontal_angle
+        table->x.push_back(std::cos(vertical_angle) * std::cos(horizontal_angle));
+        table->y.push_back(std::cos(vertical_angle) * std::sin(horizontal_angle));
+        table->z.push_back(-std::sin(vertical_angle));
       }
     }
-    directions_ = directions;
-    previous_horizontal_angle_end_ = horizontal_angle_end;
-    previous_horizontal_angle_start_ = horizontal_angle_start;
-    previous_horizontal_resolution_ = horizontal_resolution;
-    previous_vertical_angles_ = vertical_angles;
+    directions = std::move(table);
   }
-  return directions_;
+  return directions;
 }
 
 const std::vector<std::string> & Raycaster::getDetectedObject() const { return detected_objects_; }
 
-const sensor_msgs::msg::PointCloud2 Raycaster::raycast(
-  const std::string & frame_id, const rclcpp::Time & stamp, const geometry_msgs::msg::Pose & origin,
-  double max_distance, double min_distance)
+template <std::size_t PacketSize>
+auto Raycaster::intersect(
+  std::uint8_t * data, std::size_t begin, std::size_t end, const geometry_msgs::msg::Pose & origin,
+  double max_distance, double min_distance) -> std::size_t
 {
-  detected_objects_ = {};
-  pcl::PointCloud<pcl::PointXYZI>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZI>());
-  for (auto & pair : primitive_ptrs_) {
-    auto id = pair.second->addToScene(device_, scene_);
-    geometry_ids_.insert({id, pair.first});
-  }
+  // Hits are packed at the front of [begin, end), so every task writes to its own range only.
+  std::size_t hit_count = 0;
+  for (auto packet_begin = begin; packet_begin < end; packet_begin += PacketSize) {
+    // rtcIntersect8 and rtcIntersect16 require the mask and the rays aligned to the packet size
+    alignas(sizeof(int) * PacketSize) typename RayHitPacket<PacketSize>::type rayhit = {};
+    alignas(sizeof(int) * PacketSize) int valid[PacketSize];
+    for (std::size_t lane = 0; lane < PacketSize; ++lane) {
+      const auto i = packet_begin + lane;
+      if (i < end) {
+        valid[lane] = -1;
+        rayhit.ray.org_x[lane] = origin.position.x;
+        rayhit.ray.org_y[lane] = origin.position.y;
+        rayhit.ray.org_z[lane] = origin.position.z;
+        rayhit.ray.dir_x[lane] = rotated_directions_.x[i];
+        rayhit.ray.dir_y[lane] = rotated_directions_.y[i];
+        rayhit.ray.dir_z[lane] = rotated_directions_.z[i];
+        // make raycast interact with all objects
+        rayhit.ray.mask[lane] = 0b11111111'11111111'11111111'11111111;
+        rayhit.ray.tfar[lane] = max_distance;
+        rayhit.ray.tnear[lane] = min_distance;
+        rayhit.hit.geomID[lane] = RTC_INVALID_GEOMETRY_ID;
+        rayhit.hit.instID[0][lane] = RTC_INVALID_GEOMETRY_ID;
+      } else {
+        valid[lane] = 0;
+      }
+    }
 
-  // Run as many threads as physical cores (which is usually /2 virtual threads)
-  // In heavy loads virtual threads (hyper-threading) add little to the overall performance
-  // This also minimizes cost of creating a thread (roughly 10us on Intel/Linux)
-  int thread_count = std::thread::hardware_concurrency() / 2;
-  // Per thread data structures:
-  std::vector<std::thread> threads(thread_count);
-  std::vector<std::set<unsigned int>> thread_detected_ids(thread_count);
-  std::vector<pcl::PointCloud<pcl::PointXYZI>::Ptr> thread_cloud(thread_count);
+    RayHitPacket<PacketSize>::intersect(valid, scene_, &rayhit);
 
-  rtcCommitScene(scene_);
-  for (unsigned int i = 0; i < threads.size(); ++i) {
-    thread_cloud[i] = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>());
-    threads[i] = std::thread(
-      intersect, i, thread_count, scene_, thread_cloud[i], origin, std::ref(thread_detected_ids[i]),
-      max_distance, min_distance, std::ref(rotation_matrices_));
-  }
-  for (unsigned int i = 0; i < threads.size(); ++i) {
-    threads[i].join();
-    (*cloud) += *(thread_cloud[i]);
-  }
-  for (auto && detected_ids_in_thread : thread_detected_ids) {
-    for (const auto & id : detected_ids_in_thread) {
-      detected_objects_.emplace_back(geometry_ids_[id]);
+    for (std::size_t lane = 0; lane < PacketSize and packet_begin + lane < end; ++lane) {
+      if (rayhit.hit.instID[0][lane] != RTC_INVALID_GEOMETRY_ID) {
+        const auto i = packet_begin + lane;
+        const float distance = rayhit.ray.tfar[lane];
+        const PointXYZI p = {
+          directions_->x[i] * distance, directions_->y[i] * distance,
+          directions_->z[i] * distance, 0.0f};
+        std::memcpy(data + (begin + hit_count) * sizeof(PointXYZI), &p, sizeof(PointXYZI));
+        hit_ids_[begin + hit_count] = rayhit.hit.instID[0][lane];
+        ++hit_count;
+      }
     }
   }
+  return hit_count;
+}
+
+template <std::size_t PacketSize>
+auto Raycaster::intersectHorizontally(
+  std::size_t begin, std::size_t end, const geometry_msgs::msg::Point & origin,
+  std::size_t ray_count, double max_distance) -> void
+{
+  for (auto packet_begin = begin; packet_begin < end; packet_begin += PacketSize) {
+    // rtcIntersect8 and rtcIntersect16 require the mask and the rays aligned to the packet size
+    alignas(sizeof(int) * PacketSize) typename RayHitPacket<PacketSize>::type rayhit = {};
+    alignas(sizeof(int) * PacketSize) int valid[PacketSize];
+    for (std::size_t lane = 0; lane < PacketSize; ++lane) {
+      const auto i = packet_begin + lane;
+      if (i < end) {
+        const auto yaw = 2 * M_PI * i / ray_count;
+        valid[lane] = -1;
+        rayhit.ray.org_x[lane] = origin.x;
+        rayhit.ray.org_y[lane] = origin.y;
+        rayhit.ray.org_z[lane] = origin.z;
+        rayhit.ray.dir_x[lane] = std::cos(yaw);
+        rayhit.ray.dir_y[lane] = std::sin(yaw);
+        rayhit.ray.dir_z[lane] = 0;
+        // make raycast interact with all objects
+        rayhit.ray.mask[lane] = 0b11111111'11111111'11111111'11111111;
+        rayhit.ray.tfar[lane] = max_distance;
+        rayhit.ray.tnear[lane] = 0;
+        rayhit.hit.geomID[lane] = RTC_INVALID_GEOMETRY_ID;
+        rayhit.hit.instID[0][lane] = RTC_INVALID_GEOMETRY_ID;
+      } else {
+        valid[lane] = 0;
+      }
+    }
 
-  for (const auto & id : geometry_ids_) {
-    rtcDetachGeometry(scene_, id.first);
+    RayHitPacket<PacketSize>::intersect(valid, scene_, &rayhit);
+
+    for (std::size_t lane = 0; lane < PacketSize and packet_begin + lane < end; ++lane) {
+      horizontal_distances_[packet_begin + lane] =
+        rayhit.hit.instID[0][lane] != RTC_INVALID_GEOMETRY_ID
+          ? rayhit.ray.tfar[lane]
+          : std::numeric_limits<float>::infinity();
+    }
   }
+}
 
-  geometry_ids_.clear();
-  primitive_ptrs_.clear();
+auto Raycaster::raycastHorizontally(
+  const geometry_msgs::msg::Point & origin, std::size_t ray_count, double max_distance)
+  -> const std::vector<float> &
+{
+  rtcCommitScene(scene_);
 
+  horizontal_distances_.resize(ray_count);
+  const auto task_count = (ray_count + rays_per_task_ - 1) / rays_per_task_;
+  thread_pool_->parallelFor(task_count, [&](std::size_t task) {
+    const auto begin = task * rays_per_task_;
+    const auto end = std::min(begin + rays_per_task_, ray_count);
+    if (packet_size_ == 16) {
+      intersectHorizontally<16>(begin, end, origin, ray_count, max_distance);
+    } else {
+      intersectHorizontally<8>(begin, end, origin, ray_count, max_distance);
+    }
+  });
+  return horizontal_distances_;
+}
+
+const sensor_msgs::msg::PointCloud2 Raycaster::raycast(
+  const std::string & frame_id, const rclcpp::Time & stamp, const geometry_msgs::msg::Pose & origin,
+  double max_distance, double min_distance)
+{
   sensor_msgs::msg::PointCloud2 pointcloud_msg;
-  pcl::toROSMsg(*cloud, pointcloud_msg);
+  raycast(pointcloud_msg, frame_id, stamp, origin, max_distance, min_distance);
+  return pointcloud_msg;
+}
+
+void Raycaster::raycast(
+  sensor_msgs::msg::PointCloud2 & pointcloud_msg, const std::string & frame_id,
+  const rclcpp::Time & stamp, const geometry_msgs::msg::Pose & origin, double max_distance,
+  double min_distance)
+{
+  detected_objects_.clear();
+  detected_ids_.clear();
+  rtcCommitScene(scene_);
+
+  const auto ray_count = directions_ ? directions_->size() : 0;
+  const auto task_count = (ray_count + rays_per_task_ - 1) / rays_per_task_;
+  // Every ray owns one point slot, so tasks can write their hits without synchronization.
+  // The buffers keep their capacity between scans, so they are only allocated once.
+  pointcloud_msg.data.resize(ray_count * sizeof(PointXYZI));
+  hit_ids_.resize(ray_count);
+  task_hit_counts_.resize(task_count);
+
+  // rotate every direction into the map frame in a single vectorized pass
+  rotated_directions_.resize(ray_count);
+  if (ray_count != 0) {
+    using Array = Eigen::Map<Eigen::ArrayXf>;
+    using ConstArray = Eigen::Map<const Eigen::ArrayXf>;
+    const Eigen::Matrix3f r = math::geometry::getRotationMatrix(origin.orientation).cast<float>();
+    const ConstArray x(directions_->x.data(), ray_count);
+    const ConstArray y(directions_->y.data(), ray_count);
+    const ConstArray z(directions_->z.data(), ray_count);
+    Array(rotated_directions_.x.data(), ray_count) = r(0, 0) * x + r(0, 1) * y + r(0, 2) * z;
+    Array(rotated_directions_.y.data(), ray_count) = r(1, 0) * x + r(1, 1) * y + r(1, 2) * z;
+    Array(rotated_directions_.z.data(), ray_count) = r(2, 0) * x + r(2, 1) * y + r(2, 2) * z;
+  }
+
+  const auto data = pointcloud_msg.data.data();
+  thread_pool_->parallelFor(task_count, [&](std::size_t task) {
+    const auto begin = task * rays_per_task_;
+    const auto end = std::min(begin + rays_per_task_, ray_count);
+    task_hit_counts_[task] =
+      packet_size_ == 16
+        ? intersect<16>(data, begin, end, origin, max_distance, min_distance)
+        : intersect<8>(data, begin, end, origin, max_distance, min_distance);
+  });
+
+  std::size_t hit_count = 0;
+  for (std::size_t task = 0; task < task_count; ++task) {
+    const auto begin = task * rays_per_task_;
+    if (hit_count != begin) {
+      std::memmove(
+        data + hit_count * sizeof(PointXYZI), data + begin * sizeof(PointXYZI),
+        task_hit_counts_[task] * sizeof(PointXYZI));
+    }
+    for (std::size_t i = begin; i < begin + task_hit_counts_[task]; ++i) {
+      if (
+        hit_ids_[i] != point_cloud_map_geometry_id_ and detected_ids_.insert(hit_ids_[i]).second) {
+        detected_objects_.emplace_back(geometry_ids_.at(hit_ids_[i]));
+      }
+    }
+    hit_count += task_hit_counts_[task];
+  }
+  pointcloud_msg.data.resize(hit_count * sizeof(PointXYZI));
+
+  static const std::vector<sensor_msgs::msg::PointField> fields = {
+    makePointField("x", offsetof(PointXYZI, x)),
+    makePointField("y", offsetof(PointXYZI, y)),
+    makePointField("z", offsetof(PointXYZI, z)),
+    makePointField("intensity", offsetof(PointXYZI, intensity))};
   pointcloud_msg.header.frame_id = frame_id;
   pointcloud_msg.header.stamp = stamp;
-  return pointcloud_msg;
+  pointcloud_msg.height = 1;
+  pointcloud_msg.width = hit_count;
+  pointcloud_msg.fields = fields;
+  pointcloud_msg.is_bigendian = false;
+  pointcloud_msg.point_step = sizeof(PointXYZI);
+  pointcloud_msg.row_step = hit_count * sizeof(PointXYZI);
+  pointcloud_msg.is_dense = true;
 }
 }  // namespace simple_sensor_simulator
@@ -12,14 +12,25 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <boost/geometry.hpp>
-#include <geometry/quaternion/get_rotation_matrix.hpp>
-#include <rclcpp/rclcpp.hpp>
-#include <simple_sensor_simulator/sensor_simulation/occupancy_grid/grid_traversal.hpp>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <simple_sensor_simulator/sensor_simulation/occupancy_grid/occupancy_grid_builder.hpp>
+#include <stdexcept>
+#include <string>
 
 namespace simple_sensor_simulator
 {
+namespace
+{
+// marks of `marker_grid_`, see its description
+constexpr int32_t occupied_mark = 1 << 16;
+constexpr int32_t invisible_mark = 1;
+
+auto cross(double px, double py, double qx, double qy) { return px * qy - py * qx; }
+}  // namespace
+
 OccupancyGridBuilder::OccupancyGridBuilder(
   double resolution, size_t height, size_t width, int8_t occupied_cost, int8_t invisible_cost)
 : resolution(resolution),
@@ -29,210 +40,254 @@ OccupancyGridBuilder::OccupancyGridBuilder(
   occupied_cost(occupied_cost),
   invisible_cost(invisible_cost),
 
-  occupied_grid_(height * width),
-  invisible_grid_(height * width),
+  marker_grid_(height * width),
   values_(height * width),
 
-  min_cols_(height),
-  max_cols_(height)
+  min_xs_(height),
+  max_xs_(height)
 {
 }
 
-auto OccupancyGridBuilder::transformToGrid(const PointType & p) const -> PointType
+auto OccupancyGridBuilder::transformToCell(const PointType & p) const -> CellPoint
 {
-  using Quat = Eigen::Quaterniond;
-  using Vec3 = Eigen::Vector3d;
-  const auto & r = origin_.orientation;
   const auto & o = origin_.position;
   const auto np =
-    (Quat(r.w, r.x, r.y, r.z).conjugate() * Vec3(p.x, p.y, p.z) - Vec3(o.x, o.y, o.z)).eval();
-  return makePoint(np.x(), np.y(), np.z());
-}
-
-auto OccupancyGridBuilder::transformToPixel(const PointType & p) const -> PointType
-{
-  using Vec2 = Eigen::Vector2d;
-  const auto np = ((Vec2(p.x, p.y) + Vec2(width, height) * resolution / 2) / resolution).eval();
-  return makePoint(np.x(), np.y());
+    (inverse_rotation_ * Eigen::Vector3d(p.x, p.y, p.z) - Eigen::Vector3d(o.x, o.y, o.z)).eval();
+  return {np.x() / resolution, np.y() / resolution};
 }
 
-auto OccupancyGridBuilder::makePoint(double x, double y, double z) const -> PointType
+auto OccupancyGridBuilder::clip(PolygonType & polygon) -> void
 {
-  auto res = PointType();
-  res.x = x, res.y = y, res.z = z;
-  return res;
-}
-
-auto OccupancyGridBuilder::makeOccupiedArea(const PrimitiveType & primitive) const -> PolygonType
-{
-  namespace bg = boost::geometry;
-  using Point = bg::model::d2::point_xy<double>;
-  using Ring = bg::model::ring<Point>;
-
-  // Generate a polygon of given primitive
-  auto primitive_ring = Ring();
-  for (auto & e : primitive.get2DConvexHull()) {
-    auto p = transformToGrid(e);
-    primitive_ring.emplace_back(p.x, p.y);
-  }
+  // Sutherland-Hodgman algorithm against the four edges of the grid. The edges are axis-aligned,
+  // so every intersection is computed in closed form.
+  const auto clipAgainst = [&](auto inside, auto intersect) {
+    clipping_buffer_.clear();
+    for (size_t i = 0; i < polygon.size(); ++i) {
+      const auto & p = polygon[i];
+      const auto & q = polygon[(i + 1) % polygon.size()];
+      if (inside(p)) {
+        clipping_buffer_.push_back(p);
+        if (not inside(q)) {
+          clipping_buffer_.push_back(intersect(p, q));
+        }
+      } else if (inside(q)) {
+        clipping_buffer_.push_back(intersect(p, q));
+      }
+    }
+    std::swap(polygon, clipping_buffer_);
+  };
 
-  const auto real_width = width * resolution / 2;
-  const auto real_height = height * resolution / 2;
+  const auto alongX = [](double x) {
+    return [x](const CellPoint & p, const CellPoint & q) {
+      return CellPoint{x, p.y + (q.y - p.y) * (x - p.x) / (q.x - p.x)};
+    };
+  };
 
-  auto grid_ring = Ring{
-    {+real_width, +real_height},  // top right
-    {+real_width, -real_height},  // bottom right
-    {-real_width, -real_height},  // bottom left
-    {-real_width, +real_height},  // top left
+  const auto alongY = [](double y) {
+    return [y](const CellPoint & p, const CellPoint & q) {
+      return CellPoint{p.x + (q.x - p.x) * (y - p.y) / (q.y - p.y), y};
+    };
   };
 
-  // Clip a polygon to fit into grid area
-  auto intersection_polygon = std::vector<Ring>();
-  bg::intersection(primitive_ring, grid_ring, intersection_polygon);
+  const double half_width = 0.5 * width;
+  const double half_height = 0.5 * height;
 
-  auto result = PolygonType();
-  if (not intersection_polygon.empty()) {
-    // If a polygon intersects the occupancy grid area, `intersection_polygon` will have
-    // just one `Ring` so accessing a polygon via `front()` should be sufficient
-    for (auto & p : intersection_polygon.front()) {
-      result.emplace_back(makePoint(p.x(), p.y()));
-    }
+  // clang-format off
+  clipAgainst([&](const CellPoint & p) { return p.x >= -half_width;  }, alongX(-half_width));
+  clipAgainst([&](const CellPoint & p) { return p.x <= +half_width;  }, alongX(+half_width));
+  clipAgainst([&](const CellPoint & p) { return p.y >= -half_height; }, alongY(-half_height));
+  clipAgainst([&](const CellPoint & p) { return p.y <= +half_height; }, alongY(+half_height));
+  // clang-format on
+}
+
+auto OccupancyGridBuilder::makeOccupiedArea(const PrimitiveType & primitive) -> void
+{
+  occupied_area_.clear();
+  for (const auto & p : primitive.get2DConvexHull()) {
+    occupied_area_.push_back(transformToCell(p));
   }
-  return result;
+  clip(occupied_area_);
 }
 
-auto OccupancyGridBuilder::makeInvisibleArea(const PolygonType & occupied_polygon) const
-  -> PolygonType
+auto OccupancyGridBuilder::makeInvisibleArea() -> void
 {
-  if (occupied_polygon.empty()) {
-    return {};
+  invisible_area_.clear();
+
+  if (occupied_area_.empty()) {
+    return;
   }
 
-  const auto real_width = width * resolution / 2;
-  const auto real_height = height * resolution / 2;
+  const double half_width = 0.5 * width;
+  const double half_height = 0.5 * height;
 
-  auto corners = PolygonType{
-    makePoint(-real_width, -real_height),  // bottom left
-    makePoint(+real_width, -real_height),  // bottom right
-    makePoint(+real_width, +real_height),  // top right
-    makePoint(-real_width, +real_height),  // top left
+  // counterclockwise from the top right corner
+  const CellPoint corners[] = {
+    {+half_width, +half_height},
+    {-half_width, +half_height},
+    {-half_width, -half_height},
+    {+half_width, -half_height},
   };
 
   {
-    // Treat the entire occupancy grid area as invisible if `occupied_polygon`
-    // covers the origin of the grid
-    bool overlap_origin = true;
-    for (size_t i = 0; i < occupied_polygon.size(); ++i) {
-      const auto & p = occupied_polygon[i];
-      const auto & q = occupied_polygon[(i + 1) % occupied_polygon.size()];
-      overlap_origin &= p.x * q.y - q.x * p.y < 0;
+    // The sum of the cross products of the edges is twice the signed area of the polygon. Treat the
+    // entire occupancy grid area as invisible if `occupied_area_` covers the origin of the grid,
+    // which is the case if no edge turns against the orientation of the polygon
+    double area = 0;
+    bool has_left_turn = false, has_right_turn = false;
+    for (size_t i = 0; i < occupied_area_.size(); ++i) {
+      const auto & p = occupied_area_[i];
+      const auto & q = occupied_area_[(i + 1) % occupied_area_.size()];
+      const auto c = cross(p.x, p.y, q.x, q.y);
+      area += c;
+      has_left_turn |= c > 0;
+      has_right_turn |= c < 0;
+    }
+    if (constexpr double epsilon = 1e-9; std::abs(area) < epsilon) {
+      // `occupied_area_` only touches the boundary of the grid and covers no cell
+      occupied_area_.clear();
+      return;
+    }
+    if (area > 0 ? not has_right_turn : not has_left_turn) {
+      invisible_area_.assign(std::begin(corners), std::end(corners));
+      return;
     }
-    if (overlap_origin) return corners;
   }
 
-  // Calculate an intersection point between grid edges and a line
-  // pass through the origin and a given point
-  const auto projection = [&](const PointType & p, size_t i) -> PointType {
-    switch (i % 4) {
-      default:
-        return makePoint(-real_width, p.y * -real_width / p.x);  // left
-      case 1:
-        return makePoint(p.x * -real_height / p.y, -real_height);  // bottom
-      case 2:
-        return makePoint(+real_width, p.y * +real_width / p.x);  // right
-      case 3:
-        return makePoint(p.x * +real_height / p.y, +real_height);  // top
+  // The origin is outside of the convex polygon, so the polygon is seen within an angle smaller
+  // than \pi and the cross product orders its vertices by angle. `first` and `last` are the
+  // vertices seen at the smallest and the largest angle, that is, the tangent points of the shadow.
+  auto first = occupied_area_.front();
+  auto last = occupied_area_.front();
+  for (const auto & p : occupied_area_) {
+    if (cross(first.x, first.y, p.x, p.y) < 0) {
+      first = p;
     }
-  };
-
-  auto res = PolygonType();
-  {
-    auto angle = [](const PointType & p) { return std::atan2(p.y, p.x); };
-
-    // Find a minimum and a maximum point in polygons by comparing angles with range [-\pi, \pi].
-    auto min_max_p = std::minmax_element(
-      occupied_polygon.begin(), occupied_polygon.end(),
-      [&](const PointType & p, const PointType & q) { return angle(p) < angle(q); });
-
-    // If a polygon overlaps a line \theta = \pi, change angle range to [0, 2\pi]
-    // and find those points again.
-    if (auto [min_p, max_p] = min_max_p; angle(*max_p) - angle(*min_p) > M_PI) {
-      min_max_p = std::minmax_element(
-        occupied_polygon.begin(), occupied_polygon.end(),
-        [&](const PointType & p, const PointType & q) {
-          auto adjust = [](double theta) { return theta < 0 ? theta + 2 * M_PI : theta; };
-          return adjust(angle(p)) < adjust(angle(q));
-        });
+    if (cross(last.x, last.y, p.x, p.y) > 0) {
+      last = p;
     }
+  }
 
-    auto [min_p, max_p] = min_max_p;
-    double min_ang = angle(*min_p);
-    double max_ang = angle(*max_p);
-    if (min_ang > max_ang) max_ang += 2 * M_PI;
+  // Calculate an intersection point between grid edges and a line pass through the origin and
+  // a given point
+  const auto projection = [&](const CellPoint & p) {
+    const auto t = std::min(half_width / std::abs(p.x), half_height / std::abs(p.y));
+    return CellPoint{t * p.x, t * p.y};
+  };
 
-    // Construct a polygon of invisible area
-    // Note that lines below are order-sensitive so be careful when you try to modify
-    size_t i = 0;
-    for (; angle(corners[i % 4]) + 2 * M_PI * (i / 4) <= min_ang; ++i) {
+  // Construct a polygon of invisible area counterclockwise. Corners strictly between the two
+  // tangents are at most two, since the tangents are less than \pi apart.
+  invisible_area_.push_back(first);
+  invisible_area_.push_back(projection(first));
+  const auto corners_begin = invisible_area_.size();
+  for (const auto & corner : corners) {
+    if (
+      cross(first.x, first.y, corner.x, corner.y) > 0 and
+      cross(corner.x, corner.y, last.x, last.y) > 0) {
+      invisible_area_.push_back(corner);
     }
-    // First, add minimum angle point and its projection point.
-    res.emplace_back(*min_p);
-    res.emplace_back(projection(*min_p, i));
-
-    // Next, add grid corners between a minimum and a maximum angle point.
-    for (; angle(corners[i % 4]) + 2 * M_PI * (i / 4) < max_ang; ++i) {
-      res.emplace_back(corners[i % 4]);
+  }
+  if (invisible_area_.size() == corners_begin + 2) {
+    const auto & p = invisible_area_[corners_begin];
+    const auto & q = invisible_area_[corners_begin + 1];
+    if (cross(p.x, p.y, q.x, q.y) < 0) {
+      std::swap(invisible_area_[corners_begin], invisible_area_[corners_begin + 1]);
     }
-
-    // Finally, add a projection point of maximum angle point and itself.
-    res.emplace_back(projection(*max_p, i));
-    res.emplace_back(*max_p);
   }
-  return res;
+  invisible_area_.push_back(projection(last));
+  invisible_area_.push_back(last);
 }
 
-auto OccupancyGridBuilder::addPolygon(MarkerGridType & grid, const PolygonType & convex_hull)
-  -> void
+auto OccupancyGridBuilder::addPolygon(const PolygonType & convex_hull, int32_t mark) -> void
 {
-  // This function assumes a given polygon is a convex hull and marks only edges
-  // of the polygon. This makes performance of an occupancy grid generation
-  // tolerant of an increasing number of primitives.
+  // This function assumes a given polygon is convex and only computes the horizontal extent of the
+  // polygon in each row it spans. This makes performance of an occupancy grid generation tolerant
+  // of an increasing number of primitives.
+  if (convex_hull.empty()) {
+    return;
+  }
 
-  min_cols_.assign(min_cols_.size(), width);  // Leftmost marked cells of each rows
-  max_cols_.assign(max_cols_.size(), -1);     // Rightmost marked cells of each rows
+  const double half_width = 0.5 * width;
+  const double half_height = 0.5 * height;
+
+  // Truncation differs from flooring only below zero, where both are clamped to the first cell
+  const auto toRow = [&](double y) {
+    return std::clamp(static_cast<int32_t>(y + half_height), 0, int32_t(height) - 1);
+  };
 
-  // Traverse each polygon edges on grid coordinate and update `min_cols_` and `max_cols_`
+  const auto toCol = [&](double x) {
+    return std::clamp(static_cast<int32_t>(x + half_width), 0, int32_t(width) - 1);
+  };
+
+  const auto [lowest, highest] = std::minmax_element(
+    convex_hull.begin(), convex_hull.end(),
+    [](const CellPoint & p, const CellPoint & q) { return p.y < q.y; });
+  const auto row_begin = toRow(lowest->y);
+  const auto row_end = toRow(highest->y) + 1;
+
+  constexpr auto infinity = std::numeric_limits<double>::infinity();
+  std::fill(min_xs_.begin() + row_begin, min_xs_.begin() + row_end, +infinity);
+  std::fill(max_xs_.begin() + row_begin, max_xs_.begin() + row_end, -infinity);
+
+  // A convex polygon is bounded by a chain of rising edges on one side and a chain of falling
+  // edges on the other, so each edge only has to update one side of the rows it spans.
+  double area = 0;
   for (size_t i = 0; i < convex_hull.size(); ++i) {
-    const auto p = transformToPixel(convex_hull[i]);
-    const auto q = transformToPixel(convex_hull[(i + 1) % convex_hull.size()]);
-    for (auto [col, row] : GridTraversal(p.x, p.y, q.x, q.y)) {
-      if (row >= 0 && row < int32_t(height)) {
-        min_cols_[row] = std::min(min_cols_[row], col);
-        max_cols_[row] = std::max(max_cols_[row], col);
-      }
-    }
+    const auto & p = convex_hull[i];
+    const auto & q = convex_hull[(i + 1) % convex_hull.size()];
+    area += cross(p.x, p.y, q.x, q.y);
   }
 
-  // Put marked cells on the occupancy grid
-  for (size_t row = 0; row < height; ++row) {
-    auto min_col = min_cols_[row];
-    auto max_col = max_cols_[row] + 1;
+  const auto updateMin = [&](int32_t row, double x0, double x1) {
+    min_xs_[row] = std::min(min_xs_[row], std::min(x0, x1));
+  };
+
+  const auto updateMax = [&](int32_t row, double x0, double x1) {
+    max_xs_[row] = std::max(max_xs_[row], std::max(x0, x1));
+  };
 
-    // do not care the outside of the occupancy grid
-    if (max_col <= 0 || min_col >= int32_t(width)) {
-      continue;
+  const auto updateEdge = [&](CellPoint p, CellPoint q, auto update) {
+    if (p.y > q.y) {
+      std::swap(p, q);
     }
+    if (const auto first_row = toRow(p.y), last_row = toRow(q.y); first_row == last_row) {
+      update(first_row, p.x, q.x);
+    } else {
+      // Each row gets the end points of the part of the edge within the row
+      const auto slope = (q.x - p.x) / (q.y - p.y);
+      const auto xAt = [&](double y) { return p.x + (y - p.y) * slope; };
+      auto x = xAt(first_row + 1 - half_height);
+      update(first_row, p.x, x);
+      for (auto row = first_row + 1; row < last_row; ++row) {
+        const auto next_x = xAt(row + 1 - half_height);
+        update(row, x, next_x);
+        x = next_x;
+      }
+      update(last_row, x, q.x);
+    }
+  };
 
-    // Increment the leftmost grid cell values
-    if (min_col <= 0) {
-      ++grid[width * row];
+  for (size_t i = 0; i < convex_hull.size(); ++i) {
+    const auto & p = convex_hull[i];
+    const auto & q = convex_hull[(i + 1) % convex_hull.size()];
+    if (p.y == q.y) {
+      updateMin(toRow(p.y), p.x, q.x);
+      updateMax(toRow(p.y), p.x, q.x);
+    } else if ((p.y < q.y) == (area > 0)) {
+      updateEdge(p, q, updateMax);
     } else {
-      ++grid[width * row + min_col];
+      updateEdge(p, q, updateMin);
     }
+  }
 
-    // Decrement the leftmost grid cell values
-    if (max_col < int32_t(width)) {
-      --grid[width * row + max_col];
+  // Put the differences of the marked cells on the occupancy grid
+  for (auto row = row_begin; row < row_end; ++row) {
+    if (min_xs_[row] <= max_xs_[row]) {
+      const auto min_col = toCol(min_xs_[row]);
+      const auto max_col = toCol(max_xs_[row]) + 1;
+      marker_grid_[width * row + min_col] += mark;
+      if (max_col < int32_t(width)) {
+        marker_grid_[width * row + max_col] -= mark;
+      }
     }
   }
 
@@ -252,49 +307,137 @@ auto OccupancyGridBuilder::addPolygon(MarkerGridType & grid, const PolygonType &
   //  0  0  0  0  0  0  0  0
 }
 
-auto OccupancyGridBuilder::add(const PrimitiveType & primitive) -> void
+auto OccupancyGridBuilder::countPrimitive() -> void
 {
-  {
-    constexpr auto count_max = std::numeric_limits<MarkerCounterType>::max();
-    if (primitive_count_++ == count_max) {
-      throw std::runtime_error(
-        "Grid cannot hold more than " + std::to_string(count_max) + " primitives");
-    }
+  constexpr auto count_max = std::numeric_limits<MarkerCounterType>::max();
+  if (primitive_count_++ == count_max) {
+    throw std::runtime_error(
+      "Grid cannot hold more than " + std::to_string(count_max) + " primitives");
   }
+}
 
-  auto occupied_area = makeOccupiedArea(primitive);
+auto OccupancyGridBuilder::add(const PrimitiveType & primitive) -> void
+{
+  countPrimitive();
+
+  makeOccupiedArea(primitive);
 
-  auto invisible_area = makeInvisibleArea(occupied_area);
+  makeInvisibleArea();
 
   // mark invisible area
-  addPolygon(invisible_grid_, invisible_area);
+  addPolygon(invisible_area_, invisible_mark);
 
   // mark occupied area
-  addPolygon(occupied_grid_, occupied_area);
+  addPolygon(occupied_area_, occupied_mark);
 }
 
-auto OccupancyGridBuilder::build() -> void
+auto OccupancyGridBuilder::addOccupiedArea(const PrimitiveType & primitive) -> void
 {
-  // https://imoz.jp/algorithms/imos_method.html (Japanese)
+  countPrimitive();
 
-  // We can make prefix sum calculation faster by unrolling for loop and
-  // tweaking compiler options, but, as far as I run this code locally,
-  // it takes about 200us for 400x400 grids and I think it is sufficient,
-  // so I leave this naive implementation.
-  for (size_t row = 0; row < height; ++row) {
-    for (size_t col = 0; col + 1 < width; ++col) {
-      invisible_grid_[row * width + col + 1] += invisible_grid_[row * width + col];
+  makeOccupiedArea(primitive);
+
+  // mark occupied area
+  addPolygon(occupied_area_, occupied_mark);
+}
+
+auto OccupancyGridBuilder::addVisibleArea(const std::vector<float> & distances, double max_distance)
+  -> void
+{
+  // Every ray adds a triangle that covers the origin, so the cell at the origin counts all of them
+  if (constexpr size_t count_max = occupied_mark - 1; distances.size() > count_max) {
+    throw std::runtime_error(
+      "Grid cannot hold more than " + std::to_string(count_max) + " rays");
+  }
+
+  has_visible_area_ = true;
+
+  // At least three rays are needed for the triangles between them to surround the origin
+  if (distances.size() < 3) {
+    return;
+  }
+
+  const double half_width = 0.5 * width;
+  const double half_height = 0.5 * height;
+
+  const auto end = [&](size_t i) {
+    const auto yaw = 2 * M_PI * i / distances.size();
+    const auto distance = std::min(static_cast<double>(distances[i]), max_distance) / resolution;
+    return CellPoint{distance * std::cos(yaw), distance * std::sin(yaw)};
+  };
+
+  /*
+     The area between two neighboring rays is seen up to where they end, so the visible area is the
+     fan of the triangles between the origin and the ends of each pair of neighboring rays. Runs of
+     triangles that together form a convex polygon are marked at once, which merges the rays ending
+     on the same flat face or at `max_distance` into a few polygons.
+  */
+  const auto flush = [&]() {
+    clip(visible_area_);
+    addPolygon(visible_area_, invisible_mark);
+  };
+  auto previous_end = end(distances.size() - 1);
+  auto current_end = end(0);
+  visible_area_.assign({CellPoint{0, 0}, previous_end, current_end});
+  for (size_t i = 1; i <= distances.size(); ++i) {
+    const auto next_end = i < distances.size() ? end(i) : end(0);
+    const auto turns_right =
+      cross(
+        current_end.x - previous_end.x, current_end.y - previous_end.y,
+        next_end.x - current_end.x, next_end.y - current_end.y) < 0;
+    // the polygon is convex as long as it turns left at every ray end and spans less than \pi
+    const auto spans_pi =
+      cross(visible_area_[1].x, visible_area_[1].y, next_end.x, next_end.y) <= 0;
+    if (turns_right or spans_pi) {
+      flush();
+      visible_area_.assign({CellPoint{0, 0}, current_end, next_end});
+    } else {
+      visible_area_.push_back(next_end);
     }
+    previous_end = current_end;
+    current_end = next_end;
   }
+  flush();
+
+  // mark the cells where the rays hit something, which are set as occupied in `build`
+  for (size_t i = 0; i < distances.size(); ++i) {
+    if (distances[i] <= max_distance) {
+      if (const auto p = end(i); std::abs(p.x) < half_width and std::abs(p.y) < half_height) {
+        const auto row = static_cast<size_t>(p.y + half_height);
+        const auto col = static_cast<size_t>(p.x + half_width);
+        hit_cells_.push_back(std::min(row, height - 1) * width + std::min(col, width - 1));
+      }
+    }
+  }
+}
 
+auto OccupancyGridBuilder::build() -> void
+{
+  // https://imoz.jp/algorithms/imos_method.html (Japanese)
+
+  // The prefix sum of a row is a chain of dependent additions, but the classification of the cells
+  // is independent for each cell and written so that the compiler vectorizes it. The costs are
+  // copied to locals since the stores to `values_` could otherwise alias them.
+  const auto occupied_value = occupied_cost;
+  const auto invisible_value = invisible_cost;
+  // the lower 16 bits count visible areas instead of invisible ones
+  const auto counts_visible_area = has_visible_area_;
   for (size_t row = 0; row < height; ++row) {
-    for (size_t col = 0; col + 1 < width; ++col) {
-      occupied_grid_[row * width + col + 1] += occupied_grid_[row * width + col];
+    int32_t * const markers = marker_grid_.data() + row * width;
+    int8_t * const values = values_.data() + row * width;
+    int32_t sum = 0;
+    for (size_t col = 0; col < width; ++col) {
+      markers[col] = sum += markers[col];
+    }
+    for (size_t col = 0; col < width; ++col) {
+      const auto occupied = markers[col] >= occupied_mark;
+      const auto invisible = ((markers[col] & (occupied_mark - 1)) != 0) != counts_visible_area;
+      values[col] = occupied ? occupied_value : invisible ? invisible_value : int8_t(0);
     }
   }
 
-  for (size_t i = 0; i < height * width; ++i) {
-    values_[i] = occupied_grid_[i] ? occupied_cost : invisible_grid_[i] ? invisible_cost : 0;
+  for (const auto cell : hit_cells_) {
+    values_[cell] = occupied_value;
   }
 }
 
@@ -303,9 +446,12 @@ auto OccupancyGridBuilder::get() const -> const OccupancyGridType & { return val
 auto OccupancyGridBuilder::reset(const PoseType & origin) -> void
 {
   origin_ = origin;
+  const auto & r = origin.orientation;
+  inverse_rotation_ = Eigen::Quaterniond(r.w, r.x, r.y, r.z).conjugate().toRotationMatrix();
   primitive_count_ = 0;
-  invisible_grid_.assign(invisible_grid_.size(), 0);
-  occupied_grid_.assign(occupied_grid_.size(), 0);
+  has_visible_area_ = false;
+  hit_cells_.clear();
+  std::fill(marker_grid_.begin(), marker_grid_.end(), 0);
 }
 
 }  // namespace simple_sensor_simulator
@@ -13,7 +13,10 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <geometry/quaternion/get_rotation_matrix.hpp>
+#include <limits>
 #include <memory>
 #include <nav_msgs/msg/occupancy_grid.hpp>
 #include <optional>
@@ -21,12 +24,12 @@
 #include <simple_sensor_simulator/sensor_simulation/occupancy_grid/occupancy_grid_sensor.hpp>
 #include <simulation_interface/conversions.hpp>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace simple_sensor_simulator
 {
-geometry_msgs::Pose OccupancyGridSensorBase::getSensorPose(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & status) const
+geometry_msgs::Pose OccupancyGridSensorBase::getSensorPose(const EntityStatusView & status) const
 {
   for (const auto & s : status) {
     if (
@@ -38,17 +41,22 @@ geometry_msgs::Pose OccupancyGridSensorBase::getSensorPose(
   throw SimulationRuntimeError("Occupancy grid sensor can be attached only ego entity.");
 }
 
+auto OccupancyGridSensorBase::getRange() const -> double
+{
+  const auto half_diagonal =
+    0.5 * std::hypot(configuration_.height(), configuration_.width()) * configuration_.resolution();
+  return configuration_.filter_by_range() ? std::min(half_diagonal, configuration_.range())
+                                          : half_diagonal;
+}
+
 const std::vector<std::string> OccupancyGridSensorBase::getDetectedObjects(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & status,
-  const std::vector<std::string> & lidar_detected_entities) const
+  const EntityStatusView & status,
+  const std::unordered_set<std::string> & lidar_detected_entities) const
 {
   std::vector<std::string> detected_entities;
   const auto pose = getSensorPose(status);
   for (const auto & s : status) {
-    if (const auto has_detected =
-          std::find(lidar_detected_entities.begin(), lidar_detected_entities.end(), s.name()) !=
-          lidar_detected_entities.end();
-        !has_detected) {
+    if (const auto has_detected = lidar_detected_entities.count(s.name()) != 0; !has_detected) {
       continue;
     }
 
@@ -64,8 +72,9 @@ const std::vector<std::string> OccupancyGridSensorBase::getDetectedObjects(
 
 template <>
 auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
-  const std::vector<traffic_simulator_msgs::EntityStatus> & status, const rclcpp::Time & stamp,
-  const std::vector<std::string> & lidar_detected_entities) -> nav_msgs::msg::OccupancyGrid
+  const EntityStatusView & status, const rclcpp::Time & stamp,
+  const std::unordered_set<std::string> & lidar_detected_entities)
+  -> nav_msgs::msg::OccupancyGrid
 {
   // check if entities in `status` have unique names
   {
@@ -83,6 +92,7 @@ auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
 
   // find ego from `status` and get its pose with north side up
   auto ego_pose_north_up = geometry_msgs::msg::Pose();
+  auto ego_center = geometry_msgs::msg::Point();
   {
     auto is_ego = [&](const auto & s) { return configuration_.entity() == s.name(); };
     auto ego = std::find_if(status.begin(), status.end(), is_ego);
@@ -90,6 +100,7 @@ auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
       throw SimulationRuntimeError("Failed to calculate ego pose with north up.");
     }
     simulation_interface::toMsg(ego->pose(), ego_pose_north_up);
+    simulation_interface::toMsg(ego->bounding_box().center(), ego_center);
     /**
      * @note
      * There is no problem with the yaw axis being north-up, but unless the pitch and roll axes are
@@ -113,6 +124,25 @@ auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
 
   // construct an occupancy grid
   builder_.reset(ego_pose_north_up);
+  if (raycaster_) {
+    /*
+       Rays are cast on the horizontal plane through the center of the bounding box of ego, where
+       they pass over the ground of the pointcloud map. Ray ends are at most one cell apart on the
+       circle through the corners of the grid, so no cell falls between two rays. The grid is
+       north up, so the yaw of each ray in the map frame is also its angle in the grid.
+    */
+    const auto max_distance = 0.5 * std::hypot(configuration_.height(), configuration_.width()) *
+                              configuration_.resolution();
+    // the builder counts the rays covering each cell in 16 bits
+    const auto ray_count = std::clamp<std::size_t>(
+      static_cast<std::size_t>(std::ceil(2 * M_PI * max_distance / configuration_.resolution())),
+      3, std::numeric_limits<std::uint16_t>::max());
+    auto origin = ego_pose_north_up.position;
+    origin.z += ego_center.z;
+    raycaster_->updatePrimitives(status, configuration_.entity(), shares_raycaster_);
+    builder_.addVisibleArea(
+      raycaster_->raycastHorizontally(origin, ray_count, max_distance), max_distance);
+  }
   for (const auto & s : status) {
     if (configuration_.entity() != s.name()) {
       // skip if entity is not actually detected
@@ -134,7 +164,11 @@ auto OccupancyGridSensor<nav_msgs::msg::OccupancyGrid>::getOccupancyGrid(
       }
 
       const auto & v = s.bounding_box().dimensions();
-      builder_.add(primitives::Box(v.x(), v.y(), v.z(), pose));
+      if (raycaster_) {
+        builder_.addOccupiedArea(primitives::Box(v.x(), v.y(), v.z(), pose));
+      } else {
+        builder_.add(primitives::Box(v.x(), v.y(), v.z(), pose));
+      }
     }
   }
   builder_.build();
@@ -113,9 +113,19 @@ std::vector<geometry_msgs::msg::Point> Primitive::get2DConvexHull() const
 }
 
 unsigned int Primitive::addToScene(RTCDevice device, RTCScene scene)
+{
+  return attachMesh(device, scene, transform());
+}
+
+unsigned int Primitive::addLocalGeometryToScene(RTCDevice device, RTCScene scene) const
+{
+  return attachMesh(device, scene, vertices_);
+}
+
+unsigned int Primitive::attachMesh(
+  RTCDevice device, RTCScene scene, const std::vector<Vertex> & transformed_vertices) const
 {
   RTCGeometry mesh = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
-  const auto transformed_vertices = transform();
   Vertex * vertices = static_cast<Vertex *>(rtcSetNewGeometryBuffer(
     mesh, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, sizeof(Vertex),
     transformed_vertices.size()));
@@ -12,42 +12,179 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cctype>
+#include <functional>
 #include <memory>
+#include <simple_sensor_simulator/exception.hpp>
 #include <simple_sensor_simulator/sensor_simulation/sensor_simulation.hpp>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace simple_sensor_simulator
 {
+auto SensorSimulation::addEgo(const std::string & entity) -> std::string
+{
+  if (const auto iter = entity_topic_namespaces_.find(entity);
+      iter != entity_topic_namespaces_.end()) {
+    return topic_namespace_ + iter->second;
+  }
+  auto topic_namespace = std::string();
+  if (not entity_topic_namespaces_.empty()) {
+    // a topic name token is made of alphanumerics and underscores, and does not begin with a digit
+    topic_namespace = "/";
+    if (entity.empty() or std::isdigit(static_cast<unsigned char>(entity.front()))) {
+      topic_namespace += '_';
+    }
+    for (const auto c : entity) {
+      topic_namespace += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+  }
+  for (const auto & [other, other_namespace] : entity_topic_namespaces_) {
+    if (other_namespace == topic_namespace) {
+      throw SimulationRuntimeError(
+        ("Egos \"" + entity + "\" and \"" + other + "\" would share the namespace \"" +
+         topic_namespace_ + topic_namespace + "\"")
+          .c_str());
+    }
+  }
+  return topic_namespace_ + entity_topic_namespaces_.emplace(entity, topic_namespace).first->second;
+}
+
+auto SensorSimulation::getFrameId(const std::string & entity, const std::string & frame_id) const
+  -> std::string
+{
+  const auto iter = entity_topic_namespaces_.find(entity);
+  const auto topic_namespace =
+    topic_namespace_ + (iter != entity_topic_namespaces_.end() ? iter->second : "");
+  // prefixed without the leading slash, as frame IDs are
+  if (topic_namespace.empty()) {
+    return frame_id;
+  } else {
+    return topic_namespace.substr(1) + "/" + frame_id;
+  }
+}
+
+auto SensorSimulation::clear() -> void
+{
+  entity_topic_namespaces_.clear();
+  point_cloud_map_.reset();
+  imu_sensors_.clear();
+  lidar_sensors_.clear();
+  detection_sensors_.clear();
+  occupancy_grid_sensors_.clear();
+  traffic_lights_detectors_.clear();
+}
+
+auto SensorSimulation::setRaycaster(OccupancyGridSensorBase & occupancy_grid_sensor) -> void
+{
+  const auto is_shared = [&](const std::shared_ptr<Raycaster> & raycaster) {
+    return std::any_of(
+      occupancy_grid_sensors_.begin(), occupancy_grid_sensors_.end(),
+      [&](const auto & sensor) { return sensor->getRaycaster() == raycaster; });
+  };
+
+  for (const auto & lidar_sensor : lidar_sensors_) {
+    if (
+      lidar_sensor->getEntity() == occupancy_grid_sensor.getEntity() and
+      not is_shared(lidar_sensor->getRaycaster())) {
+      occupancy_grid_sensor.setRaycaster(lidar_sensor->getRaycaster(), true);
+      return;
+    }
+  }
+
+  auto raycaster = std::make_shared<Raycaster>(thread_pool_);
+  raycaster->setPointCloudMap(point_cloud_map_);
+  occupancy_grid_sensor.setRaycaster(raycaster, false);
+}
+
 auto SensorSimulation::updateSensorFrame(
   double current_simulation_time, const rclcpp::Time & current_ros_time,
   const std::vector<traffic_simulator_msgs::EntityStatus> & entities,
-  const simulation_api_schema::UpdateTrafficLightsRequest & update_traffic_lights_request) -> void
+  const simulation_api_schema::UpdateTrafficLightsRequest & update_traffic_lights_request,
+  const EntityGrid & entity_grid) -> void
 {
-  for (auto & sensor : imu_sensors_) {
-    sensor->update(current_ros_time, entities);
+  std::unordered_map<std::string, std::size_t> entity_indices;
+  entity_indices.reserve(entities.size());
+  for (std::size_t i = 0; i < entities.size(); ++i) {
+    entity_indices.emplace(entities[i].name(), i);
   }
 
-  std::vector<std::string> lidar_detected_objects = {};
-  for (auto & sensor : lidar_sensors_) {
-    sensor->update(current_simulation_time, entities, current_ros_time);
-    for (const auto & object : sensor->getDetectedObjects()) {
-      if (std::count(lidar_detected_objects.begin(), lidar_detected_objects.end(), object) == 0) {
-        lidar_detected_objects.push_back(object);
+  /*
+     Entities are kept in the order of `entities`, so sensors publish them in the same order as
+     without culling. If the sensor entity is unknown, every entity is passed on and the sensor
+     reports the missing entity as before.
+  */
+  auto entitiesInRange = [&](const std::string & sensor_entity, double range) {
+    const auto sensor_index = entity_indices.find(sensor_entity);
+    if (sensor_index == entity_indices.end() or not entity_grid.contains(sensor_entity)) {
+      return EntityStatusView(entities);
+    }
+    const auto & position = entities[sensor_index->second].pose().position();
+    std::vector<std::size_t> indices = {sensor_index->second};
+    for (const auto & name : entity_grid.query(position.x(), position.y(), range)) {
+      if (const auto iter = entity_indices.find(name); iter != entity_indices.end()) {
+        indices.push_back(iter->second);
       }
     }
-  }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return EntityStatusView(entities, std::move(indices));
+  };
 
-  for (auto & sensor : detection_sensors_) {
-    sensor->update(current_simulation_time, entities, current_ros_time, lidar_detected_objects);
+  /*
+     Sensors are updated in two stages. Every sensor owns its state, so the sensors of a stage run
+     concurrently on the thread pool. The detection and occupancy grid sensors depend on the
+     entities hit by the LiDARs, so they wait for the first stage to finish.
+  */
+  auto run = [this](const std::vector<std::function<void()>> & tasks) {
+    thread_pool_->parallelFor(tasks.size(), [&](std::size_t i) { tasks[i](); });
+  };
+
+  std::vector<std::function<void()>> tasks;
+  for (auto & sensor : imu_sensors_) {
+    tasks.emplace_back(
+      [&, sensor = sensor.get()]() { sensor->update(current_ros_time, entities); });
   }
+  for (auto & sensor : lidar_sensors_) {
+    tasks.emplace_back([&, sensor = sensor.get()]() {
+      sensor->update(
+        current_simulation_time, entitiesInRange(sensor->getEntity(), sensor->getRange()),
+        current_ros_time);
+    });
+  }
+  for (auto & sensor : traffic_lights_detectors_) {
+    tasks.emplace_back([&, sensor = sensor.get()]() {
+      sensor->updateFrame(current_ros_time, update_traffic_lights_request);
+    });
+  }
+  run(tasks);
 
-  for (auto & sensor : occupancy_grid_sensors_) {
-    sensor->update(current_simulation_time, entities, current_ros_time, lidar_detected_objects);
+  std::unordered_set<std::string> lidar_detected_objects;
+  for (const auto & sensor : lidar_sensors_) {
+    const auto & objects = sensor->getDetectedObjects();
+    lidar_detected_objects.insert(objects.begin(), objects.end());
   }
 
-  for (auto & sensor : traffic_lights_detectors_) {
-    sensor->updateFrame(current_ros_time, update_traffic_lights_request);
+  tasks.clear();
+  auto exists = [&](const std::string & name) { return entity_indices.count(name) != 0; };
+  for (auto & sensor : detection_sensors_) {
+    tasks.emplace_back([&, sensor = sensor.get()]() {
+      sensor->update(
+        current_simulation_time, entitiesInRange(sensor->getEntity(), sensor->getRange()),
+        current_ros_time, lidar_detected_objects);
+      sensor->forgetDespawnedEntities(exists);
+    });
+  }
+  for (auto & sensor : occupancy_grid_sensors_) {
+    tasks.emplace_back([&, sensor = sensor.get()]() {
+      sensor->update(
+        current_simulation_time, entitiesInRange(sensor->getEntity(), sensor->getRange()),
+        current_ros_time, lidar_detected_objects);
+    });
   }
+  run(tasks);
 }
 }  // namespace simple_sensor_simulator
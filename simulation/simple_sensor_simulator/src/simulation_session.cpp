@@ -0,0 +1,542 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <geometry_msgs/msg/pose_stamped.hpp>
+#include <limits>
+#include <memory>
+#include <rclcpp/rclcpp.hpp>
+#include <simple_sensor_simulator/exception.hpp>
+#include <simple_sensor_simulator/simulation_session.hpp>
+#include <simulation_interface/conversions.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace simple_sensor_simulator
+{
+auto SharedResources::getHdMapUtils(
+  const std::string & lanelet2_map_path, const geographic_msgs::msg::GeoPoint & origin)
+  -> std::shared_ptr<hdmap_utils::HdMapUtils>
+{
+  auto & cached = hdmap_utils_[lanelet2_map_path];
+  auto hdmap_utils = cached.lock();
+  if (not hdmap_utils) {
+    cached = hdmap_utils = std::make_shared<hdmap_utils::HdMapUtils>(lanelet2_map_path, origin);
+  }
+  return hdmap_utils;
+}
+
+auto SharedResources::getPointCloudMap(const std::string & pcd_path, float voxel_size)
+  -> std::shared_ptr<const PointCloudMap>
+{
+  auto & cached = point_cloud_maps_[std::make_pair(pcd_path, voxel_size)];
+  auto point_cloud_map = cached.lock();
+  if (not point_cloud_map) {
+    cached = point_cloud_map = std::make_shared<const PointCloudMap>(pcd_path, voxel_size);
+  }
+  return point_cloud_map;
+}
+
+SimulationSession::SimulationSession(
+  rclcpp::Node & node, std::uint32_t id, SharedResources & shared_resources)
+: node_(node),
+  shared_resources_(shared_resources),
+  sensor_sim_(shared_resources.thread_pool, id == 0 ? "" : "/session_" + std::to_string(id))
+{
+}
+
+SimulationSession::~SimulationSession()
+{
+  if (sensor_frame_future_.valid()) {
+    sensor_frame_future_.wait();
+  }
+}
+
+geographic_msgs::msg::GeoPoint SimulationSession::getOrigin()
+{
+  geographic_msgs::msg::GeoPoint origin;
+  {
+    if (!node_.has_parameter("origin_latitude")) {
+      node_.declare_parameter("origin_latitude", 0.0);
+    }
+    if (!node_.has_parameter("origin_longitude")) {
+      node_.declare_parameter("origin_longitude", 0.0);
+    }
+    node_.get_parameter("origin_latitude", origin.latitude);
+    node_.get_parameter("origin_longitude", origin.longitude);
+  }
+
+  return origin;
+}
+
+auto SimulationSession::initialize(const simulation_api_schema::InitializeRequest & req)
+  -> simulation_api_schema::InitializeResponse
+{
+  waitForSensorFrame();
+  // the sensors of a previous scenario of this session are attached to entities despawned below
+  sensor_sim_.clear();
+  traffic_signals_states_.Clear();
+  initialized_ = true;
+  realtime_factor_ = req.realtime_factor();
+  step_time_ = req.step_time();
+  current_simulation_time_ = req.initialize_time();
+  current_scenario_time_ = std::numeric_limits<double>::quiet_NaN();
+  builtin_interfaces::msg::Time t;
+  simulation_interface::toMsg(req.initialize_ros_time(), t);
+  current_ros_time_ = t;
+  hdmap_utils_ = shared_resources_.getHdMapUtils(req.lanelet2_map_path(), getOrigin());
+  traffic_simulator::lanelet_pose::CanonicalizedLaneletPose::setConsiderPoseByRoadSlope([&]() {
+    if (not node_.has_parameter("consider_pose_by_road_slope")) {
+      node_.declare_parameter("consider_pose_by_road_slope", false);
+    }
+    return node_.get_parameter("consider_pose_by_road_slope").as_bool();
+  }());
+  asynchronous_sensor_update_ = [&]() {
+    if (not node_.has_parameter("asynchronous_sensor_update")) {
+      node_.declare_parameter("asynchronous_sensor_update", false);
+    }
+    return node_.get_parameter("asynchronous_sensor_update").as_bool();
+  }();
+  sensor_sim_.setPointCloudMap([&]() -> std::shared_ptr<const PointCloudMap> {
+    if (not node_.has_parameter("raycast_pointcloud_map")) {
+      node_.declare_parameter("raycast_pointcloud_map", false);
+    }
+    if (not node_.has_parameter("pointcloud_map_voxel_size")) {
+      node_.declare_parameter("pointcloud_map_voxel_size", 0.5);
+    }
+    if (
+      node_.get_parameter("raycast_pointcloud_map").as_bool() and
+      not req.pointcloud_map_path().empty()) {
+      return shared_resources_.getPointCloudMap(
+        req.pointcloud_map_path(), node_.get_parameter("pointcloud_map_voxel_size").as_double());
+    } else {
+      return nullptr;
+    }
+  }());
+  auto res = simulation_api_schema::InitializeResponse();
+  res.mutable_result()->set_success(true);
+  res.mutable_result()->set_description("succeed to initialize simulation");
+  ego_vehicles_.clear();
+  ego_entity_simulations_.clear();
+  vehicles_.clear();
+  pedestrians_.clear();
+  misc_objects_.clear();
+  entity_status_.clear();
+  entity_handles_.clear();
+  entity_handle_by_name_.clear();
+  next_entity_handle_ = 1;
+  entity_grid_.clear();
+  return res;
+}
+
+auto SimulationSession::finalize(const simulation_api_schema::FinalizeRequest &)
+  -> simulation_api_schema::FinalizeResponse
+{
+  auto res = simulation_api_schema::FinalizeResponse();
+  try {
+    waitForSensorFrame();
+    res.mutable_result()->set_success(true);
+  } catch (const std::exception & exception) {
+    res.mutable_result()->set_success(false);
+    res.mutable_result()->set_description(exception.what());
+  }
+  return res;
+}
+
+auto SimulationSession::updateFrame(const simulation_api_schema::UpdateFrameRequest & req)
+  -> simulation_api_schema::UpdateFrameResponse
+{
+  auto res = simulation_api_schema::UpdateFrameResponse();
+  if (!initialized_) {
+    res.mutable_result()->set_description("simulator have not initialized yet.");
+    res.mutable_result()->set_success(false);
+    return res;
+  }
+  current_simulation_time_ = req.current_simulation_time();
+  current_scenario_time_ = req.current_scenario_time();
+  builtin_interfaces::msg::Time t;
+  simulation_interface::toMsg(req.current_ros_time(), t);
+  current_ros_time_ = t;
+  auto & frame = sensor_frames_[sensor_frame_index_];
+  // assigned over the statuses of the previous use of this frame, which keeps their allocations
+  frame.entity_status.resize(entity_status_.size());
+  std::transform(
+    entity_status_.begin(), entity_status_.end(), frame.entity_status.begin(),
+    [](const auto & map_element) -> const auto & { return map_element.second; });
+  if (asynchronous_sensor_update_) {
+    // the rest is captured only here, where the sensors run while the next request is handled
+    frame.simulation_time = current_simulation_time_;
+    frame.ros_time = current_ros_time_;
+    frame.traffic_signals_states = traffic_signals_states_;
+    frame.entity_grid = entity_grid_;
+    waitForSensorFrame();
+    sensor_frame_future_ = sensor_thread_.submit([this, &frame]() {
+      sensor_sim_.updateSensorFrame(
+        frame.simulation_time, frame.ros_time, frame.entity_status, frame.traffic_signals_states,
+        frame.entity_grid);
+    });
+    sensor_frame_index_ = (sensor_frame_index_ + 1) % sensor_frames_.size();
+  } else {
+    sensor_sim_.updateSensorFrame(
+      current_simulation_time_, current_ros_time_, frame.entity_status, traffic_signals_states_,
+      entity_grid_);
+  }
+  res.mutable_result()->set_success(true);
+  res.mutable_result()->set_description("succeed to update frame");
+  return res;
+}
+
+auto SimulationSession::waitForSensorFrame() -> void
+{
+  if (sensor_frame_future_.valid()) {
+    sensor_frame_future_.get();
+  }
+}
+
+auto SimulationSession::updateStepTime(const simulation_api_schema::UpdateStepTimeRequest & req)
+  -> simulation_api_schema::UpdateStepTimeResponse
+{
+  auto res = simulation_api_schema::UpdateStepTimeResponse();
+  step_time_ = req.simulation_step_time();
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::updateEntityStatus(
+  const simulation_api_schema::UpdateEntityStatusRequest & req)
+  -> simulation_api_schema::UpdateEntityStatusResponse
+{
+  auto res = simulation_api_schema::UpdateEntityStatusResponse();
+  auto copyStatusToResponse = [&](const traffic_simulator_msgs::EntityStatus & status) {
+    auto updated_status = res.add_status();
+    updated_status->set_name(status.name());
+    updated_status->mutable_action_status()->CopyFrom(status.action_status());
+    updated_status->mutable_pose()->CopyFrom(status.pose());
+  };
+
+  auto moveOnEntityGrid = [&](const traffic_simulator_msgs::EntityStatus & status) {
+    const auto & position = status.pose().position();
+    entity_grid_.move(status.name(), position.x(), position.y());
+  };
+
+  // simulated once every status of the request has been applied
+  std::vector<
+    std::pair<traffic_simulator_msgs::EntityStatus *, vehicle_simulation::EgoEntitySimulation *>>
+    egos;
+
+  auto update = [&](traffic_simulator_msgs::EntityStatus & status, bool respond) {
+    if (const auto ego = ego_entity_simulations_.find(status.name());
+        ego != ego_entity_simulations_.end()) {
+      egos.emplace_back(&status, ego->second.get());
+    } else {
+      if (respond) {
+        copyStatusToResponse(status);
+      }
+      moveOnEntityGrid(status);
+    }
+  };
+
+  for (const auto & status : req.status()) {
+    if (const auto iter = entity_status_.find(status.name()); iter != entity_status_.end()) {
+      *iter->second.mutable_type() = status.type();
+      *iter->second.mutable_subtype() = status.subtype();
+      iter->second.set_time(status.time());
+      *iter->second.mutable_action_status() = status.action_status();
+      *iter->second.mutable_pose() = status.pose();
+      update(iter->second, true);
+    } else {
+      THROW_SEMANTIC_ERROR("Entity ", std::quoted(status.name()), " does not exist");
+    }
+  }
+
+  // the sender knows what it has sent, so only the entities moved here are sent back
+  for (const auto & delta : req.delta()) {
+    if (const auto iter = entity_handles_.find(delta.handle()); iter != entity_handles_.end()) {
+      if (delta.has_action_status()) {
+        *iter->second->mutable_action_status() = delta.action_status();
+      }
+      if (delta.has_pose()) {
+        *iter->second->mutable_pose() = delta.pose();
+      }
+      update(*iter->second, false);
+    } else {
+      THROW_SEMANTIC_ERROR("Entity handle ", delta.handle(), " does not exist");
+    }
+  }
+
+  /*
+     Each ego has a vehicle model and an Autoware of its own, and reads nothing
+     of the other entities, so the egos are simulated concurrently.
+  */
+  shared_resources_.thread_pool->parallelFor(egos.size(), [&](std::size_t i) {
+    auto & [status, ego_entity_simulation] = egos[i];
+    if (req.overwrite_ego_status()) {
+      traffic_simulator_msgs::msg::EntityStatus ego_status_msg;
+      simulation_interface::toMsg(*status, ego_status_msg);
+      ego_entity_simulation->overwrite(
+        ego_status_msg, current_scenario_time_ + step_time_, step_time_, req.npc_logic_started());
+    } else {
+      ego_entity_simulation->update(
+        current_scenario_time_ + step_time_, step_time_, req.npc_logic_started());
+    }
+    const auto & ego_status = ego_entity_simulation->getStatus();
+    simulation_interface::toProto(ego_status.pose, *status->mutable_pose());
+    simulation_interface::toProto(ego_status.action_status, *status->mutable_action_status());
+  });
+  for (const auto & [status, ego_entity_simulation] : egos) {
+    copyStatusToResponse(*status);
+    moveOnEntityGrid(*status);
+  }
+
+  res.mutable_result()->set_success(true);
+  res.mutable_result()->set_description("");
+  return res;
+}
+
+template <typename SpawnRequestType>
+auto SimulationSession::insertEntitySpawnedStatus(
+  const SpawnRequestType & spawn_request, const traffic_simulator_msgs::EntityType::Enum & type,
+  const traffic_simulator_msgs::EntitySubtype::Enum & subtype) -> std::uint32_t
+{
+  traffic_simulator_msgs::EntityStatus init_status;
+  init_status.mutable_type()->set_type(type);
+  init_status.mutable_subtype()->set_value(subtype);
+  init_status.set_time(current_scenario_time_);
+  init_status.set_name(spawn_request.parameters().name());
+  *init_status.mutable_bounding_box() = spawn_request.parameters().bounding_box();
+  init_status.mutable_action_status()->set_current_action("initializing");
+  init_status.mutable_pose()->CopyFrom(spawn_request.pose());
+  auto & status =
+    entity_status_.emplace(spawn_request.parameters().name(), init_status).first->second;
+  const auto handle = next_entity_handle_++;
+  entity_handles_.emplace(handle, &status);
+  entity_handle_by_name_.emplace(spawn_request.parameters().name(), handle);
+  const auto & bounding_box = spawn_request.parameters().bounding_box();
+  entity_grid_.insert(
+    spawn_request.parameters().name(), spawn_request.pose().position().x(),
+    spawn_request.pose().position().y(),
+    // radius of the circle around the entity origin that encloses its bounding box
+    std::hypot(bounding_box.center().x(), bounding_box.center().y()) +
+      0.5 * std::hypot(bounding_box.dimensions().x(), bounding_box.dimensions().y()));
+  return handle;
+}
+
+auto SimulationSession::spawnVehicleEntity(
+  const simulation_api_schema::SpawnVehicleEntityRequest & req)
+  -> simulation_api_schema::SpawnVehicleEntityResponse
+{
+  if (isEntityExists(req.parameters().name())) {
+    // a second entity of the same name would get a handle of its own but share the status
+    auto res = simulation_api_schema::SpawnVehicleEntityResponse();
+    res.mutable_result()->set_success(false);
+    res.mutable_result()->set_description(
+      "Entity \"" + req.parameters().name() + "\" already exists");
+    return res;
+  }
+  auto entity_type = traffic_simulator_msgs::EntityType::VEHICLE;
+  if (req.is_ego()) {
+    entity_type = traffic_simulator_msgs::EntityType::EGO;
+    traffic_simulator_msgs::msg::VehicleParameters parameters;
+    simulation_interface::toMsg(req.parameters(), parameters);
+    auto get_consider_acceleration_by_road_slope = [&]() {
+      if (!node_.has_parameter("consider_acceleration_by_road_slope")) {
+        node_.declare_parameter("consider_acceleration_by_road_slope", false);
+      }
+      return node_.get_parameter("consider_acceleration_by_road_slope").as_bool();
+    };
+    traffic_simulator_msgs::msg::EntityStatus initial_status;
+    initial_status.name = parameters.name;
+    initial_status.bounding_box = parameters.bounding_box;
+    simulation_interface::toMsg(req.pose(), initial_status.pose);
+    /*
+       The first ego talks to Autoware on the topics of the session. Any other
+       ego is driven by an Autoware of its own on the topics under its name,
+       and its sensors publish there as well. An ego keeps its namespace
+       whichever egos are despawned, and gets it back if respawned.
+    */
+    const auto topic_namespace = sensor_sim_.addEgo(parameters.name);
+    ego_entity_simulations_[parameters.name] =
+      std::make_shared<vehicle_simulation::EgoEntitySimulation>(
+        initial_status, parameters, step_time_, hdmap_utils_,
+        node_.get_parameter_or("use_sim_time", rclcpp::Parameter("use_sim_time", false)),
+        get_consider_acceleration_by_road_slope(), topic_namespace,
+        sensor_sim_.getFrameId(parameters.name, "base_link"));
+    ego_vehicles_.emplace_back(req.parameters());
+  } else {
+    vehicles_.emplace_back(req.parameters());
+  }
+  const auto handle = insertEntitySpawnedStatus(req, entity_type, req.subtype().value());
+  auto res = simulation_api_schema::SpawnVehicleEntityResponse();
+  res.mutable_result()->set_success(true);
+  res.set_handle(handle);
+  res.mutable_result()->set_description("");
+  return res;
+}
+
+auto SimulationSession::spawnPedestrianEntity(
+  const simulation_api_schema::SpawnPedestrianEntityRequest & req)
+  -> simulation_api_schema::SpawnPedestrianEntityResponse
+{
+  if (isEntityExists(req.parameters().name())) {
+    auto res = simulation_api_schema::SpawnPedestrianEntityResponse();
+    res.mutable_result()->set_success(false);
+    res.mutable_result()->set_description(
+      "Entity \"" + req.parameters().name() + "\" already exists");
+    return res;
+  }
+  pedestrians_.emplace_back(req.parameters());
+  const auto handle = insertEntitySpawnedStatus(
+    req, traffic_simulator_msgs::EntityType::PEDESTRIAN, req.subtype().value());
+  auto res = simulation_api_schema::SpawnPedestrianEntityResponse();
+  res.mutable_result()->set_success(true);
+  res.set_handle(handle);
+  res.mutable_result()->set_description("");
+  return res;
+}
+
+auto SimulationSession::spawnMiscObjectEntity(
+  const simulation_api_schema::SpawnMiscObjectEntityRequest & req)
+  -> simulation_api_schema::SpawnMiscObjectEntityResponse
+{
+  if (isEntityExists(req.parameters().name())) {
+    auto res = simulation_api_schema::SpawnMiscObjectEntityResponse();
+    res.mutable_result()->set_success(false);
+    res.mutable_result()->set_description(
+      "Entity \"" + req.parameters().name() + "\" already exists");
+    return res;
+  }
+  misc_objects_.emplace_back(req.parameters());
+  const auto handle = insertEntitySpawnedStatus(
+    req, traffic_simulator_msgs::EntityType::MISC_OBJECT, req.subtype().value());
+  auto res = simulation_api_schema::SpawnMiscObjectEntityResponse();
+  res.mutable_result()->set_success(true);
+  res.set_handle(handle);
+  res.mutable_result()->set_description("");
+  return res;
+}
+
+auto SimulationSession::despawnEntity(const simulation_api_schema::DespawnEntityRequest & req)
+  -> simulation_api_schema::DespawnEntityResponse
+{
+  auto remove_despawn_requested_entity_from = [&](auto & v) {
+    const auto size = std::size(v);
+    v.erase(
+      std::remove_if(
+        std::begin(v), std::end(v),
+        [&](const auto & entity) { return entity.name() == req.name(); }),
+      std::end(v));
+    return size != std::size(v);  // true if something removed.
+  };
+  const auto ego_entity_was_removed = remove_despawn_requested_entity_from(ego_vehicles_);
+  if (ego_entity_was_removed) {
+    ego_entity_simulations_.erase(req.name());
+  }
+  const auto any_entity_was_removed = ego_entity_was_removed or
+                                      remove_despawn_requested_entity_from(vehicles_) or
+                                      remove_despawn_requested_entity_from(pedestrians_) or
+                                      remove_despawn_requested_entity_from(misc_objects_);
+  if (any_entity_was_removed) {
+    if (const auto handle = entity_handle_by_name_.find(req.name());
+        handle != entity_handle_by_name_.end()) {
+      entity_handles_.erase(handle->second);
+      entity_handle_by_name_.erase(handle);
+    }
+    entity_status_.erase(req.name());
+    entity_grid_.erase(req.name());
+  }
+  auto res = simulation_api_schema::DespawnEntityResponse();
+  res.mutable_result()->set_success(any_entity_was_removed);
+  return res;
+}
+
+auto SimulationSession::attachImuSensor(const simulation_api_schema::AttachImuSensorRequest & req)
+  -> simulation_api_schema::AttachImuSensorResponse
+{
+  waitForSensorFrame();
+  sensor_sim_.attachImuSensor(current_simulation_time_, req.configuration(), node_);
+  auto res = simulation_api_schema::AttachImuSensorResponse();
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::attachDetectionSensor(
+  const simulation_api_schema::AttachDetectionSensorRequest & req)
+  -> simulation_api_schema::AttachDetectionSensorResponse
+{
+  waitForSensorFrame();
+  sensor_sim_.attachDetectionSensor(current_simulation_time_, req.configuration(), node_);
+  auto res = simulation_api_schema::AttachDetectionSensorResponse();
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::attachLidarSensor(
+  const simulation_api_schema::AttachLidarSensorRequest & req)
+  -> simulation_api_schema::AttachLidarSensorResponse
+{
+  waitForSensorFrame();
+  sensor_sim_.attachLidarSensor(current_simulation_time_, req.configuration(), node_);
+  auto res = simulation_api_schema::AttachLidarSensorResponse();
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::attachOccupancyGridSensor(
+  const simulation_api_schema::AttachOccupancyGridSensorRequest & req)
+  -> simulation_api_schema::AttachOccupancyGridSensorResponse
+{
+  auto res = simulation_api_schema::AttachOccupancyGridSensorResponse();
+  waitForSensorFrame();
+  sensor_sim_.attachOccupancyGridSensor(current_simulation_time_, req.configuration(), node_);
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::updateTrafficLights(
+  const simulation_api_schema::UpdateTrafficLightsRequest & req)
+  -> simulation_api_schema::UpdateTrafficLightsResponse
+{
+  traffic_signals_states_ = req;
+  auto res = simulation_api_schema::UpdateTrafficLightsResponse();
+  res.mutable_result()->set_success(true);
+  return res;
+}
+
+auto SimulationSession::attachPseudoTrafficLightDetector(
+  const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest & req)
+  -> simulation_api_schema::AttachPseudoTrafficLightDetectorResponse
+{
+  auto response = simulation_api_schema::AttachPseudoTrafficLightDetectorResponse();
+  waitForSensorFrame();
+  sensor_sim_.attachPseudoTrafficLightsDetector(
+    current_simulation_time_, req.configuration(), node_, hdmap_utils_);
+  response.mutable_result()->set_success(true);
+  return response;
+}
+
+bool SimulationSession::isEgo(const std::string & name)
+{
+  return std::find_if(ego_vehicles_.begin(), ego_vehicles_.end(), [&](auto && entity) {
+           return entity.name() == name;
+         }) != std::end(ego_vehicles_);
+}
+
+bool SimulationSession::isEntityExists(const std::string & name)
+{
+  return entity_status_.find(name) != entity_status_.end();
+}
+}  // namespace simple_sensor_simulator
@@ -40,8 +40,9 @@ EgoEntitySimulation::EgoEntitySimulation(
   const traffic_simulator_msgs::msg::EntityStatus & initial_status,
   const traffic_simulator_msgs::msg::VehicleParameters & parameters, double step_time,
   const std::shared_ptr<hdmap_utils::HdMapUtils> & hdmap_utils,
-  const rclcpp::Parameter & use_sim_time, const bool consider_acceleration_by_road_slope)
-: autoware(std::make_unique<concealer::AutowareUniverse>()),
+  const rclcpp::Parameter & use_sim_time, const bool consider_acceleration_by_road_slope,
+  const std::string & topic_namespace, const std::string & base_link_frame_id)
+: autoware(std::make_unique<concealer::AutowareUniverse>(topic_namespace, base_link_frame_id)),
   vehicle_model_type_(getVehicleModelType()),
   vehicle_model_ptr_(makeSimulationModel(vehicle_model_type_, step_time, parameters)),
   status_(initial_status, std::nullopt),
@@ -0,0 +1,170 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <simple_sensor_simulator/sensor_simulation/delay_line.hpp>
+#include <string>
+#include <vector>
+
+using simple_sensor_simulator::DelayLine;
+using simple_sensor_simulator::History;
+using simple_sensor_simulator::RingBuffer;
+
+/**
+ * @note Test basic functionality. Test that elements come out in the order they were pushed, also
+ * after the buffer wraps around and grows.
+ */
+TEST(RingBuffer, pushPop)
+{
+  RingBuffer<int> buffer(3);
+  buffer.push() = 0;
+  buffer.push() = 1;
+  EXPECT_EQ(buffer.pop(), 0);
+  buffer.push() = 2;
+  buffer.push() = 3;
+  EXPECT_EQ(buffer.capacity(), 3u);
+  // the buffer is full and wrapped around, so this push has to grow it
+  buffer.push() = 4;
+  EXPECT_EQ(buffer.capacity(), 6u);
+  EXPECT_EQ(buffer.size(), 4u);
+  EXPECT_EQ(buffer.front(), 1);
+  EXPECT_EQ(buffer.back(), 4);
+  for (int expected = 1; expected <= 4; ++expected) {
+    EXPECT_EQ(buffer.pop(), expected);
+  }
+  EXPECT_TRUE(buffer.empty());
+}
+
+/**
+ * @note Test that a slot is reused rather than reallocated, so an element that is not moved out
+ * is still there the next time the slot is handed out.
+ */
+TEST(RingBuffer, reuse)
+{
+  RingBuffer<std::vector<int>> buffer(1);
+  buffer.push().assign(100, 0);
+  buffer.drop();
+  EXPECT_EQ(buffer.push().size(), 100u);
+  EXPECT_EQ(buffer.capacity(), 1u);
+}
+
+/**
+ * @note Test basic functionality. Test that a message is held back until it is old enough.
+ */
+TEST(DelayLine, delay)
+{
+  DelayLine<std::string> delay_line(0.2, 0.1);
+  EXPECT_EQ(delay_line.capacity(), 3u);
+
+  delay_line.push(0.0) = "a";
+  EXPECT_FALSE(delay_line.ready(0.0));
+  delay_line.push(0.1) = "b";
+  EXPECT_FALSE(delay_line.ready(0.1));
+  delay_line.push(0.2) = "c";
+  ASSERT_TRUE(delay_line.ready(0.2));
+  EXPECT_EQ(delay_line.pop(), "a");
+  EXPECT_FALSE(delay_line.ready(0.2));
+  EXPECT_EQ(delay_line.size(), 2u);
+}
+
+/**
+ * @note Test that a message taken back is never published, and that its slot is reused.
+ */
+TEST(DelayLine, unpush)
+{
+  DelayLine<std::string> delay_line(0.1, 0.1);
+  const auto capacity = delay_line.capacity();
+
+  delay_line.push(0.0) = "a";
+  delay_line.push(0.1) = "failed";
+  delay_line.unpush();
+  EXPECT_EQ(delay_line.size(), 1u);
+  delay_line.push(0.1) = "b";
+  ASSERT_TRUE(delay_line.ready(0.2));
+  EXPECT_EQ(delay_line.pop(), "a");
+  ASSERT_TRUE(delay_line.ready(0.2));
+  EXPECT_EQ(delay_line.pop(), "b");
+  EXPECT_TRUE(delay_line.empty());
+  EXPECT_EQ(delay_line.capacity(), capacity);
+}
+
+/**
+ * @note Test that steady operation with a sensor period that divides the delay never grows the
+ * preallocated slots.
+ */
+TEST(DelayLine, steady)
+{
+  DelayLine<std::vector<int>> delay_line(0.75, 0.25);
+  const auto capacity = delay_line.capacity();
+  for (int i = 0; i < 100; ++i) {
+    const auto time = i * 0.25;
+    delay_line.push(time).assign(1, i);
+    if (delay_line.ready(time)) {
+      EXPECT_EQ(delay_line.pop(), std::vector<int>(1, i - 3));
+    }
+  }
+  EXPECT_EQ(delay_line.capacity(), capacity);
+}
+
+/**
+ * @note Test that readers with different delays each find the newest entry that is old enough
+ * for them, and that pruning keeps the entries the reader with the longest delay still needs.
+ */
+TEST(History, find)
+{
+  History<int> history;
+  EXPECT_EQ(history.find(0.0, 0.0), nullptr);
+
+  for (int i = 0; i < 10; ++i) {
+    history.push(i * 0.25, std::make_shared<const int>(i));
+  }
+
+  const auto * latest = history.find(2.25, 0.0);
+  ASSERT_NE(latest, nullptr);
+  EXPECT_EQ(*latest->value, 9);
+
+  // a delay between two entries picks the older of them
+  const auto * delayed = history.find(2.25, 0.6);
+  ASSERT_NE(delayed, nullptr);
+  EXPECT_EQ(*delayed->value, 6);
+
+  EXPECT_EQ(history.find(2.25, 2.5), nullptr);
+
+  history.prune(2.25, 0.6);
+  EXPECT_EQ(history.size(), 4u);
+  ASSERT_NE(history.find(2.25, 0.6), nullptr);
+  EXPECT_EQ(*history.find(2.25, 0.6)->value, 6);
+}
+
+/**
+ * @note Test that an entry stays alive while a reader still holds it after it is pruned.
+ */
+TEST(History, shared)
+{
+  History<int> history;
+  history.push(0.0, std::make_shared<const int>(0));
+  const auto value = history.find(0.0, 0.0)->value;
+  history.push(1.0, std::make_shared<const int>(1));
+  history.prune(1.0, 0.0);
+  EXPECT_EQ(history.size(), 1u);
+  EXPECT_EQ(*value, 0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
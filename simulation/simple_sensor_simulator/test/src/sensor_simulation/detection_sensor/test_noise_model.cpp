@@ -0,0 +1,163 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <simple_sensor_simulator/sensor_simulation/detection_sensor/noise_model.hpp>
+#include <vector>
+
+using simple_sensor_simulator::CounterBasedRandom;
+using simple_sensor_simulator::hashEntityName;
+using simple_sensor_simulator::NoiseModelPipeline;
+using simple_sensor_simulator::Philox4x32;
+
+auto makeDetectedObjects(std::size_t size)
+  -> autoware_auto_perception_msgs::msg::DetectedObjects
+{
+  autoware_auto_perception_msgs::msg::DetectedObjects detected_objects;
+  for (std::size_t i = 0; i < size; ++i) {
+    auto & object = detected_objects.objects.emplace_back();
+    object.kinematics.pose_with_covariance.pose.position.x = static_cast<double>(i);
+    object.kinematics.pose_with_covariance.pose.orientation.w = 1;
+    object.shape.dimensions.x = 4;
+    object.shape.dimensions.y = 2;
+  }
+  return detected_objects;
+}
+
+/**
+ * @note Test the known answers of the reference implementation (Random123).
+ */
+TEST(Philox4x32, knownAnswer)
+{
+  EXPECT_EQ(
+    Philox4x32::generate({0, 0, 0, 0}, {0, 0}),
+    (Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  EXPECT_EQ(
+    Philox4x32::generate(
+      {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+    (Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  EXPECT_EQ(
+    Philox4x32::generate(
+      {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+    (Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+/**
+ * @note Test that an entity draws the same numbers wherever it is in the batch.
+ */
+TEST(CounterBasedRandom, orderIndependence)
+{
+  const auto random = CounterBasedRandom(42);
+  const auto a = hashEntityName("a"), b = hashEntityName("b"), c = hashEntityName("c");
+  std::vector<double> forward0, forward1, backward0, backward1;
+  random.fillNormal(0, 7, {a, b, c}, forward0, forward1);
+  random.fillNormal(0, 7, {c, b, a}, backward0, backward1);
+  for (std::size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(forward0[i], backward0[2 - i]);
+    EXPECT_EQ(forward1[i], backward1[2 - i]);
+  }
+}
+
+/**
+ * @note Test that the normal numbers have zero mean and unit variance.
+ */
+TEST(CounterBasedRandom, normalMoments)
+{
+  const auto random = CounterBasedRandom(1);
+  std::vector<std::uint64_t> entities(100000);
+  for (std::size_t i = 0; i < entities.size(); ++i) {
+    entities[i] = i;
+  }
+  std::vector<double> values0, values1;
+  random.fillNormal(0, 0, entities, values0, values1);
+  double sum = 0, sum_of_squares = 0;
+  for (const auto value : values0) {
+    sum += value;
+    sum_of_squares += value * value;
+  }
+  EXPECT_NEAR(sum / values0.size(), 0.0, 0.02);
+  EXPECT_NEAR(sum_of_squares / values0.size(), 1.0, 0.02);
+}
+
+/**
+ * @note Test that a configuration without noise leaves the objects untouched.
+ */
+TEST(NoiseModelPipeline, noNoise)
+{
+  auto pipeline = NoiseModelPipeline(simulation_api_schema::DetectionSensorConfiguration());
+  EXPECT_TRUE(pipeline.empty());
+  auto detected_objects = makeDetectedObjects(3);
+  pipeline(detected_objects, {1, 2, 3}, geometry_msgs::msg::Pose());
+  EXPECT_EQ(detected_objects, makeDetectedObjects(3));
+}
+
+/**
+ * @note Test that the noise of an object depends on its entity, not on the other objects.
+ */
+TEST(NoiseModelPipeline, reproducibleNoise)
+{
+  simulation_api_schema::DetectionSensorConfiguration configuration;
+  configuration.set_pos_noise_stddev(1.0);
+  configuration.set_yaw_noise_stddev(0.1);
+  configuration.set_shape_noise_stddev(0.1);
+  configuration.set_random_seed(3);
+
+  auto all = makeDetectedObjects(2);
+  NoiseModelPipeline(configuration)(all, {10, 20}, geometry_msgs::msg::Pose());
+
+  auto second_only = makeDetectedObjects(2);
+  second_only.objects.erase(second_only.objects.begin());
+  NoiseModelPipeline(configuration)(second_only, {20}, geometry_msgs::msg::Pose());
+
+  ASSERT_EQ(second_only.objects.size(), 1u);
+  EXPECT_EQ(second_only.objects[0], all.objects[1]);
+  EXPECT_NE(all.objects[1], makeDetectedObjects(2).objects[1]);
+
+  const auto & orientation = all.objects[0].kinematics.pose_with_covariance.pose.orientation;
+  EXPECT_NEAR(std::hypot(orientation.w, orientation.z), 1.0, 1e-12);
+}
+
+/**
+ * @note Test that every object is lost with probability 1 and a false positive is added within
+ * the range.
+ */
+TEST(NoiseModelPipeline, misdetectionAndFalsePositive)
+{
+  simulation_api_schema::DetectionSensorConfiguration configuration;
+  configuration.set_probability_of_lost(1.0);
+  configuration.set_probability_of_false_positive(1.0);
+  configuration.set_range(30.0);
+
+  auto ego_pose = geometry_msgs::msg::Pose();
+  ego_pose.position.x = 100;
+
+  auto detected_objects = makeDetectedObjects(5);
+  NoiseModelPipeline(configuration)(detected_objects, {1, 2, 3, 4, 5}, ego_pose);
+
+  ASSERT_EQ(detected_objects.objects.size(), 1u);
+  const auto & position = detected_objects.objects[0].kinematics.pose_with_covariance.pose.position;
+  EXPECT_LE(std::hypot(position.x - 100, position.y), 30.0);
+  EXPECT_EQ(
+    detected_objects.objects[0].classification[0].label,
+    autoware_auto_perception_msgs::msg::ObjectClassification::UNKNOWN);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <simple_sensor_simulator/sensor_simulation/entity_grid.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using simple_sensor_simulator::EntityGrid;
+
+auto sorted(std::vector<std::string> names) -> std::vector<std::string>
+{
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+/**
+ * @note Test basic functionality. Test that only entities within range are returned.
+ */
+TEST(EntityGrid, query)
+{
+  EntityGrid grid(10.0);
+  grid.insert("near", 5.0, 0.0, 1.0);
+  grid.insert("edge", 0.0, -21.0, 1.0);
+  grid.insert("far", 100.0, 100.0, 1.0);
+
+  EXPECT_EQ(sorted(grid.query(0.0, 0.0, 20.0)), (std::vector<std::string>{"edge", "near"}));
+  EXPECT_EQ(grid.query(0.0, 0.0, 1.0), std::vector<std::string>{});
+}
+
+/**
+ * @note Test functionality used by sensors. Test that an entity is returned when only its bounding
+ * circle reaches into range, also when its center lies in a cell outside of the queried cells.
+ */
+TEST(EntityGrid, query_radius)
+{
+  EntityGrid grid(1.0);
+  grid.insert("truck", 30.0, 0.0, 12.0);
+
+  EXPECT_EQ(grid.query(0.0, 0.0, 20.0), std::vector<std::string>{"truck"});
+  EXPECT_EQ(grid.query(0.0, 0.0, 17.0), std::vector<std::string>{});
+}
+
+/**
+ * @note Test functionality used by sensors. Test that an unbounded range returns every entity.
+ */
+TEST(EntityGrid, query_infinity)
+{
+  EntityGrid grid;
+  grid.insert("a", -1.0e6, 0.0, 1.0);
+  grid.insert("b", 1.0e6, 1.0e6, 1.0);
+
+  EXPECT_EQ(
+    sorted(grid.query(0.0, 0.0, std::numeric_limits<double>::infinity())),
+    (std::vector<std::string>{"a", "b"}));
+}
+
+/**
+ * @note Test basic functionality. Test that moving an entity across cells updates query results.
+ */
+TEST(EntityGrid, move)
+{
+  EntityGrid grid(10.0);
+  grid.insert("a", 0.0, 0.0, 1.0);
+  grid.move("a", 95.0, 0.0);
+
+  EXPECT_EQ(grid.query(0.0, 0.0, 10.0), std::vector<std::string>{});
+  EXPECT_EQ(grid.query(100.0, 0.0, 10.0), std::vector<std::string>{"a"});
+  EXPECT_THROW(grid.move("b", 0.0, 0.0), std::out_of_range);
+}
+
+/**
+ * @note Test basic functionality. Test that inserting an existing entity replaces it.
+ */
+TEST(EntityGrid, insert_existing)
+{
+  EntityGrid grid(10.0);
+  grid.insert("a", 0.0, 0.0, 1.0);
+  grid.insert("a", 50.0, 0.0, 1.0);
+
+  EXPECT_EQ(grid.size(), 1u);
+  EXPECT_EQ(grid.query(0.0, 0.0, 10.0), std::vector<std::string>{});
+  EXPECT_EQ(grid.query(50.0, 0.0, 10.0), std::vector<std::string>{"a"});
+}
+
+/**
+ * @note Test basic functionality. Test erasing single entities and clearing the grid.
+ */
+TEST(EntityGrid, erase)
+{
+  EntityGrid grid(10.0);
+  grid.insert("a", 0.0, 0.0, 1.0);
+  grid.insert("b", 1.0, 0.0, 1.0);
+  grid.erase("a");
+  grid.erase("not_existing");
+
+  EXPECT_FALSE(grid.contains("a"));
+  EXPECT_TRUE(grid.contains("b"));
+  EXPECT_EQ(grid.query(0.0, 0.0, 10.0), std::vector<std::string>{"b"});
+
+  grid.clear();
+  EXPECT_EQ(grid.size(), 0u);
+  EXPECT_EQ(grid.query(0.0, 0.0, 10.0), std::vector<std::string>{});
+}
+
+/**
+ * @note Test functionality used by the simulator. Test that a copied grid is independent of the
+ * original, since frames are rendered from a copy while the original keeps being updated.
+ */
+TEST(EntityGrid, copy)
+{
+  EntityGrid grid(10.0);
+  grid.insert("a", 0.0, 0.0, 1.0);
+
+  EntityGrid copy;
+  copy = grid;
+  grid.move("a", 100.0, 0.0);
+
+  EXPECT_EQ(copy.getCellSize(), 10.0);
+  EXPECT_EQ(copy.query(0.0, 0.0, 10.0), std::vector<std::string>{"a"});
+  EXPECT_EQ(grid.query(0.0, 0.0, 10.0), std::vector<std::string>{});
+}
+
+/**
+ * @note Test function behavior when called with a non-positive cell size.
+ */
+TEST(EntityGrid, constructor_invalidCellSize)
+{
+  EXPECT_THROW(EntityGrid(0.0), std::invalid_argument);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
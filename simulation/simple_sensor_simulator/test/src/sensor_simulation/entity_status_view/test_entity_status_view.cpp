@@ -0,0 +1,76 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <simple_sensor_simulator/sensor_simulation/entity_status_view.hpp>
+#include <string>
+#include <vector>
+
+using simple_sensor_simulator::EntityStatusView;
+
+auto makeStatuses(const std::vector<std::string> & names)
+  -> std::vector<traffic_simulator_msgs::EntityStatus>
+{
+  std::vector<traffic_simulator_msgs::EntityStatus> statuses;
+  for (const auto & name : names) {
+    statuses.emplace_back().set_name(name);
+  }
+  return statuses;
+}
+
+auto namesOf(const EntityStatusView & view) -> std::vector<std::string>
+{
+  std::vector<std::string> names;
+  for (const auto & status : view) {
+    names.push_back(status.name());
+  }
+  return names;
+}
+
+/**
+ * @note Test that a view of a whole vector refers to its statuses in order, without copying them.
+ */
+TEST(EntityStatusView, whole)
+{
+  const auto statuses = makeStatuses({"ego", "npc1", "npc2"});
+  const EntityStatusView view = statuses;
+  EXPECT_EQ(view.size(), 3u);
+  EXPECT_EQ(namesOf(view), (std::vector<std::string>{"ego", "npc1", "npc2"}));
+  EXPECT_EQ(&*view.begin(), &statuses.front());
+}
+
+/**
+ * @note Test that a view by indices refers only to the indexed statuses, in the order of indices.
+ */
+TEST(EntityStatusView, indexed)
+{
+  const auto statuses = makeStatuses({"ego", "npc1", "npc2", "npc3"});
+  const EntityStatusView view(statuses, {0, 2, 3});
+  EXPECT_EQ(view.size(), 3u);
+  EXPECT_EQ(namesOf(view), (std::vector<std::string>{"ego", "npc2", "npc3"}));
+  EXPECT_EQ(&*std::next(view.begin()), &statuses[2]);
+}
+
+/**
+ * @note Test that default and empty views are iterated over no statuses.
+ */
+TEST(EntityStatusView, empty)
+{
+  EXPECT_TRUE(EntityStatusView().empty());
+  EXPECT_EQ(EntityStatusView().begin(), EntityStatusView().end());
+  const auto statuses = makeStatuses({"ego"});
+  EXPECT_TRUE(EntityStatusView(statuses, {}).empty());
+}
@@ -38,7 +38,8 @@ protected:
     makeRosInterface();
     initializeEntityStatuses();
 
-    lidar_ = std::make_unique<LidarSensor<sensor_msgs::msg::PointCloud2>>(0.0, config_, publisher_);
+    lidar_ = std::make_unique<LidarSensor<sensor_msgs::msg::PointCloud2>>(
+      0.0, config_, publisher_, std::make_shared<ThreadPool>());
   }
 
   ~LidarSensorTest() { rclcpp::shutdown(); }
@@ -0,0 +1,137 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <embree4/rtcore.h>
+#include <gtest/gtest.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <filesystem>
+#include <simple_sensor_simulator/exception.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/point_cloud_map.hpp>
+#include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
+
+#include "../../utils/helper_functions.hpp"
+
+using namespace simple_sensor_simulator;
+
+class PointCloudMapTest : public ::testing::Test
+{
+protected:
+  PointCloudMapTest()
+  : directory_(std::filesystem::temp_directory_path() / "test_point_cloud_map"),
+    pcd_path_(directory_ / "pointcloud_map.pcd")
+  {
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+
+    // 4 points in one voxel and a 1m x 1m wall at x = 5.0
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    cloud.push_back(pcl::PointXYZ(0.1f, 0.1f, 0.1f));
+    cloud.push_back(pcl::PointXYZ(0.2f, 0.1f, 0.1f));
+    cloud.push_back(pcl::PointXYZ(0.1f, 0.2f, 0.1f));
+    cloud.push_back(pcl::PointXYZ(0.1f, 0.1f, 0.2f));
+    for (int y = -10; y <= 10; ++y) {
+      for (int z = -10; z <= 10; ++z) {
+        cloud.push_back(pcl::PointXYZ(5.0f, y * 0.05f, z * 0.05f));
+      }
+    }
+    pcl::io::savePCDFileBinary(pcd_path_.string(), cloud);
+  }
+
+  ~PointCloudMapTest() { std::filesystem::remove_all(directory_); }
+
+  const std::filesystem::path directory_;
+  const std::filesystem::path pcd_path_;
+  const float voxel_size_{0.5f};
+};
+
+/**
+ * @note Test basic functionality. Test that points falling into the same voxel are merged.
+ */
+TEST_F(PointCloudMapTest, voxelize)
+{
+  const PointCloudMap map(pcd_path_, voxel_size_);
+
+  // [-0.5, 0.5] on y and z spans 3 voxels of 0.5m each (-0.5 belongs to [-0.5, 0.0))
+  EXPECT_EQ(map.getVoxels().size(), 1u + 3u * 3u);
+}
+
+/**
+ * @note Test basic functionality. Test that the voxels are cached next to the map and read back.
+ */
+TEST_F(PointCloudMapTest, cache)
+{
+  const PointCloudMap map(pcd_path_, voxel_size_);
+
+  ASSERT_TRUE(std::filesystem::exists(PointCloudMap::cachePath(pcd_path_, voxel_size_)));
+
+  const PointCloudMap cached_map(pcd_path_, voxel_size_);
+
+  ASSERT_EQ(cached_map.getVoxels().size(), map.getVoxels().size());
+  for (std::size_t i = 0; i < map.getVoxels().size(); ++i) {
+    EXPECT_EQ(cached_map.getVoxels()[i].x, map.getVoxels()[i].x);
+    EXPECT_EQ(cached_map.getVoxels()[i].y, map.getVoxels()[i].y);
+    EXPECT_EQ(cached_map.getVoxels()[i].z, map.getVoxels()[i].z);
+  }
+}
+
+/**
+ * @note Test function behavior when the pointcloud map file does not exist.
+ */
+TEST_F(PointCloudMapTest, notExisting)
+{
+  EXPECT_THROW(PointCloudMap(directory_ / "missing.pcd", voxel_size_), SimulationRuntimeError);
+}
+
+/**
+ * @note Test basic functionality. Test that the map is hit by the rays of the raycaster but is not
+ * reported as a detected object.
+ */
+TEST_F(PointCloudMapTest, raycast)
+{
+  Raycaster raycaster(std::make_shared<ThreadPool>(2));
+  raycaster.setDirection(utils::constructLidarConfiguration("ego", "awf/universe", 0.0, 0.1));
+  raycaster.setPointCloudMap(std::make_shared<PointCloudMap>(pcd_path_, voxel_size_));
+
+  const auto cloud = raycaster.raycast(
+    "base_link", rclcpp::Time(0), utils::makePose(-5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0));
+
+  EXPECT_GT(cloud.width * cloud.height, 0);
+  EXPECT_TRUE(raycaster.getDetectedObject().empty());
+}
+
+/**
+ * @note Test basic functionality. Test that the scene of the map is built once per device and
+ * shared by every raycaster tracing the map on that device.
+ */
+TEST_F(PointCloudMapTest, sceneOncePerDevice)
+{
+  const PointCloudMap map(pcd_path_, voxel_size_);
+
+  const auto device = rtcNewDevice(nullptr);
+  const auto other_device = rtcNewDevice(nullptr);
+
+  EXPECT_EQ(map.getScene(device), map.getScene(device));
+  EXPECT_NE(map.getScene(device), map.getScene(other_device));
+
+  rtcReleaseDevice(device);
+  rtcReleaseDevice(other_device);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -140,6 +140,197 @@ TEST_F(RaycasterTest, getDetectedObjects)
   EXPECT_EQ(detected_objects[0], box_name_);
 }
 
+/**
+ * @note Test basic functionality. Test that primitives stay in the scene between consecutive
+ * raycasts.
+ */
+TEST_F(RaycasterTest, raycast_persistentPrimitive)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  const auto first_cloud = raycaster_->raycast(frame_id_, stamp_, origin_);
+  const auto second_cloud = raycaster_->raycast(frame_id_, stamp_, origin_);
+
+  EXPECT_GT(first_cloud.width * first_cloud.height, 0);
+  EXPECT_EQ(first_cloud.width * first_cloud.height, second_cloud.width * second_cloud.height);
+}
+
+/**
+ * @note Test basic functionality. Test updating the pose of a primitive already on the scene by
+ * moving the box beyond the maximum raycast distance.
+ */
+TEST_F(RaycasterTest, setPrimitivePose_outOfRange)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  raycaster_->setPrimitivePose(box_name_, utils::makePose(500.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0));
+
+  const auto cloud = raycaster_->raycast(frame_id_, stamp_, origin_);
+
+  EXPECT_EQ(cloud.width * cloud.height, 0);
+  EXPECT_TRUE(raycaster_->getDetectedObject().empty());
+}
+
+/**
+ * @note Test function behavior when updating the pose of a primitive that was never added.
+ */
+TEST_F(RaycasterTest, setPrimitivePose_notExisting)
+{
+  EXPECT_THROW(raycaster_->setPrimitivePose(box_name_, box_pose_), std::runtime_error);
+}
+
+/**
+ * @note Test basic functionality. Test removing a primitive from the scene and adding it again
+ * under the same name.
+ */
+TEST_F(RaycasterTest, removePrimitive)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  raycaster_->removePrimitive(box_name_);
+
+  const auto cloud = raycaster_->raycast(frame_id_, stamp_, origin_);
+
+  EXPECT_EQ(cloud.width * cloud.height, 0);
+  EXPECT_TRUE(raycaster_->getPrimitiveNames().empty());
+  EXPECT_NO_THROW(raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_));
+}
+
+/**
+ * @note Test basic functionality. Test that raycasting into an existing message fills its buffer
+ * with the XYZI layout and overwrites the previous content.
+ */
+TEST_F(RaycasterTest, raycast_intoMessage)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  sensor_msgs::msg::PointCloud2 cloud;
+  cloud.data.resize(1024, 0xFF);
+  raycaster_->raycast(cloud, frame_id_, stamp_, origin_);
+
+  ASSERT_EQ(cloud.fields.size(), 4u);
+  EXPECT_EQ(cloud.fields[0].name, "x");
+  EXPECT_EQ(cloud.fields[1].name, "y");
+  EXPECT_EQ(cloud.fields[2].name, "z");
+  EXPECT_EQ(cloud.fields[3].name, "intensity");
+  EXPECT_EQ(cloud.point_step, 4 * sizeof(float));
+  EXPECT_GT(cloud.width * cloud.height, 0);
+  EXPECT_EQ(cloud.data.size(), cloud.width * cloud.height * cloud.point_step);
+  EXPECT_EQ(cloud.header.frame_id, frame_id_);
+
+  // every hit lies on the face of the box that is closest to the origin
+  for (std::size_t i = 0; i < cloud.width; ++i) {
+    float x;
+    std::memcpy(&x, &cloud.data[i * cloud.point_step + cloud.fields[0].offset], sizeof(float));
+    EXPECT_NEAR(x, box_pose_.position.x - 0.5 * box_depth_, 1e-3);
+  }
+}
+
+/**
+ * @note Test basic functionality. Test horizontal raycasting with a box in front of the origin. The
+ * ray pointing at the box should end at its near face, and the opposite ray should hit nothing.
+ */
+TEST_F(RaycasterTest, raycastHorizontally_box)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  const auto & distances = raycaster_->raycastHorizontally(origin_.position, 360, 100.0);
+
+  ASSERT_EQ(distances.size(), static_cast<std::size_t>(360));
+  EXPECT_NEAR(distances[0], 4.5, 1e-3);
+  EXPECT_TRUE(std::isinf(distances[180]));
+}
+
+/**
+ * @note Test horizontal raycasting with as many rays as fill whole packets of 8 and 16 rays. Every
+ * lane of the packets should be traced.
+ */
+TEST_F(RaycasterTest, raycastHorizontally_fullPacket)
+{
+  raycaster_->addPrimitive<primitives::Box>(
+    box_name_, box_depth_, box_width_, box_height_, box_pose_);
+
+  const auto & distances = raycaster_->raycastHorizontally(origin_.position, 16, 100.0);
+
+  ASSERT_EQ(distances.size(), static_cast<std::size_t>(16));
+  EXPECT_NEAR(distances[0], 4.5, 1e-3);
+  for (std::size_t i = 1; i < distances.size(); ++i) {
+    EXPECT_TRUE(std::isinf(distances[i])) << "ray " << i;
+  }
+}
+
+/**
+ * @note Test horizontal raycasting with one ray more than a packet of 16 rays, so that the last
+ * packet has only its first lane valid. The ray of that lane should still hit the box it points
+ * at.
+ */
+TEST_F(RaycasterTest, raycastHorizontally_partialPacket)
+{
+  constexpr std::size_t ray_count = 17;
+  const auto yaw = 2 * M_PI * (ray_count - 1) / ray_count;
+  const auto pose =
+    utils::makePose(5.0 * std::cos(yaw), 5.0 * std::sin(yaw), 0.0, 0.0, 0.0, 0.0, 1.0);
+  raycaster_->addPrimitive<primitives::Box>(box_name_, box_depth_, box_width_, box_height_, pose);
+
+  const auto & distances = raycaster_->raycastHorizontally(origin_.position, ray_count, 100.0);
+
+  ASSERT_EQ(distances.size(), ray_count);
+  EXPECT_TRUE(std::isfinite(distances[ray_count - 1]));
+  EXPECT_LT(distances[ray_count - 1], 5.0);
+  for (std::size_t i = 0; i < ray_count - 1; ++i) {
+    EXPECT_TRUE(std::isinf(distances[i])) << "ray " << i;
+  }
+}
+
+/**
+ * @note Test basic functionality. Test synchronizing the primitives with entity statuses. The
+ * entity the sensor is attached to should never become a primitive.
+ */
+TEST_F(RaycasterTest, updatePrimitives)
+{
+  const auto dimensions = utils::makeDimensions(1.0, 1.0, 1.0);
+  const std::vector<EntityStatus> entities = {
+    utils::makeEntity("ego", EntityType::EGO, origin_, dimensions),
+    utils::makeEntity(box_name_, EntityType::VEHICLE, box_pose_, dimensions)};
+
+  raycaster_->updatePrimitives(entities, "ego");
+
+  EXPECT_EQ(raycaster_->getPrimitiveNames(), std::vector<std::string>{box_name_});
+  EXPECT_NEAR(raycaster_->raycastHorizontally(origin_.position, 4, 100.0)[0], 4.5, 1e-3);
+}
+
+/**
+ * @note Test function behavior when an entity is missing from the statuses and `disable_missing`
+ * is set. Its primitive should stay on the scene, but be hidden from the rays until the entity is
+ * given again.
+ */
+TEST_F(RaycasterTest, updatePrimitives_disableMissing)
+{
+  const auto dimensions = utils::makeDimensions(1.0, 1.0, 1.0);
+  const std::vector<EntityStatus> entities = {
+    utils::makeEntity(box_name_, EntityType::VEHICLE, box_pose_, dimensions)};
+
+  raycaster_->updatePrimitives(entities, "ego");
+  raycaster_->updatePrimitives({}, "ego", true);
+
+  EXPECT_EQ(raycaster_->getPrimitiveNames(), std::vector<std::string>{box_name_});
+  EXPECT_TRUE(std::isinf(raycaster_->raycastHorizontally(origin_.position, 4, 100.0)[0]));
+
+  raycaster_->updatePrimitives(entities, "ego");
+
+  EXPECT_NEAR(raycaster_->raycastHorizontally(origin_.position, 4, 100.0)[0], 4.5, 1e-3);
+
+  raycaster_->updatePrimitives({}, "ego");
+
+  EXPECT_TRUE(raycaster_->getPrimitiveNames().empty());
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -17,10 +17,13 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <cstring>
 #include <geometry_msgs/msg/pose.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <simple_sensor_simulator/sensor_simulation/lidar/raycaster.hpp>
 #include <simple_sensor_simulator/sensor_simulation/primitives/box.hpp>
+#include <string>
 #include <vector>
 
 #include "../../utils/helper_functions.hpp"
@@ -34,7 +37,7 @@ class RaycasterTest : public ::testing::Test
 {
 protected:
   RaycasterTest()
-  : raycaster_(std::make_unique<Raycaster>()),
+  : raycaster_(std::make_unique<Raycaster>(std::make_shared<ThreadPool>(2))),
     config_(utils::constructLidarConfiguration("ego", "awf/universe", 0.0, 0.1)),
     origin_(utils::makePose(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0)),
     box_pose_(utils::makePose(5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0))
@@ -0,0 +1,122 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <simple_sensor_simulator/exception.hpp>
+#include <simple_sensor_simulator/sensor_simulation/sensor_simulation.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../utils/helper_functions.hpp"
+
+using namespace simple_sensor_simulator;
+
+/**
+ * @note Test that the first ego keeps the usual namespace, that any other one gets a valid
+ * namespace made from its name, and that an ego added again gets the same namespace.
+ */
+TEST(MultipleEgos, addEgo)
+{
+  SensorSimulation sensor_simulation(std::make_shared<ThreadPool>(2));
+  EXPECT_EQ(sensor_simulation.addEgo("ego"), "");
+  EXPECT_EQ(sensor_simulation.addEgo("ego-2"), "/ego_2");
+  EXPECT_EQ(sensor_simulation.addEgo("3rd ego"), "/_3rd_ego");
+  EXPECT_EQ(sensor_simulation.addEgo("ego-2"), "/ego_2");
+  EXPECT_EQ(sensor_simulation.addEgo("ego"), "");
+  EXPECT_THROW(sensor_simulation.addEgo("ego 2"), SimulationRuntimeError);
+
+  EXPECT_EQ(sensor_simulation.getFrameId("ego", "base_link"), "base_link");
+  EXPECT_EQ(sensor_simulation.getFrameId("ego-2", "base_link"), "ego_2/base_link");
+  EXPECT_EQ(sensor_simulation.getFrameId("npc", "base_link"), "base_link");
+}
+
+/**
+ * @note Test that the egos of a session other than 0 get their namespaces and frames under that of
+ * the session, the first one included.
+ */
+TEST(MultipleEgos, addEgoInSession)
+{
+  SensorSimulation sensor_simulation(std::make_shared<ThreadPool>(2), "/session_3");
+  EXPECT_EQ(sensor_simulation.addEgo("ego"), "/session_3");
+  EXPECT_EQ(sensor_simulation.addEgo("ego-2"), "/session_3/ego_2");
+  EXPECT_EQ(sensor_simulation.addEgo("ego"), "/session_3");
+
+  EXPECT_EQ(sensor_simulation.getFrameId("ego", "base_link"), "session_3/base_link");
+  EXPECT_EQ(sensor_simulation.getFrameId("ego-2", "base_link"), "session_3/ego_2/base_link");
+  EXPECT_EQ(sensor_simulation.getFrameId("npc", "base_link"), "session_3/base_link");
+}
+
+/**
+ * @note Test that the LiDARs of two egos publish on topics of their own, in frames of their own,
+ * under the namespace of the session if it is not session 0.
+ */
+TEST(MultipleEgos, lidar)
+{
+  rclcpp::init(0, nullptr);
+  auto node = std::make_shared<rclcpp::Node>("multiple_egos_test_node");
+
+  const auto dimensions = utils::makeDimensions(4.5, 2.0, 1.5);
+  const std::vector<EntityStatus> entities = {
+    utils::makeEntity(
+      "ego", EntityType::EGO, utils::makePose(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0), dimensions),
+    utils::makeEntity(
+      "ego-2", EntityType::EGO, utils::makePose(10.0, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0), dimensions)};
+  EntityGrid entity_grid;
+  for (const auto & entity : entities) {
+    const auto & position = entity.pose().position();
+    entity_grid.insert(entity.name(), position.x(), position.y(), 3.0);
+  }
+
+  for (const auto & [session_namespace, frame_prefix] :
+       std::vector<std::pair<std::string, std::string>>{{"", ""}, {"/session_3", "session_3/"}}) {
+    SensorSimulation sensor_simulation(std::make_shared<ThreadPool>(2), session_namespace);
+    sensor_simulation.addEgo("ego");
+    sensor_simulation.addEgo("ego-2");
+    for (const auto & name : {"ego", "ego-2"}) {
+      sensor_simulation.attachLidarSensor(
+        0.0, utils::constructLidarConfiguration(name, "awf/universe", 0.0, 0.5), *node);
+    }
+
+    sensor_msgs::msg::PointCloud2::SharedPtr first, second;
+    const auto topic = std::string("/perception/obstacle_segmentation/pointcloud");
+    auto first_subscription = node->create_subscription<sensor_msgs::msg::PointCloud2>(
+      session_namespace + topic, 1,
+      [&](const sensor_msgs::msg::PointCloud2::SharedPtr message) { first = message; });
+    auto second_subscription = node->create_subscription<sensor_msgs::msg::PointCloud2>(
+      session_namespace + "/ego_2" + topic, 1,
+      [&](const sensor_msgs::msg::PointCloud2::SharedPtr message) { second = message; });
+
+    sensor_simulation.updateSensorFrame(
+      1.0, rclcpp::Time(1), entities, simulation_api_schema::UpdateTrafficLightsRequest(),
+      entity_grid);
+
+    // the point clouds are published on a thread of their own
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((not first or not second) and std::chrono::steady_clock::now() < deadline) {
+      rclcpp::spin_some(node);
+    }
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(first->header.frame_id, frame_prefix + "base_link");
+    EXPECT_EQ(second->header.frame_id, frame_prefix + "ego_2/base_link");
+  }
+
+  rclcpp::shutdown();
+}
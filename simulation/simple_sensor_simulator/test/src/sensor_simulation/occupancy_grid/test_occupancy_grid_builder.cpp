@@ -0,0 +1,204 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <geometry_msgs/msg/pose.hpp>
+#include <limits>
+#include <simple_sensor_simulator/sensor_simulation/occupancy_grid/occupancy_grid_builder.hpp>
+#include <simple_sensor_simulator/sensor_simulation/primitives/box.hpp>
+#include <vector>
+
+using namespace simple_sensor_simulator;
+
+/**
+ * @brief Grid of 20 x 10 cells of 1 m around the origin, that is, x in [-10, 10] and y in [-5, 5]
+ */
+class OccupancyGridBuilderTest : public ::testing::Test
+{
+protected:
+  OccupancyGridBuilderTest() : builder_(1.0, 10, 20) { builder_.reset(geometry_msgs::msg::Pose()); }
+
+  auto addBox(double x, double y, float depth, float width) -> void
+  {
+    auto pose = geometry_msgs::msg::Pose();
+    pose.position.x = x;
+    pose.position.y = y;
+    builder_.add(primitives::Box(depth, width, 1.0f, pose));
+  }
+
+  auto at(size_t row, size_t col) const -> int8_t { return builder_.get()[row * 20 + col]; }
+
+  auto count(int8_t value) const -> std::ptrdiff_t
+  {
+    return std::count(builder_.get().begin(), builder_.get().end(), value);
+  }
+
+  OccupancyGridBuilder builder_;
+};
+
+/**
+ * @note Test basic functionality. Test building an occupancy grid without any primitive.
+ */
+TEST_F(OccupancyGridBuilderTest, build_empty)
+{
+  builder_.build();
+  ASSERT_EQ(builder_.get().size(), size_t(200));
+  EXPECT_EQ(count(0), 200);
+}
+
+/**
+ * @note Test basic functionality. Test building an occupancy grid with a box in front of the
+ * origin, which occupies the cells it covers and makes the cells behind it invisible.
+ */
+TEST_F(OccupancyGridBuilderTest, build_box)
+{
+  // x in [4.5, 6.5] and y in [-0.5, 1.5], so columns 14 to 16 and rows 4 to 6
+  addBox(5.5, 0.5, 2.0f, 2.0f);
+  builder_.build();
+
+  for (size_t row = 4; row <= 6; ++row) {
+    for (size_t col = 14; col <= 16; ++col) {
+      EXPECT_EQ(at(row, col), 100);
+    }
+  }
+  EXPECT_EQ(count(100), 9);
+
+  // behind the box
+  EXPECT_EQ(at(5, 18), 50);
+  EXPECT_EQ(at(5, 19), 50);
+  // in front of the box
+  EXPECT_EQ(at(5, 12), 0);
+  // beside the shadow of the box
+  EXPECT_EQ(at(9, 19), 0);
+  EXPECT_EQ(at(0, 19), 0);
+  EXPECT_EQ(at(5, 0), 0);
+}
+
+/**
+ * @note Test function behavior when a box covers the origin of the grid. Every cell that is not
+ * occupied should be invisible.
+ */
+TEST_F(OccupancyGridBuilderTest, build_boxCoveringOrigin)
+{
+  addBox(0.0, 0.0, 2.0f, 2.0f);
+  builder_.build();
+
+  EXPECT_EQ(at(5, 10), 100);
+  EXPECT_EQ(count(0), 0);
+  EXPECT_EQ(count(100) + count(50), 200);
+}
+
+/**
+ * @note Test function behavior when a box is entirely outside of the grid.
+ */
+TEST_F(OccupancyGridBuilderTest, build_boxOutsideGrid)
+{
+  addBox(30.0, 0.0, 2.0f, 2.0f);
+  // touching a corner of the grid
+  addBox(10.25, 5.25, 0.5f, 0.5f);
+  builder_.build();
+
+  EXPECT_EQ(count(0), 200);
+}
+
+/**
+ * @note Test function behavior when a box reaches outside of the grid. The box should be clipped
+ * to the grid.
+ */
+TEST_F(OccupancyGridBuilderTest, build_boxAcrossEdge)
+{
+  // x in [8.5, 11.5] and y in [-0.5, 0.5], so columns 18 and 19 and rows 4 and 5
+  addBox(10.0, 0.0, 3.0f, 1.0f);
+  builder_.build();
+
+  EXPECT_EQ(at(4, 18), 100);
+  EXPECT_EQ(at(5, 19), 100);
+  EXPECT_EQ(count(100), 4);
+  EXPECT_EQ(count(50), 0);
+}
+
+/**
+ * @note Test basic functionality. Test that reset clears the primitives added so far.
+ */
+TEST_F(OccupancyGridBuilderTest, reset)
+{
+  addBox(5.5, 0.5, 2.0f, 2.0f);
+  builder_.build();
+  builder_.reset(geometry_msgs::msg::Pose());
+  builder_.build();
+
+  EXPECT_EQ(count(0), 200);
+}
+
+/**
+ * @note Test basic functionality. Test building an occupancy grid from rays that all hit something
+ * 3 m away. Cells within the circle of the ray ends should be free, cells where rays end occupied
+ * and the rest invisible.
+ */
+TEST_F(OccupancyGridBuilderTest, addVisibleArea)
+{
+  builder_.addVisibleArea(std::vector<float>(64, 3.0f), 20.0);
+  builder_.build();
+
+  EXPECT_EQ(at(5, 10), 0);
+  EXPECT_EQ(at(5, 11), 0);
+  // at (3, 0), (-3, 0) and (0, 3)
+  EXPECT_EQ(at(5, 13), 100);
+  EXPECT_EQ(at(5, 7), 100);
+  EXPECT_EQ(at(8, 10), 100);
+  // far from the rays
+  EXPECT_EQ(at(5, 19), 50);
+  EXPECT_EQ(at(0, 0), 50);
+  EXPECT_EQ(at(9, 19), 50);
+}
+
+/**
+ * @note Test function behavior when no ray hits anything. The whole grid should be visible, and the
+ * shadows of primitives should be ignored once a visible area is added.
+ */
+TEST_F(OccupancyGridBuilderTest, addVisibleArea_noHit)
+{
+  builder_.addVisibleArea(
+    std::vector<float>(64, std::numeric_limits<float>::infinity()), std::hypot(10.0, 5.0));
+  addBox(5.5, 0.5, 2.0f, 2.0f);
+  builder_.build();
+
+  EXPECT_EQ(count(100), 9);
+  EXPECT_EQ(count(50), 0);
+}
+
+/**
+ * @note Test basic functionality. Test that only the occupied area of a primitive is marked.
+ */
+TEST_F(OccupancyGridBuilderTest, addOccupiedArea)
+{
+  auto pose = geometry_msgs::msg::Pose();
+  pose.position.x = 5.5;
+  pose.position.y = 0.5;
+  builder_.addOccupiedArea(primitives::Box(2.0f, 2.0f, 1.0f, pose));
+  builder_.build();
+
+  EXPECT_EQ(at(5, 15), 100);
+  EXPECT_EQ(count(100), 9);
+  EXPECT_EQ(count(50), 0);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
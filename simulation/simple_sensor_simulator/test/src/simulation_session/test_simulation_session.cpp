@@ -0,0 +1,115 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <chrono>
+#include <memory>
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <simple_sensor_simulator/simulation_session.hpp>
+#include <string>
+
+#include "../utils/helper_functions.hpp"
+
+using namespace simple_sensor_simulator;
+
+class SimulationSessionTest : public testing::Test
+{
+protected:
+  static auto SetUpTestSuite() -> void { rclcpp::init(0, nullptr); }
+
+  static auto TearDownTestSuite() -> void { rclcpp::shutdown(); }
+
+  auto initialize(SimulationSession & session) -> void
+  {
+    simulation_api_schema::InitializeRequest request;
+    request.set_step_time(0.1);
+    request.set_realtime_factor(1.0);
+    request.set_lanelet2_map_path(
+      ament_index_cpp::get_package_share_directory("traffic_simulator") +
+      "/map/standard_map/lanelet2_map.osm");
+    ASSERT_TRUE(session.initialize(request).result().success());
+  }
+
+  auto spawnEgo(SimulationSession & session, const std::string & name) -> void
+  {
+    simulation_api_schema::SpawnVehicleEntityRequest request;
+    request.set_is_ego(true);
+    request.mutable_parameters()->set_name(name);
+    auto & dimensions = *request.mutable_parameters()->mutable_bounding_box()->mutable_dimensions();
+    dimensions.set_x(4.5);
+    dimensions.set_y(2.0);
+    dimensions.set_z(1.5);
+    request.mutable_pose()->mutable_orientation()->set_w(1.0);
+    ASSERT_TRUE(session.spawnVehicleEntity(request).result().success());
+  }
+
+  auto attachLidar(SimulationSession & session, const std::string & name) -> void
+  {
+    simulation_api_schema::AttachLidarSensorRequest request;
+    *request.mutable_configuration() =
+      utils::constructLidarConfiguration(name, "awf/universe", 0.0, 0.5);
+    ASSERT_TRUE(session.attachLidarSensor(request).result().success());
+  }
+
+  auto updateFrame(SimulationSession & session, double time) -> bool
+  {
+    simulation_api_schema::UpdateFrameRequest request;
+    request.set_current_simulation_time(time);
+    request.set_current_scenario_time(time);
+    return session.updateFrame(request).result().success();
+  }
+
+  std::shared_ptr<rclcpp::Node> node_ = std::make_shared<rclcpp::Node>("simulation_session_test");
+
+  SharedResources shared_resources_;
+};
+
+/**
+ * @note Test that a session initialized again for a scenario with another ego drops the sensors
+ * of the previous scenario, and gives the new ego the usual topics.
+ */
+TEST_F(SimulationSessionTest, initializeAgain)
+{
+  SimulationSession session(*node_, 0, shared_resources_);
+
+  initialize(session);
+  spawnEgo(session, "ego");
+  attachLidar(session, "ego");
+  EXPECT_TRUE(updateFrame(session, 0.1));
+
+  initialize(session);
+  spawnEgo(session, "other_ego");
+  attachLidar(session, "other_ego");
+
+  sensor_msgs::msg::PointCloud2::SharedPtr message;
+  auto subscription = node_->create_subscription<sensor_msgs::msg::PointCloud2>(
+    "/perception/obstacle_segmentation/pointcloud", 1,
+    [&](const sensor_msgs::msg::PointCloud2::SharedPtr received) { message = received; });
+
+  // the LiDAR attached to "ego" would fail to find it
+  EXPECT_TRUE(updateFrame(session, 0.1));
+
+  // the point cloud is published on a thread of its own
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (not message and std::chrono::steady_clock::now() < deadline) {
+    rclcpp::spin_some(node_);
+  }
+  ASSERT_NE(message, nullptr);
+  EXPECT_EQ(message->header.frame_id, "base_link");
+
+  EXPECT_TRUE(session.finalize(simulation_api_schema::FinalizeRequest()).result().success());
+}
@@ -19,7 +19,11 @@
 
 namespace simulation_interface
 {
-enum class TransportProtocol { TCP /*, UDP*/ };
+/**
+ * @note SHARED_MEMORY passes the messages through a SharedMemoryChannel when the client runs on
+ * the same host as the server, and through the TCP socket otherwise.
+ */
+enum class TransportProtocol { TCP /*, UDP*/, SHARED_MEMORY };
 
 std::string enumToString(const TransportProtocol & protocol);
 
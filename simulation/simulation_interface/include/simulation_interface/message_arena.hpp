@@ -0,0 +1,61 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMULATION_INTERFACE__MESSAGE_ARENA_HPP_
+#define SIMULATION_INTERFACE__MESSAGE_ARENA_HPP_
+
+#include <google/protobuf/arena.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace simulation_interface
+{
+/**
+ * @brief Protobuf arena for the messages of one request and its response
+ * @note The arena keeps its first block across resets, so once the block is large enough for a
+ * round trip, building, parsing and switching the oneof of SimulationRequest and
+ * SimulationResponse allocates nothing on the heap. Messages created from the arena are valid
+ * until the next reset.
+ */
+class MessageArena
+{
+public:
+  explicit MessageArena(std::size_t initial_block_size = 1 << 20)
+  : initial_block_(new char[initial_block_size]),
+    arena_([&]() {
+      google::protobuf::ArenaOptions options;
+      options.initial_block = initial_block_.get();
+      options.initial_block_size = initial_block_size;
+      return options;
+    }())
+  {
+  }
+
+  template <typename Message>
+  auto create() -> Message *
+  {
+    return google::protobuf::Arena::CreateMessage<Message>(&arena_);
+  }
+
+  auto reset() -> void { arena_.Reset(); }
+
+private:
+  const std::unique_ptr<char[]> initial_block_;
+
+  google::protobuf::Arena arena_;
+};
+}  // namespace simulation_interface
+
+#endif  // SIMULATION_INTERFACE__MESSAGE_ARENA_HPP_
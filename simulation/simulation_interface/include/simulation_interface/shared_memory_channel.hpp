@@ -0,0 +1,122 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SIMULATION_INTERFACE__SHARED_MEMORY_CHANNEL_HPP_
+#define SIMULATION_INTERFACE__SHARED_MEMORY_CHANNEL_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace simulation_interface
+{
+/**
+ * @brief Request-reply channel between two processes on the same host over POSIX shared memory
+ * @note The region holds one byte ring per direction. A message is its length followed by its
+ * bytes, copied into the ring as space frees up, so a message may be larger than the ring. The
+ * reader sleeps on a futex and the writer wakes it, so a round trip costs two copies and two
+ * wakes instead of a trip through the network stack. The server creates the region, and at most
+ * one client attaches to it at a time. The server empties the rings before the first message of a
+ * new client, so nothing left in them by the previous client is read. Every wait gives up if the
+ * peer goes away or the channel is stopped, by throwing Interrupted in the middle of a message.
+ */
+class SharedMemoryChannel
+{
+public:
+  /**
+   * @brief Thrown by a wait that gives up in the middle of a message
+   */
+  struct Interrupted : public std::runtime_error
+  {
+    using std::runtime_error::runtime_error;
+  };
+
+  /**
+   * @brief Create the region of the server listening on `port`, replacing any stale one
+   */
+  static auto create(unsigned int port, std::size_t ring_capacity = 1 << 20)
+    -> std::unique_ptr<SharedMemoryChannel>;
+
+  /**
+   * @brief Attach to the region of the server listening on `port`
+   * @return nullptr if there is no such region, its server is gone, or another live client holds it
+   */
+  static auto open(unsigned int port) -> std::unique_ptr<SharedMemoryChannel>;
+
+  ~SharedMemoryChannel();
+
+  SharedMemoryChannel(const SharedMemoryChannel &) = delete;
+
+  auto operator=(const SharedMemoryChannel &) -> SharedMemoryChannel & = delete;
+
+  /**
+   * @brief Write a message to the peer, waiting while the ring is full
+   * @exception Interrupted if the peer goes away or the channel is stopped meanwhile
+   */
+  auto send(const std::string &) -> void;
+
+  /**
+   * @brief Read the next message from the peer
+   * @return false if no message began to arrive within `timeout`, or the channel is stopped
+   * @exception Interrupted if the peer goes away or the channel is stopped in the middle of the
+   * message
+   */
+  auto receive(std::string &, std::chrono::milliseconds timeout) -> bool;
+
+  /**
+   * @brief Make every current and later wait on the channel give up
+   * @note For the thread blocked on the channel to be joined.
+   */
+  auto stop() -> void;
+
+  /**
+   * @brief Whether the process on the other side of the channel is still running
+   */
+  auto isPeerAlive() const -> bool;
+
+private:
+  struct Ring;
+
+  struct Region;
+
+  SharedMemoryChannel(
+    const std::string & name, bool is_server, Region * region, std::size_t size, Ring & input,
+    Ring & output);
+
+  // empties the rings for a newly attached client, on the server between messages only
+  auto acceptClient() -> void;
+
+  // whether a wait in the middle of a message should give up
+  auto isInterrupted() const -> bool;
+
+  const std::string name_;
+
+  const bool is_server_;
+
+  Region * const region_;
+
+  const std::size_t size_;
+
+  Ring & input_;
+
+  Ring & output_;
+
+  std::atomic_bool stopped_{false};
+};
+}  // namespace simulation_interface
+
+#endif  // SIMULATION_INTERFACE__SHARED_MEMORY_CHANNEL_HPP_
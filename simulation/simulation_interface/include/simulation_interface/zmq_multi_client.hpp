@@ -17,14 +17,20 @@
 
 #include <simulation_api_schema.pb.h>
 
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <rclcpp/rclcpp.hpp>
 #include <scenario_simulator_exception/exception.hpp>
 #include <simulation_interface/constants.hpp>
+#include <simulation_interface/message_arena.hpp>
+#include <simulation_interface/shared_memory_channel.hpp>
 #include <string>
 #include <thread>
+#include <unordered_set>
 #include <zmqpp/zmqpp.hpp>
 
 namespace zeromq
@@ -34,65 +40,191 @@ class MultiClient
 public:
   explicit MultiClient(
     const simulation_interface::TransportProtocol & protocol, const std::string & hostname,
-    const unsigned int socket_port);
+    const unsigned int socket_port, const std::uint32_t session = 0);
 
   ~MultiClient();
 
   void closeConnection();
 
+  /**
+   * @note The response returned by any overload of call is valid until the next call.
+   */
   auto call(const simulation_api_schema::SimulationRequest &)
-    -> simulation_api_schema::SimulationResponse;
+    -> const simulation_api_schema::SimulationResponse &;
 
   auto call(const simulation_api_schema::InitializeRequest &)
-    -> simulation_api_schema::InitializeResponse;
+    -> const simulation_api_schema::InitializeResponse &;
 
   auto call(const simulation_api_schema::UpdateFrameRequest &)
-    -> simulation_api_schema::UpdateFrameResponse;
+    -> const simulation_api_schema::UpdateFrameResponse &;
 
   auto call(const simulation_api_schema::UpdateStepTimeRequest &)
-    -> simulation_api_schema::UpdateStepTimeResponse;
+    -> const simulation_api_schema::UpdateStepTimeResponse &;
 
   auto call(const simulation_api_schema::SpawnVehicleEntityRequest &)
-    -> simulation_api_schema::SpawnVehicleEntityResponse;
+    -> const simulation_api_schema::SpawnVehicleEntityResponse &;
 
   auto call(const simulation_api_schema::SpawnPedestrianEntityRequest &)
-    -> simulation_api_schema::SpawnPedestrianEntityResponse;
+    -> const simulation_api_schema::SpawnPedestrianEntityResponse &;
 
   auto call(const simulation_api_schema::SpawnMiscObjectEntityRequest &)
-    -> simulation_api_schema::SpawnMiscObjectEntityResponse;
+    -> const simulation_api_schema::SpawnMiscObjectEntityResponse &;
 
   auto call(const simulation_api_schema::DespawnEntityRequest &)
-    -> simulation_api_schema::DespawnEntityResponse;
+    -> const simulation_api_schema::DespawnEntityResponse &;
 
   auto call(const simulation_api_schema::UpdateEntityStatusRequest &)
-    -> simulation_api_schema::UpdateEntityStatusResponse;
+    -> const simulation_api_schema::UpdateEntityStatusResponse &;
 
   auto call(const simulation_api_schema::AttachImuSensorRequest &)
-    -> simulation_api_schema::AttachImuSensorResponse;
+    -> const simulation_api_schema::AttachImuSensorResponse &;
 
   auto call(const simulation_api_schema::AttachLidarSensorRequest &)
-    -> simulation_api_schema::AttachLidarSensorResponse;
+    -> const simulation_api_schema::AttachLidarSensorResponse &;
 
   auto call(const simulation_api_schema::AttachDetectionSensorRequest &)
-    -> simulation_api_schema::AttachDetectionSensorResponse;
+    -> const simulation_api_schema::AttachDetectionSensorResponse &;
 
   auto call(const simulation_api_schema::AttachOccupancyGridSensorRequest &)
-    -> simulation_api_schema::AttachOccupancyGridSensorResponse;
+    -> const simulation_api_schema::AttachOccupancyGridSensorResponse &;
 
   auto call(const simulation_api_schema::UpdateTrafficLightsRequest &)
-    -> simulation_api_schema::UpdateTrafficLightsResponse;
+    -> const simulation_api_schema::UpdateTrafficLightsResponse &;
 
   auto call(const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest &)
-    -> simulation_api_schema::AttachPseudoTrafficLightDetectorResponse;
+    -> const simulation_api_schema::AttachPseudoTrafficLightDetectorResponse &;
+
+  /**
+   * @note Call only if the InitializeResponse says that the server supports the step.
+   */
+  auto call(const simulation_api_schema::StepRequest &)
+    -> const simulation_api_schema::StepResponse &;
+
+  /**
+   * @note Call only if the InitializeResponse says that the server supports the finalization.
+   */
+  auto call(const simulation_api_schema::FinalizeRequest &)
+    -> const simulation_api_schema::FinalizeResponse &;
+
+  /**
+   * @brief Send a request without waiting for its response
+   * @note The simulator handles the requests of a client in the order they are sent, whether by
+   * call or by callAsync, so every request sees the effects of the ones sent before it. The
+   * response is received when the future is waited for, or when a later call receives past it,
+   * so the client must outlive the future. The response to a future destroyed without being
+   * waited for is dropped on arrival. Like call, callAsync invalidates the response returned
+   * by the previous call.
+   */
+  auto callAsync(const simulation_api_schema::SimulationRequest &)
+    -> std::future<simulation_api_schema::SimulationResponse>;
+
+  auto callAsync(const simulation_api_schema::SpawnVehicleEntityRequest &)
+    -> std::future<simulation_api_schema::SpawnVehicleEntityResponse>;
+
+  auto callAsync(const simulation_api_schema::SpawnPedestrianEntityRequest &)
+    -> std::future<simulation_api_schema::SpawnPedestrianEntityResponse>;
+
+  auto callAsync(const simulation_api_schema::SpawnMiscObjectEntityRequest &)
+    -> std::future<simulation_api_schema::SpawnMiscObjectEntityResponse>;
+
+  auto callAsync(const simulation_api_schema::DespawnEntityRequest &)
+    -> std::future<simulation_api_schema::DespawnEntityResponse>;
+
+  auto callAsync(const simulation_api_schema::AttachImuSensorRequest &)
+    -> std::future<simulation_api_schema::AttachImuSensorResponse>;
+
+  auto callAsync(const simulation_api_schema::AttachLidarSensorRequest &)
+    -> std::future<simulation_api_schema::AttachLidarSensorResponse>;
+
+  auto callAsync(const simulation_api_schema::AttachDetectionSensorRequest &)
+    -> std::future<simulation_api_schema::AttachDetectionSensorResponse>;
+
+  auto callAsync(const simulation_api_schema::AttachOccupancyGridSensorRequest &)
+    -> std::future<simulation_api_schema::AttachOccupancyGridSensorResponse>;
+
+  auto callAsync(const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest &)
+    -> std::future<simulation_api_schema::AttachPseudoTrafficLightDetectorResponse>;
 
   const simulation_interface::TransportProtocol protocol;
   const std::string hostname;
 
+  // of the simulator, which hosts a session for each client that sends it a different one
+  const std::uint32_t session;
+
 private:
+  auto exchange(simulation_api_schema::SimulationRequest &)
+    -> const simulation_api_schema::SimulationResponse &;
+
+  // get takes the response out of the SimulationResponse
+  template <typename Response, typename Get>
+  auto exchangeAsync(simulation_api_schema::SimulationRequest &, Get get) -> std::future<Response>;
+
+  /**
+   * @brief Send the request on socket_, tagged with a new request ID
+   * @param copy false only if buffer_ is not touched again until the response has arrived
+   * @return the request ID, which the response is tagged with
+   */
+  auto send(simulation_api_schema::SimulationRequest &, bool copy) -> std::uint64_t;
+
+  /**
+   * @brief Receive the response to the request of the ID from socket_
+   * @note The responses received on the way are kept until they are asked for.
+   */
+  auto receive(std::uint64_t, simulation_api_schema::SimulationResponse &) -> void;
+
+  /**
+   * @brief Drop the response to the request of the ID, whose future was destroyed unwaited
+   */
+  auto forget(std::uint64_t) -> void;
+
+  // request ID of a future of callAsync, whose response is forgotten unless it was received
+  struct PendingResponse
+  {
+    MultiClient & client;
+
+    const std::uint64_t id;
+
+    bool is_received = false;
+
+    ~PendingResponse()
+    {
+      if (not is_received) {
+        client.forget(id);
+      }
+    }
+  };
+
   zmqpp::context context_;
   const zmqpp::socket_type type_;
   zmqpp::socket socket_;
 
+  const unsigned int socket_port_;
+
+  // holds the request and the response of the latest call, which call returns a part of
+  simulation_interface::MessageArena arena_;
+
+  // whether the server may be in this process, which is then called directly
+  const bool is_local_;
+
+  // used instead of socket_ if the server is on this host and serves shared memory
+  std::unique_ptr<simulation_interface::SharedMemoryChannel> shared_memory_channel_;
+
+  // whether to look for the channel again, which the server may not have created yet
+  bool may_open_shared_memory_channel_;
+
+  std::string buffer_;
+
+  std::uint64_t next_request_id_ = 0;
+
+  // requests sent on socket_ whose responses have not been received yet
+  std::size_t requests_in_flight_ = 0;
+
+  // serialized responses received before their request ID was asked for
+  std::map<std::uint64_t, std::string> received_responses_;
+
+  // requests whose responses are dropped on arrival, because nobody will ask for them
+  std::unordered_set<std::uint64_t> forgotten_requests_;
+
   bool is_running = true;
 };
 }  // namespace zeromq
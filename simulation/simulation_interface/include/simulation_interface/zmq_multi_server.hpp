@@ -16,11 +16,20 @@
 #define SIMULATION_INTERFACE__ZMQ_MULTI_SERVER_HPP_
 
 #include <simulation_api_schema.pb.h>
+#include <sys/eventfd.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <rclcpp/rclcpp.hpp>
 #include <scenario_simulator_exception/exception.hpp>
 #include <simulation_interface/constants.hpp>
+#include <simulation_interface/message_arena.hpp>
+#include <simulation_interface/shared_memory_channel.hpp>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -36,29 +45,73 @@ public:
     const simulation_interface::TransportProtocol & protocol,
     const simulation_interface::HostName & hostname, const unsigned int socket_port, Ts &&... xs)
   : context_(zmqpp::context()),
-    type_(zmqpp::socket_type::reply),
+    type_(zmqpp::socket_type::router),
     socket_(context_, type_),
+    socket_port_(socket_port),
+    stop_event_(eventfd(0, EFD_CLOEXEC)),
     functions_(std::forward<decltype(xs)>(xs)...)
   {
     socket_.bind(simulation_interface::getEndPoint(protocol, hostname, socket_port));
     poller_.add(socket_);
+    poller_.add(stop_event_);
+    if (protocol == simulation_interface::TransportProtocol::SHARED_MEMORY) {
+      shared_memory_channel_ = simulation_interface::SharedMemoryChannel::create(socket_port);
+      if (shared_memory_channel_) {
+        shared_memory_thread_ = std::thread(&MultiServer::serveSharedMemory, this);
+      }
+    }
     thread_ = std::thread(&MultiServer::start_poll, this);
+    // last, so that a server failing to start is never reachable by a client of this process
+    registerInProcess();
   }
 
   ~MultiServer();
 
+  /**
+   * @brief Handle `request` on the server of this process listening on `socket_port`, by a plain
+   * function call on the messages instead of a round trip through a socket
+   * @return false if no server of this process listens on `socket_port`
+   * @note Clients of a simulator embedded in their own process go through this.
+   */
+  static auto handleInProcess(
+    unsigned int socket_port, const simulation_api_schema::SimulationRequest &,
+    simulation_api_schema::SimulationResponse &) -> bool;
+
+  static auto isInProcess(unsigned int socket_port) -> bool;
+
 private:
-  void poll();
+  auto registerInProcess() -> void;
+
+  // calls of handleInProcess running on this server, guarded by the mutex of the registry
+  std::size_t in_process_calls_ = 0;
+
+  auto handle(
+    const simulation_api_schema::SimulationRequest &, simulation_api_schema::SimulationResponse &)
+    -> void;
+  void poll(std::chrono::milliseconds timeout);
   void start_poll();
+  void serveSharedMemory();
   std::thread thread_;
   const zmqpp::context context_;
   const zmqpp::socket_type type_;
   zmqpp::poller poller_;
   zmqpp::socket socket_;
 
+  const unsigned int socket_port_;
+
+  // written by the destructor to wake the thread blocked on poller_
+  const int stop_event_;
+
+  std::atomic_bool stopping_{false};
+
+  // reused by every request on socket_, so that they do not allocate once warmed up
+  simulation_interface::MessageArena socket_arena_;
+  std::string socket_buffer_;
+
+  // called with the session of the request
 #define DEFINE_FUNCTION_TYPE(TYPENAME)                                      \
   using TYPENAME = std::function<simulation_api_schema::TYPENAME##Response( \
-    const simulation_api_schema::TYPENAME##Request &)>
+    std::uint32_t, const simulation_api_schema::TYPENAME##Request &)>
 
   DEFINE_FUNCTION_TYPE(Initialize);
   DEFINE_FUNCTION_TYPE(UpdateFrame);
@@ -74,6 +127,7 @@ private:
   DEFINE_FUNCTION_TYPE(UpdateTrafficLights);
   DEFINE_FUNCTION_TYPE(AttachPseudoTrafficLightDetector);
   DEFINE_FUNCTION_TYPE(UpdateStepTime);
+  DEFINE_FUNCTION_TYPE(Finalize);
 
 #undef DEFINE_FUNCTION_TYPE
 
@@ -81,8 +135,15 @@ private:
     Initialize, UpdateFrame, SpawnVehicleEntity, SpawnPedestrianEntity, SpawnMiscObjectEntity,
     DespawnEntity, UpdateEntityStatus, AttachImuSensor, AttachLidarSensor, AttachDetectionSensor,
     AttachOccupancyGridSensor, UpdateTrafficLights, AttachPseudoTrafficLightDetector,
-    UpdateStepTime>
+    UpdateStepTime, Finalize>
     functions_;
+
+  // serializes the calls of functions_ from the socket and the shared memory channel
+  std::mutex mutex_;
+
+  std::unique_ptr<simulation_interface::SharedMemoryChannel> shared_memory_channel_;
+
+  std::thread shared_memory_thread_;
 };
 }  // namespace zeromq
 
@@ -21,15 +21,16 @@ namespace simulation_interface
 std::string getEndPoint(
   const TransportProtocol & protocol, const HostName & hostname, const unsigned int & port)
 {
-  return simulation_interface::enumToString(protocol) + "://" +
-         simulation_interface::enumToString(hostname) + ":" + std::to_string(port);
+  return getEndPoint(protocol, simulation_interface::enumToString(hostname), port);
 }
 
 std::string getEndPoint(
   const TransportProtocol & protocol, const std::string & hostname, const unsigned int & port)
 {
-  return simulation_interface::enumToString(protocol) + "://" + hostname + ":" +
-         std::to_string(port);
+  // the shared memory transport keeps the TCP socket for clients on other hosts
+  return simulation_interface::enumToString(
+           protocol == TransportProtocol::SHARED_MEMORY ? TransportProtocol::TCP : protocol) +
+         "://" + hostname + ":" + std::to_string(port);
 }
 
 std::string enumToString(const TransportProtocol & protocol)
@@ -37,12 +38,14 @@ std::string enumToString(const TransportProtocol & protocol)
   switch (protocol) {
     case TransportProtocol::TCP:
       return "tcp";
+    case TransportProtocol::SHARED_MEMORY:
+      return "shm";
       /*
     case TransportProtocol::UDP:
       return "udp";              
       */
   }
-  THROW_SIMULATION_ERROR("Protocol should be TCP.");  // LCOV_EXCL_LINE
+  THROW_SIMULATION_ERROR("Protocol should be TCP or SHARED_MEMORY.");  // LCOV_EXCL_LINE
 }
 
 std::string enumToString(const HostName & hostname)
@@ -0,0 +1,368 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <simulation_interface/shared_memory_channel.hpp>
+#include <string>
+
+namespace simulation_interface
+{
+namespace
+{
+static_assert(
+  sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+  "A futex word must be a plain 32-bit integer");
+
+auto wait(std::atomic<std::uint32_t> & word, std::uint32_t expected, const timespec * timeout)
+  -> void
+{
+  // not FUTEX_PRIVATE_FLAG, because the word is shared with another process
+  syscall(
+    SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, timeout, nullptr,
+    0);
+}
+
+auto wake(std::atomic<std::uint32_t> & word) -> void
+{
+  syscall(
+    SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// the longest a wait sleeps before checking whether to give up
+constexpr auto poll_interval = timespec{0, 100'000'000};
+
+auto isAlive(pid_t pid) -> bool { return 0 < pid and (kill(pid, 0) == 0 or errno == EPERM); }
+
+auto getName(unsigned int port) -> std::string
+{
+  return "/simulation_interface_" + std::to_string(port);
+}
+}  // namespace
+
+/**
+ * @brief Single-producer single-consumer byte ring placed in the shared region
+ * @note `head` and `tail` count every byte ever written and read, so the ring is empty when they
+ * are equal and full when they are `capacity` apart. Each side bumps its sequence word after
+ * moving its counter, and the other side sleeps on that word.
+ */
+struct SharedMemoryChannel::Ring
+{
+  alignas(64) std::atomic<std::uint32_t> written_sequence;
+
+  alignas(64) std::atomic<std::uint32_t> read_sequence;
+
+  alignas(64) std::atomic<std::uint64_t> head;
+
+  alignas(64) std::atomic<std::uint64_t> tail;
+
+  std::uint64_t capacity;
+
+  // from the ring itself to its bytes, which keeps the ring valid wherever the region is mapped
+  std::uint64_t offset;
+
+  auto data() -> char * { return reinterpret_cast<char *>(this) + offset; }
+
+  /**
+   * @brief Wait until there is something to read
+   * @param timeout no timeout if nullptr
+   * @return false if there is still nothing to read after `timeout`
+   */
+  auto waitReadable(const timespec * timeout) -> bool
+  {
+    while (true) {
+      const auto sequence = written_sequence.load(std::memory_order_acquire);
+      if (head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed)) {
+        return true;
+      } else if (timeout) {
+        wait(written_sequence, sequence, timeout);
+        return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed);
+      } else {
+        wait(written_sequence, sequence, nullptr);
+      }
+    }
+  }
+
+  /**
+   * @param interrupted called before every sleep, to give up by throwing if it returns true
+   */
+  template <typename Predicate>
+  auto write(const char * bytes, std::size_t size, Predicate interrupted) -> void
+  {
+    while (0 < size) {
+      const auto sequence = read_sequence.load(std::memory_order_acquire);
+      const auto written = head.load(std::memory_order_relaxed);
+      if (const auto space = capacity - (written - tail.load(std::memory_order_acquire))) {
+        const auto position = written % capacity;
+        const auto count = std::min<std::uint64_t>({size, space, capacity - position});
+        std::memcpy(data() + position, bytes, count);
+        head.store(written + count, std::memory_order_release);
+        written_sequence.fetch_add(1, std::memory_order_release);
+        wake(written_sequence);
+        bytes += count;
+        size -= count;
+      } else if (interrupted()) {
+        throw Interrupted("The peer stopped reading the shared memory channel");
+      } else {
+        wait(read_sequence, sequence, &poll_interval);
+      }
+    }
+  }
+
+  template <typename Predicate>
+  auto read(char * bytes, std::size_t size, Predicate interrupted) -> void
+  {
+    while (0 < size) {
+      if (not waitReadable(&poll_interval)) {
+        if (interrupted()) {
+          throw Interrupted("The peer stopped writing the shared memory channel");
+        }
+        continue;
+      }
+      const auto read = tail.load(std::memory_order_relaxed);
+      const auto position = read % capacity;
+      const auto count = std::min<std::uint64_t>(
+        {size, head.load(std::memory_order_acquire) - read, capacity - position});
+      std::memcpy(bytes, data() + position, count);
+      tail.store(read + count, std::memory_order_release);
+      read_sequence.fetch_add(1, std::memory_order_release);
+      wake(read_sequence);
+      bytes += count;
+      size -= count;
+    }
+  }
+
+  // only while neither side touches the ring
+  auto clear() -> void
+  {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+};
+
+struct SharedMemoryChannel::Region
+{
+  std::atomic<std::uint32_t> ready;
+
+  std::atomic<pid_t> server;
+
+  std::atomic<pid_t> client;
+
+  /*
+     A client bumps attachments on attaching, and waits before its first
+     message until the server, having emptied the rings, sets acceptances to
+     the same value.
+  */
+  std::atomic<std::uint32_t> attachments;
+
+  std::atomic<std::uint32_t> acceptances;
+
+  Ring requests;
+
+  Ring responses;
+};
+
+SharedMemoryChannel::SharedMemoryChannel(
+  const std::string & name, bool is_server, Region * region, std::size_t size, Ring & input,
+  Ring & output)
+: name_(name),
+  is_server_(is_server),
+  region_(region),
+  size_(size),
+  input_(input),
+  output_(output)
+{
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+  if (is_server_) {
+    region_->ready.store(0, std::memory_order_release);
+    munmap(region_, size_);
+    shm_unlink(name_.c_str());
+  } else {
+    region_->client.store(0, std::memory_order_release);
+    munmap(region_, size_);
+  }
+}
+
+auto SharedMemoryChannel::create(unsigned int port, std::size_t ring_capacity)
+  -> std::unique_ptr<SharedMemoryChannel>
+{
+  const auto name = getName(port);
+  const auto capacity = (ring_capacity + 63) / 64 * 64;
+  const auto size = sizeof(Region) + 2 * capacity;
+
+  shm_unlink(name.c_str());
+  const auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return nullptr;
+  } else if (ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+  const auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // ftruncate filled the region with zeros, which is the initial state of every counter
+  auto region = new (address) Region();
+  auto bytes = static_cast<char *>(address) + sizeof(Region);
+  region->requests.capacity = capacity;
+  region->requests.offset = bytes - reinterpret_cast<char *>(&region->requests);
+  region->responses.capacity = capacity;
+  region->responses.offset = bytes + capacity - reinterpret_cast<char *>(&region->responses);
+  region->server.store(getpid(), std::memory_order_relaxed);
+  region->ready.store(1, std::memory_order_release);
+
+  return std::unique_ptr<SharedMemoryChannel>(
+    new SharedMemoryChannel(name, true, region, size, region->requests, region->responses));
+}
+
+auto SharedMemoryChannel::open(unsigned int port) -> std::unique_ptr<SharedMemoryChannel>
+{
+  const auto name = getName(port);
+
+  const auto fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 or static_cast<std::size_t>(status.st_size) < sizeof(Region)) {
+    close(fd);
+    return nullptr;
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  const auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto region = static_cast<Region *>(address);
+  // a client that died without detaching leaves its PID behind, which is taken over
+  auto vacant = region->client.load(std::memory_order_relaxed);
+  if (
+    region->ready.load(std::memory_order_acquire) == 1 and
+    isAlive(region->server.load(std::memory_order_relaxed)) and not isAlive(vacant) and
+    region->client.compare_exchange_strong(vacant, getpid())) {
+    region->attachments.fetch_add(1, std::memory_order_acq_rel);
+    // the server may be asleep waiting for a request
+    wake(region->requests.written_sequence);
+    return std::unique_ptr<SharedMemoryChannel>(
+      new SharedMemoryChannel(name, false, region, size, region->responses, region->requests));
+  } else {
+    munmap(address, size);
+    return nullptr;
+  }
+}
+
+auto SharedMemoryChannel::acceptClient() -> void
+{
+  const auto attachments = region_->attachments.load(std::memory_order_acquire);
+  if (attachments != region_->acceptances.load(std::memory_order_relaxed)) {
+    region_->requests.clear();
+    region_->responses.clear();
+    region_->acceptances.store(attachments, std::memory_order_release);
+    wake(region_->acceptances);
+  }
+}
+
+auto SharedMemoryChannel::isInterrupted() const -> bool
+{
+  return stopped_.load(std::memory_order_acquire) or not isPeerAlive() or
+         (is_server_ and region_->attachments.load(std::memory_order_acquire) !=
+                           region_->acceptances.load(std::memory_order_relaxed));
+}
+
+auto SharedMemoryChannel::send(const std::string & message) -> void
+{
+  const auto interrupted = [this]() { return isInterrupted(); };
+  if (not is_server_) {
+    while (true) {
+      const auto acceptances = region_->acceptances.load(std::memory_order_acquire);
+      if (acceptances == region_->attachments.load(std::memory_order_relaxed)) {
+        break;
+      } else if (interrupted()) {
+        throw Interrupted("The server did not accept the shared memory channel");
+      } else {
+        wait(region_->acceptances, acceptances, &poll_interval);
+      }
+    }
+  }
+  const auto size = static_cast<std::uint64_t>(message.size());
+  output_.write(reinterpret_cast<const char *>(&size), sizeof(size), interrupted);
+  output_.write(message.data(), message.size(), interrupted);
+}
+
+auto SharedMemoryChannel::receive(std::string & message, std::chrono::milliseconds timeout)
+  -> bool
+{
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds);
+  const auto timespec_timeout = timespec{
+    static_cast<std::time_t>(seconds.count()), static_cast<long>(nanoseconds.count())};
+  if (is_server_) {
+    acceptClient();
+  }
+  if (stopped_.load(std::memory_order_acquire) or not input_.waitReadable(&timespec_timeout)) {
+    return false;
+  }
+  const auto interrupted = [this]() { return isInterrupted(); };
+  auto size = std::uint64_t(0);
+  input_.read(reinterpret_cast<char *>(&size), sizeof(size), interrupted);
+  message.resize(size);
+  if (0 < size) {
+    input_.read(&message[0], size, interrupted);
+  }
+  return true;
+}
+
+auto SharedMemoryChannel::stop() -> void
+{
+  stopped_.store(true, std::memory_order_release);
+  wake(input_.written_sequence);
+  wake(output_.read_sequence);
+  wake(region_->acceptances);
+}
+
+auto SharedMemoryChannel::isPeerAlive() const -> bool
+{
+  if (is_server_) {
+    return isAlive(region_->client.load(std::memory_order_relaxed));
+  } else {
+    return region_->ready.load(std::memory_order_acquire) == 1 and
+           isAlive(region_->server.load(std::memory_order_relaxed));
+  }
+}
+}  // namespace simulation_interface
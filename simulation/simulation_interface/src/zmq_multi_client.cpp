@@ -12,210 +12,568 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+#include <cstring>
+#include <future>
 #include <rclcpp/utilities.hpp>
 #include <simulation_interface/conversions.hpp>
 #include <simulation_interface/zmq_multi_client.hpp>
+#include <simulation_interface/zmq_multi_server.hpp>
 #include <string>
 namespace zeromq
 {
 MultiClient::MultiClient(
   const simulation_interface::TransportProtocol & protocol, const std::string & hostname,
-  const unsigned int socket_port)
+  const unsigned int socket_port, const std::uint32_t session)
 : protocol(protocol),
   hostname(hostname),
+  session(session),
   context_(zmqpp::context()),
-  type_(zmqpp::socket_type::request),
-  socket_(context_, type_)
+  type_(zmqpp::socket_type::dealer),
+  socket_(context_, type_),
+  socket_port_(socket_port),
+  is_local_(hostname == "localhost" or hostname == "127.0.0.1"),
+  may_open_shared_memory_channel_(
+    protocol == simulation_interface::TransportProtocol::SHARED_MEMORY and is_local_)
 {
   socket_.connect(simulation_interface::getEndPoint(protocol, hostname, socket_port));
+  if (may_open_shared_memory_channel_) {
+    shared_memory_channel_ = simulation_interface::SharedMemoryChannel::open(socket_port_);
+  }
 }
 
 void MultiClient::closeConnection()
 {
   if (is_running) {
     is_running = false;
+    shared_memory_channel_.reset();
     socket_.close();
   }
 }
 
 MultiClient::~MultiClient() { closeConnection(); }
 
-auto MultiClient::call(const simulation_api_schema::SimulationRequest & req)
-  -> simulation_api_schema::SimulationResponse
+auto MultiClient::call(const simulation_api_schema::SimulationRequest & request)
+  -> const simulation_api_schema::SimulationResponse &
+{
+  arena_.reset();
+  auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+  *simulation_request = request;
+  return exchange(*simulation_request);
+}
+
+auto MultiClient::exchange(simulation_api_schema::SimulationRequest & request)
+  -> const simulation_api_schema::SimulationResponse &
 {
-  zmqpp::message message = toZMQ(req);
+  request.set_session(session);
+  auto response = arena_.create<simulation_api_schema::SimulationResponse>();
+  /*
+     Requests still in flight on the socket would be overtaken by a call in
+     this process, which is why the socket serves until they have arrived.
+  */
+  if (
+    is_local_ and requests_in_flight_ == 0 and
+    MultiServer::handleInProcess(socket_port_, request, *response)) {
+    return *response;
+  }
+  if (shared_memory_channel_) {
+    request.SerializeToString(&buffer_);
+    shared_memory_channel_->send(buffer_);
+    while (not shared_memory_channel_->receive(buffer_, std::chrono::milliseconds(100))) {
+      if (not rclcpp::ok()) {
+        THROW_SIMULATION_ERROR(
+          "Interrupted while waiting for the simulator on port ", socket_port_);
+      } else if (not shared_memory_channel_->isPeerAlive()) {
+        THROW_SIMULATION_ERROR(
+          "The simulator on port ", socket_port_, " exited without a response");
+      }
+    }
+    response->ParseFromString(buffer_);
+  } else {
+    receive(send(request, false), *response);
+  }
+  return *response;
+}
+
+template <typename Response, typename Get>
+auto MultiClient::exchangeAsync(simulation_api_schema::SimulationRequest & request, Get get)
+  -> std::future<Response>
+{
+  if (
+    shared_memory_channel_ or
+    (is_local_ and requests_in_flight_ == 0 and MultiServer::isInProcess(socket_port_))) {
+    // a round trip costs no more than a function call here, so there is no latency to hide
+    std::promise<Response> promise;
+    promise.set_value(get(exchange(request)));
+    return promise.get_future();
+  } else {
+    /*
+       The response is kept until the future asks for it, so a future destroyed
+       without asking has the client forget the response instead.
+    */
+    auto pending =
+      std::unique_ptr<PendingResponse>(new PendingResponse{*this, send(request, true)});
+    return std::async(std::launch::deferred, [this, pending = std::move(pending), get]() {
+      if (is_running) {
+        simulation_api_schema::SimulationResponse response;
+        receive(pending->id, response);
+        pending->is_received = true;
+        return Response(get(response));
+      } else {
+        return Response();
+      }
+    });
+  }
+}
+
+auto MultiClient::send(simulation_api_schema::SimulationRequest & request, bool copy)
+  -> std::uint64_t
+{
+  request.set_session(session);
+  request.SerializeToString(&buffer_);
+  /*
+     The request ID is a frame of its own ahead of the request, which the
+     server sends back ahead of the response, so that responses can be told
+     apart without parsing them.
+  */
+  const auto id = next_request_id_++;
+  zmqpp::message message;
+  message.add_raw(&id, sizeof(id));
+  if (copy) {
+    message.add_raw(buffer_.data(), buffer_.size());
+  } else {
+    message.add_nocopy_const(buffer_.data(), buffer_.size());
+  }
   socket_.send(message);
-  zmqpp::message buffer;
-  socket_.receive(buffer);
-  return toProto<simulation_api_schema::SimulationResponse>(buffer);
+  ++requests_in_flight_;
+  return id;
+}
+
+auto MultiClient::receive(std::uint64_t id, simulation_api_schema::SimulationResponse & response)
+  -> void
+{
+  const auto iter = received_responses_.find(id);
+  if (iter != received_responses_.end()) {
+    response.ParseFromString(iter->second);
+    received_responses_.erase(iter);
+    return;
+  }
+  while (true) {
+    zmqpp::message reply;
+    socket_.receive(reply);
+    --requests_in_flight_;
+    if (may_open_shared_memory_channel_ and requests_in_flight_ == 0) {
+      /*
+         The server has answered, so it has created its channel by now if it
+         ever will. Nothing is left in flight on the socket, so no request on
+         the channel can overtake one on the socket.
+      */
+      may_open_shared_memory_channel_ = false;
+      shared_memory_channel_ = simulation_interface::SharedMemoryChannel::open(socket_port_);
+    }
+    auto reply_id = std::uint64_t(0);
+    std::memcpy(&reply_id, reply.raw_data(0), sizeof(reply_id));
+    if (reply_id == id) {
+      response.ParseFromArray(reply.raw_data(1), static_cast<int>(reply.size(1)));
+      return;
+    } else if (forgotten_requests_.erase(reply_id) == 0) {
+      received_responses_.emplace(reply_id, reply.get(1));
+    }
+  }
+}
+
+auto MultiClient::forget(std::uint64_t id) -> void
+{
+  if (is_running and received_responses_.erase(id) == 0) {
+    forgotten_requests_.insert(id);
+  }
 }
 
 auto MultiClient::call(const simulation_api_schema::InitializeRequest & request)
-  -> simulation_api_schema::InitializeResponse
+  -> const simulation_api_schema::InitializeResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_initialize() = request;
-    return call(sim_request).initialize();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_initialize() = request;
+    return exchange(*simulation_request).initialize();
   } else {
-    return {};
+    return simulation_api_schema::InitializeResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::UpdateFrameRequest & request)
-  -> simulation_api_schema::UpdateFrameResponse
+  -> const simulation_api_schema::UpdateFrameResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_update_frame() = request;
-    return call(sim_request).update_frame();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_update_frame() = request;
+    return exchange(*simulation_request).update_frame();
   } else {
-    return {};
+    return simulation_api_schema::UpdateFrameResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::UpdateStepTimeRequest & request)
-  -> simulation_api_schema::UpdateStepTimeResponse
+  -> const simulation_api_schema::UpdateStepTimeResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_update_step_time() = request;
-    return call(sim_request).update_step_time();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_update_step_time() = request;
+    return exchange(*simulation_request).update_step_time();
   } else {
-    return {};
+    return simulation_api_schema::UpdateStepTimeResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::SpawnVehicleEntityRequest & request)
-  -> simulation_api_schema::SpawnVehicleEntityResponse
+  -> const simulation_api_schema::SpawnVehicleEntityResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_spawn_vehicle_entity() = request;
-    return call(sim_request).spawn_vehicle_entity();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_vehicle_entity() = request;
+    return exchange(*simulation_request).spawn_vehicle_entity();
   } else {
-    return {};
+    return simulation_api_schema::SpawnVehicleEntityResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::SpawnPedestrianEntityRequest & request)
-  -> simulation_api_schema::SpawnPedestrianEntityResponse
+  -> const simulation_api_schema::SpawnPedestrianEntityResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_spawn_pedestrian_entity() = request;
-    return call(sim_request).spawn_pedestrian_entity();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_pedestrian_entity() = request;
+    return exchange(*simulation_request).spawn_pedestrian_entity();
   } else {
-    return {};
+    return simulation_api_schema::SpawnPedestrianEntityResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::SpawnMiscObjectEntityRequest & request)
-  -> simulation_api_schema::SpawnMiscObjectEntityResponse
+  -> const simulation_api_schema::SpawnMiscObjectEntityResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_spawn_misc_object_entity() = request;
-    return call(sim_request).spawn_misc_object_entity();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_misc_object_entity() = request;
+    return exchange(*simulation_request).spawn_misc_object_entity();
   } else {
-    return {};
+    return simulation_api_schema::SpawnMiscObjectEntityResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::DespawnEntityRequest & request)
-  -> simulation_api_schema::DespawnEntityResponse
+  -> const simulation_api_schema::DespawnEntityResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_despawn_entity() = request;
-    return call(sim_request).despawn_entity();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_despawn_entity() = request;
+    return exchange(*simulation_request).despawn_entity();
   } else {
-    return {};
+    return simulation_api_schema::DespawnEntityResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::UpdateEntityStatusRequest & request)
-  -> simulation_api_schema::UpdateEntityStatusResponse
+  -> const simulation_api_schema::UpdateEntityStatusResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_update_entity_status() = request;
-    return call(sim_request).update_entity_status();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_update_entity_status() = request;
+    return exchange(*simulation_request).update_entity_status();
   } else {
-    return {};
+    return simulation_api_schema::UpdateEntityStatusResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::AttachImuSensorRequest & request)
-  -> simulation_api_schema::AttachImuSensorResponse
+  -> const simulation_api_schema::AttachImuSensorResponse &
 {
   if (is_running) {
-    auto simulation_request = simulation_api_schema::SimulationRequest();
-    *simulation_request.mutable_attach_imu_sensor() = request;
-    return call(simulation_request).attach_imu_sensor();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_imu_sensor() = request;
+    return exchange(*simulation_request).attach_imu_sensor();
   } else {
-    return {};
+    return simulation_api_schema::AttachImuSensorResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::AttachLidarSensorRequest & request)
-  -> simulation_api_schema::AttachLidarSensorResponse
+  -> const simulation_api_schema::AttachLidarSensorResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_attach_lidar_sensor() = request;
-    return call(sim_request).attach_lidar_sensor();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_lidar_sensor() = request;
+    return exchange(*simulation_request).attach_lidar_sensor();
   } else {
-    return {};
+    return simulation_api_schema::AttachLidarSensorResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::AttachDetectionSensorRequest & request)
-  -> simulation_api_schema::AttachDetectionSensorResponse
+  -> const simulation_api_schema::AttachDetectionSensorResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_attach_detection_sensor() = request;
-    return call(sim_request).attach_detection_sensor();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_detection_sensor() = request;
+    return exchange(*simulation_request).attach_detection_sensor();
   } else {
-    return {};
+    return simulation_api_schema::AttachDetectionSensorResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::AttachOccupancyGridSensorRequest & request)
-  -> simulation_api_schema::AttachOccupancyGridSensorResponse
+  -> const simulation_api_schema::AttachOccupancyGridSensorResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_attach_occupancy_grid_sensor() = request;
-    return call(sim_request).attach_occupancy_grid_sensor();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_occupancy_grid_sensor() = request;
+    return exchange(*simulation_request).attach_occupancy_grid_sensor();
   } else {
-    return {};
+    return simulation_api_schema::AttachOccupancyGridSensorResponse::default_instance();
   }
 }
 
 auto MultiClient::call(const simulation_api_schema::UpdateTrafficLightsRequest & request)
-  -> simulation_api_schema::UpdateTrafficLightsResponse
+  -> const simulation_api_schema::UpdateTrafficLightsResponse &
 {
   if (is_running) {
-    simulation_api_schema::SimulationRequest sim_request;
-    *sim_request.mutable_update_traffic_lights() = request;
-    return call(sim_request).update_traffic_lights();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_update_traffic_lights() = request;
+    return exchange(*simulation_request).update_traffic_lights();
   } else {
-    return {};
+    return simulation_api_schema::UpdateTrafficLightsResponse::default_instance();
   }
 }
 
 auto MultiClient::call(
   const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest & request)
-  -> simulation_api_schema::AttachPseudoTrafficLightDetectorResponse
+  -> const simulation_api_schema::AttachPseudoTrafficLightDetectorResponse &
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_pseudo_traffic_light_detector() = request;
+    return exchange(*simulation_request).attach_pseudo_traffic_light_detector();
+  } else {
+    return simulation_api_schema::AttachPseudoTrafficLightDetectorResponse::default_instance();
+  }
+}
+
+auto MultiClient::call(const simulation_api_schema::StepRequest & request)
+  -> const simulation_api_schema::StepResponse &
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_step() = request;
+    return exchange(*simulation_request).step();
+  } else {
+    return simulation_api_schema::StepResponse::default_instance();
+  }
+}
+
+auto MultiClient::call(const simulation_api_schema::FinalizeRequest & request)
+  -> const simulation_api_schema::FinalizeResponse &
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_finalize() = request;
+    return exchange(*simulation_request).finalize();
+  } else {
+    return simulation_api_schema::FinalizeResponse::default_instance();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::SimulationRequest & request)
+  -> std::future<simulation_api_schema::SimulationResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request = request;
+    return exchangeAsync<simulation_api_schema::SimulationResponse>(
+      *simulation_request, [](const auto & response) -> const auto & { return response; });
+  } else {
+    std::promise<simulation_api_schema::SimulationResponse> promise;
+    promise.set_value(simulation_api_schema::SimulationResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::SpawnVehicleEntityRequest & request)
+  -> std::future<simulation_api_schema::SpawnVehicleEntityResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_vehicle_entity() = request;
+    return exchangeAsync<simulation_api_schema::SpawnVehicleEntityResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.spawn_vehicle_entity();
+      });
+  } else {
+    std::promise<simulation_api_schema::SpawnVehicleEntityResponse> promise;
+    promise.set_value(simulation_api_schema::SpawnVehicleEntityResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::SpawnPedestrianEntityRequest & request)
+  -> std::future<simulation_api_schema::SpawnPedestrianEntityResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_pedestrian_entity() = request;
+    return exchangeAsync<simulation_api_schema::SpawnPedestrianEntityResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.spawn_pedestrian_entity();
+      });
+  } else {
+    std::promise<simulation_api_schema::SpawnPedestrianEntityResponse> promise;
+    promise.set_value(simulation_api_schema::SpawnPedestrianEntityResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::SpawnMiscObjectEntityRequest & request)
+  -> std::future<simulation_api_schema::SpawnMiscObjectEntityResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_spawn_misc_object_entity() = request;
+    return exchangeAsync<simulation_api_schema::SpawnMiscObjectEntityResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.spawn_misc_object_entity();
+      });
+  } else {
+    std::promise<simulation_api_schema::SpawnMiscObjectEntityResponse> promise;
+    promise.set_value(simulation_api_schema::SpawnMiscObjectEntityResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::DespawnEntityRequest & request)
+  -> std::future<simulation_api_schema::DespawnEntityResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_despawn_entity() = request;
+    return exchangeAsync<simulation_api_schema::DespawnEntityResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.despawn_entity();
+      });
+  } else {
+    std::promise<simulation_api_schema::DespawnEntityResponse> promise;
+    promise.set_value(simulation_api_schema::DespawnEntityResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::AttachImuSensorRequest & request)
+  -> std::future<simulation_api_schema::AttachImuSensorResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_imu_sensor() = request;
+    return exchangeAsync<simulation_api_schema::AttachImuSensorResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.attach_imu_sensor();
+      });
+  } else {
+    std::promise<simulation_api_schema::AttachImuSensorResponse> promise;
+    promise.set_value(simulation_api_schema::AttachImuSensorResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::AttachLidarSensorRequest & request)
+  -> std::future<simulation_api_schema::AttachLidarSensorResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_lidar_sensor() = request;
+    return exchangeAsync<simulation_api_schema::AttachLidarSensorResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.attach_lidar_sensor();
+      });
+  } else {
+    std::promise<simulation_api_schema::AttachLidarSensorResponse> promise;
+    promise.set_value(simulation_api_schema::AttachLidarSensorResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::AttachDetectionSensorRequest & request)
+  -> std::future<simulation_api_schema::AttachDetectionSensorResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_detection_sensor() = request;
+    return exchangeAsync<simulation_api_schema::AttachDetectionSensorResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.attach_detection_sensor();
+      });
+  } else {
+    std::promise<simulation_api_schema::AttachDetectionSensorResponse> promise;
+    promise.set_value(simulation_api_schema::AttachDetectionSensorResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(const simulation_api_schema::AttachOccupancyGridSensorRequest & request)
+  -> std::future<simulation_api_schema::AttachOccupancyGridSensorResponse>
+{
+  if (is_running) {
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_occupancy_grid_sensor() = request;
+    return exchangeAsync<simulation_api_schema::AttachOccupancyGridSensorResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.attach_occupancy_grid_sensor();
+      });
+  } else {
+    std::promise<simulation_api_schema::AttachOccupancyGridSensorResponse> promise;
+    promise.set_value(simulation_api_schema::AttachOccupancyGridSensorResponse());
+    return promise.get_future();
+  }
+}
+
+auto MultiClient::callAsync(
+  const simulation_api_schema::AttachPseudoTrafficLightDetectorRequest & request)
+  -> std::future<simulation_api_schema::AttachPseudoTrafficLightDetectorResponse>
 {
   if (is_running) {
-    auto simulation_request = simulation_api_schema::SimulationRequest();
-    *simulation_request.mutable_attach_pseudo_traffic_light_detector() = request;
-    return call(simulation_request).attach_pseudo_traffic_light_detector();
+    arena_.reset();
+    auto simulation_request = arena_.create<simulation_api_schema::SimulationRequest>();
+    *simulation_request->mutable_attach_pseudo_traffic_light_detector() = request;
+    return exchangeAsync<simulation_api_schema::AttachPseudoTrafficLightDetectorResponse>(
+      *simulation_request, [](const auto & response) -> const auto & {
+        return response.attach_pseudo_traffic_light_detector();
+      });
   } else {
-    return {};
+    std::promise<simulation_api_schema::AttachPseudoTrafficLightDetectorResponse> promise;
+    promise.set_value(simulation_api_schema::AttachPseudoTrafficLightDetectorResponse());
+    return promise.get_future();
   }
 }
 }  // namespace zeromq
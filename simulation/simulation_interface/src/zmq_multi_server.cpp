@@ -12,94 +12,284 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <simulation_interface/conversions.hpp>
+#include <simulation_interface/message_arena.hpp>
 #include <simulation_interface/zmq_multi_server.hpp>
 #include <status_monitor/status_monitor.hpp>
+#include <string>
+#include <unordered_map>
 
 namespace zeromq
 {
-MultiServer::~MultiServer() { thread_.join(); }
+namespace
+{
+// servers of this process by their port, guarded by getServersMutex
+auto getServers() -> std::unordered_map<unsigned int, MultiServer *> &
+{
+  static std::unordered_map<unsigned int, MultiServer *> servers;
+  return servers;
+}
+
+auto getServersMutex() -> std::mutex &
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+// notified whenever a call of handleInProcess returns
+auto getServersCondition() -> std::condition_variable &
+{
+  static std::condition_variable condition;
+  return condition;
+}
+}  // namespace
+
+auto MultiServer::registerInProcess() -> void
+{
+  std::lock_guard<std::mutex> lock(getServersMutex());
+  getServers()[socket_port_] = this;
+}
+
+auto MultiServer::handleInProcess(
+  unsigned int socket_port, const simulation_api_schema::SimulationRequest & request,
+  simulation_api_schema::SimulationResponse & response) -> bool
+{
+  /*
+     The server is pinned by its count of calls instead of holding the
+     mutex of the registry during the call, so that the servers of this
+     process handle requests concurrently, and a handler may look the
+     registry up. The destructor waits for the count to drop to zero.
+  */
+  MultiServer * server = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(getServersMutex());
+    const auto iter = getServers().find(socket_port);
+    if (iter == getServers().end()) {
+      return false;
+    }
+    server = iter->second;
+    ++server->in_process_calls_;
+  }
+  auto unpin = [server]() {
+    std::lock_guard<std::mutex> lock(getServersMutex());
+    --server->in_process_calls_;
+    getServersCondition().notify_all();
+  };
+  try {
+    server->handle(request, response);
+  } catch (...) {
+    unpin();
+    throw;
+  }
+  unpin();
+  return true;
+}
+
+auto MultiServer::isInProcess(unsigned int socket_port) -> bool
+{
+  std::lock_guard<std::mutex> lock(getServersMutex());
+  return getServers().find(socket_port) != getServers().end();
+}
+
+MultiServer::~MultiServer()
+{
+  {
+    std::unique_lock<std::mutex> lock(getServersMutex());
+    const auto iter = getServers().find(socket_port_);
+    if (iter != getServers().end() and iter->second == this) {
+      getServers().erase(iter);
+    }
+    getServersCondition().wait(lock, [this]() { return in_process_calls_ == 0; });
+  }
+  stopping_.store(true, std::memory_order_release);
+  const auto one = std::uint64_t(1);
+  while (write(stop_event_, &one, sizeof(one)) < 0 and errno == EINTR) {
+  }
+  thread_.join();
+  if (shared_memory_thread_.joinable()) {
+    shared_memory_channel_->stop();
+    shared_memory_thread_.join();
+  }
+  close(stop_event_);
+}
 
-void MultiServer::poll()
+auto MultiServer::handle(
+  const simulation_api_schema::SimulationRequest & proto,
+  simulation_api_schema::SimulationResponse & sim_response) -> void
 {
-  constexpr long timeout_ms = 1L;
-  poller_.poll(timeout_ms);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto session = proto.session();
+  switch (proto.request_case()) {
+    case simulation_api_schema::SimulationRequest::RequestCase::kInitialize:
+      *sim_response.mutable_initialize() =
+        std::get<Initialize>(functions_)(session, proto.initialize());
+      // the step is composed here of the functions every simulator has
+      sim_response.mutable_initialize()->set_supports_step(true);
+      sim_response.mutable_initialize()->set_supports_finalize(true);
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kUpdateFrame:
+      *sim_response.mutable_update_frame() =
+        std::get<UpdateFrame>(functions_)(session, proto.update_frame());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kSpawnVehicleEntity:
+      *sim_response.mutable_spawn_vehicle_entity() =
+        std::get<SpawnVehicleEntity>(functions_)(session, proto.spawn_vehicle_entity());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kSpawnPedestrianEntity:
+      *sim_response.mutable_spawn_pedestrian_entity() =
+        std::get<SpawnPedestrianEntity>(functions_)(session, proto.spawn_pedestrian_entity());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kSpawnMiscObjectEntity:
+      *sim_response.mutable_spawn_misc_object_entity() =
+        std::get<SpawnMiscObjectEntity>(functions_)(session, proto.spawn_misc_object_entity());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kDespawnEntity:
+      *sim_response.mutable_despawn_entity() =
+        std::get<DespawnEntity>(functions_)(session, proto.despawn_entity());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kUpdateEntityStatus:
+      *sim_response.mutable_update_entity_status() =
+        std::get<UpdateEntityStatus>(functions_)(session, proto.update_entity_status());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kAttachImuSensor:
+      *sim_response.mutable_attach_imu_sensor() =
+        std::get<AttachImuSensor>(functions_)(session, proto.attach_imu_sensor());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kAttachLidarSensor:
+      *sim_response.mutable_attach_lidar_sensor() =
+        std::get<AttachLidarSensor>(functions_)(session, proto.attach_lidar_sensor());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kAttachDetectionSensor:
+      *sim_response.mutable_attach_detection_sensor() =
+        std::get<AttachDetectionSensor>(functions_)(session, proto.attach_detection_sensor());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kAttachOccupancyGridSensor:
+      *sim_response.mutable_attach_occupancy_grid_sensor() =
+        std::get<AttachOccupancyGridSensor>(functions_)(
+          session, proto.attach_occupancy_grid_sensor());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kUpdateTrafficLights:
+      *sim_response.mutable_update_traffic_lights() =
+        std::get<UpdateTrafficLights>(functions_)(session, proto.update_traffic_lights());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kAttachPseudoTrafficLightDetector:
+      *sim_response.mutable_attach_pseudo_traffic_light_detector() =
+        std::get<AttachPseudoTrafficLightDetector>(functions_)(
+          session, proto.attach_pseudo_traffic_light_detector());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kUpdateStepTime:
+      *sim_response.mutable_update_step_time() =
+        std::get<UpdateStepTime>(functions_)(session, proto.update_step_time());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kFinalize:
+      *sim_response.mutable_finalize() =
+        std::get<Finalize>(functions_)(session, proto.finalize());
+      break;
+    case simulation_api_schema::SimulationRequest::RequestCase::kStep: {
+      const auto & step = proto.step();
+      auto & response = *sim_response.mutable_step();
+      *response.mutable_update_entity_status() =
+        std::get<UpdateEntityStatus>(functions_)(session, step.update_entity_status());
+      *response.mutable_result() = response.update_entity_status().result();
+      if (response.result().success() and step.has_update_traffic_lights()) {
+        *response.mutable_update_traffic_lights() =
+          std::get<UpdateTrafficLights>(functions_)(session, step.update_traffic_lights());
+        *response.mutable_result() = response.update_traffic_lights().result();
+      }
+      if (response.result().success()) {
+        *response.mutable_update_frame() =
+          std::get<UpdateFrame>(functions_)(session, step.update_frame());
+        *response.mutable_result() = response.update_frame().result();
+      }
+      break;
+    }
+    case simulation_api_schema::SimulationRequest::RequestCase::REQUEST_NOT_SET: {
+      THROW_SIMULATION_ERROR("No case defined for oneof in SimulationRequest message");
+    }
+  }
+}
+
+void MultiServer::poll(std::chrono::milliseconds timeout)
+{
+  poller_.poll(std::max<long>(timeout.count(), 0));
   if (poller_.has_input(socket_)) {
-    simulation_api_schema::SimulationResponse sim_response;
     zmqpp::message sim_request;
     socket_.receive(sim_request);
-    auto proto = toProto<simulation_api_schema::SimulationRequest>(sim_request);
-    switch (proto.request_case()) {
-      case simulation_api_schema::SimulationRequest::RequestCase::kInitialize:
-        *sim_response.mutable_initialize() = std::get<Initialize>(functions_)(proto.initialize());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kUpdateFrame:
-        *sim_response.mutable_update_frame() =
-          std::get<UpdateFrame>(functions_)(proto.update_frame());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kSpawnVehicleEntity:
-        *sim_response.mutable_spawn_vehicle_entity() =
-          std::get<SpawnVehicleEntity>(functions_)(proto.spawn_vehicle_entity());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kSpawnPedestrianEntity:
-        *sim_response.mutable_spawn_pedestrian_entity() =
-          std::get<SpawnPedestrianEntity>(functions_)(proto.spawn_pedestrian_entity());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kSpawnMiscObjectEntity:
-        *sim_response.mutable_spawn_misc_object_entity() =
-          std::get<SpawnMiscObjectEntity>(functions_)(proto.spawn_misc_object_entity());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kDespawnEntity:
-        *sim_response.mutable_despawn_entity() =
-          std::get<DespawnEntity>(functions_)(proto.despawn_entity());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kUpdateEntityStatus:
-        *sim_response.mutable_update_entity_status() =
-          std::get<UpdateEntityStatus>(functions_)(proto.update_entity_status());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kAttachImuSensor:
-        *sim_response.mutable_attach_imu_sensor() =
-          std::get<AttachImuSensor>(functions_)(proto.attach_imu_sensor());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kAttachLidarSensor:
-        *sim_response.mutable_attach_lidar_sensor() =
-          std::get<AttachLidarSensor>(functions_)(proto.attach_lidar_sensor());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kAttachDetectionSensor:
-        *sim_response.mutable_attach_detection_sensor() =
-          std::get<AttachDetectionSensor>(functions_)(proto.attach_detection_sensor());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kAttachOccupancyGridSensor:
-        *sim_response.mutable_attach_occupancy_grid_sensor() =
-          std::get<AttachOccupancyGridSensor>(functions_)(proto.attach_occupancy_grid_sensor());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kUpdateTrafficLights:
-        *sim_response.mutable_update_traffic_lights() =
-          std::get<UpdateTrafficLights>(functions_)(proto.update_traffic_lights());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kAttachPseudoTrafficLightDetector:
-        *sim_response.mutable_attach_pseudo_traffic_light_detector() =
-          std::get<AttachPseudoTrafficLightDetector>(functions_)(
-            proto.attach_pseudo_traffic_light_detector());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::kUpdateStepTime:
-        *sim_response.mutable_update_step_time() =
-          std::get<UpdateStepTime>(functions_)(proto.update_step_time());
-        break;
-      case simulation_api_schema::SimulationRequest::RequestCase::REQUEST_NOT_SET: {
-        THROW_SIMULATION_ERROR("No case defined for oneof in SimulationRequest message");
-      }
+    const auto payload = sim_request.parts() - 1;
+    socket_arena_.reset();
+    auto request = socket_arena_.create<simulation_api_schema::SimulationRequest>();
+    request->ParseFromArray(
+      sim_request.raw_data(payload), static_cast<int>(sim_request.size(payload)));
+    auto response = socket_arena_.create<simulation_api_schema::SimulationResponse>();
+    handle(*request, *response);
+    response->SerializeToString(&socket_buffer_);
+    /*
+       The frames before the request are its envelope: the identity of the
+       client, then the request ID from a DEALER client or the empty delimiter
+       from a REQ one. They are sent back as they are, ahead of the reply.
+
+       The reply is copied into the frame, because with several clients the
+       next request may arrive before this reply has left, and would overwrite
+       the buffer.
+    */
+    zmqpp::message msg;
+    for (std::size_t i = 0; i < payload; ++i) {
+      msg.add_raw(sim_request.raw_data(i), sim_request.size(i));
     }
-    auto msg = toZMQ(sim_response);
+    msg.add_raw(socket_buffer_.data(), socket_buffer_.size());
     socket_.send(msg);
   }
 }
 
 void MultiServer::start_poll()
 {
-  while (rclcpp::ok()) {
-    common::status_monitor.touch(__func__);
-    poll();
+  /*
+     The poller sleeps until a request or the stop event arrives, and wakes
+     up only to beat the heart of this thread, often enough for the watchdog
+     of the status monitor and too rarely to cost anything while idle.
+  */
+  constexpr auto heartbeat_interval = std::chrono::milliseconds(500);
+  auto next_heartbeat = std::chrono::steady_clock::now();
+  while (rclcpp::ok() and not stopping_.load(std::memory_order_acquire)) {
+    const auto now = std::chrono::steady_clock::now();
+    if (next_heartbeat <= now) {
+      common::status_monitor.touch(__func__);
+      next_heartbeat = now + heartbeat_interval;
+    }
+    // rounded up, or the poller would spin through the last fraction of a millisecond
+    poll(std::chrono::duration_cast<std::chrono::milliseconds>(
+      next_heartbeat - now + std::chrono::milliseconds(1) - std::chrono::nanoseconds(1)));
+  }
+}
+
+void MultiServer::serveSharedMemory()
+{
+  simulation_interface::MessageArena arena;
+  std::string buffer;
+  while (rclcpp::ok() and not stopping_.load(std::memory_order_acquire)) {
+    try {
+      if (shared_memory_channel_->receive(buffer, std::chrono::milliseconds(100))) {
+        arena.reset();
+        auto request = arena.create<simulation_api_schema::SimulationRequest>();
+        request->ParseFromString(buffer);
+        auto response = arena.create<simulation_api_schema::SimulationResponse>();
+        handle(*request, *response);
+        response->SerializeToString(&buffer);
+        shared_memory_channel_->send(buffer);
+      }
+    } catch (const simulation_interface::SharedMemoryChannel::Interrupted &) {
+      /*
+         The client went away in the middle of a message, whose rest is
+         dropped. The next client finds the rings emptied.
+      */
+    }
   }
 }
 }  // namespace zeromq
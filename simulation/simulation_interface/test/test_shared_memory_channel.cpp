@@ -0,0 +1,139 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <simulation_interface/shared_memory_channel.hpp>
+#include <string>
+#include <thread>
+
+using simulation_interface::SharedMemoryChannel;
+
+constexpr unsigned int port = 45678;
+
+/**
+ * @note Test that a client can attach only while the server channel exists and no other client
+ * holds it.
+ */
+TEST(SharedMemoryChannel, open)
+{
+  EXPECT_EQ(SharedMemoryChannel::open(port), nullptr);
+  auto server = SharedMemoryChannel::create(port);
+  ASSERT_NE(server, nullptr);
+  auto client = SharedMemoryChannel::open(port);
+  EXPECT_NE(client, nullptr);
+  EXPECT_EQ(SharedMemoryChannel::open(port), nullptr);
+  client.reset();
+  EXPECT_NE(SharedMemoryChannel::open(port), nullptr);
+  server.reset();
+  EXPECT_EQ(SharedMemoryChannel::open(port), nullptr);
+}
+
+/**
+ * @note Test round trips of empty messages and of messages larger than the ring.
+ */
+TEST(SharedMemoryChannel, roundTrip)
+{
+  auto server = SharedMemoryChannel::create(port, 256);
+  auto client = SharedMemoryChannel::open(port);
+  ASSERT_NE(client, nullptr);
+
+  auto echo = std::thread([&]() {
+    std::string message;
+    for (int i = 0; i < 3; ++i) {
+      while (not server->receive(message, std::chrono::milliseconds(100))) {
+      }
+      server->send(message + "!");
+    }
+  });
+
+  std::string large(10000, ' ');
+  for (std::size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<char>(i * 7);
+  }
+
+  std::string response;
+  for (const auto & request : {std::string(""), large, std::string("request")}) {
+    client->send(request);
+    while (not client->receive(response, std::chrono::milliseconds(100))) {
+    }
+    EXPECT_EQ(response, request + "!");
+  }
+
+  echo.join();
+  EXPECT_FALSE(client->receive(response, std::chrono::milliseconds(1)));
+}
+
+/**
+ * @note Test that a new client reads nothing left in the rings by the previous one, which sent a
+ * request and detached without reading its response.
+ */
+TEST(SharedMemoryChannel, newClient)
+{
+  auto server = SharedMemoryChannel::create(port, 256);
+  auto client = SharedMemoryChannel::open(port);
+  ASSERT_NE(client, nullptr);
+
+  std::string message;
+  auto echo = [&]() {
+    while (not server->receive(message, std::chrono::milliseconds(100))) {
+    }
+    server->send(message + "!");
+  };
+
+  auto first = std::thread(echo);
+  client->send("first");
+  first.join();
+  client.reset();
+
+  client = SharedMemoryChannel::open(port);
+  ASSERT_NE(client, nullptr);
+  auto second = std::thread(echo);
+  client->send("second");
+  second.join();
+
+  std::string response;
+  ASSERT_TRUE(client->receive(response, std::chrono::milliseconds(100)));
+  EXPECT_EQ(response, "second!");
+  EXPECT_FALSE(client->receive(response, std::chrono::milliseconds(1)));
+}
+
+/**
+ * @note Test that stopping the channel unblocks a write waiting for the peer to read.
+ */
+TEST(SharedMemoryChannel, stop)
+{
+  auto server = SharedMemoryChannel::create(port, 64);
+  auto client = SharedMemoryChannel::open(port);
+  ASSERT_NE(client, nullptr);
+  // accepts the client, whose attaching would otherwise interrupt the server as well
+  std::string message;
+  EXPECT_FALSE(server->receive(message, std::chrono::milliseconds(1)));
+
+  auto writer = std::thread([&]() {
+    EXPECT_THROW(server->send(std::string(1000, ' ')), SharedMemoryChannel::Interrupted);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  server->stop();
+  writer.join();
+
+  EXPECT_FALSE(server->receive(message, std::chrono::milliseconds(1)));
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -21,6 +21,7 @@
 #include <autoware_auto_vehicle_msgs/msg/vehicle_state_command.hpp>
 #include <boost/variant.hpp>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <rclcpp/rclcpp.hpp>
@@ -42,6 +43,7 @@
 #include <traffic_simulator/traffic/traffic_controller.hpp>
 #include <traffic_simulator/traffic_lights/traffic_light.hpp>
 #include <traffic_simulator_msgs/msg/behavior_parameter.hpp>
+#include <unordered_map>
 #include <utility>
 
 namespace traffic_simulator
@@ -100,7 +102,8 @@ public:
       })),
     clock_(node->get_parameter("use_sim_time").as_bool(), std::forward<decltype(xs)>(xs)...),
     zeromq_client_(
-      simulation_interface::protocol, configuration.simulator_host, getZMQSocketPort(*node))
+      simulation_interface::protocol, configuration.simulator_host, getZMQSocketPort(*node),
+      getSimulatorSession(*node))
   {
     setVerbose(configuration.verbose);
 
@@ -108,11 +111,15 @@ public:
       simulation_api_schema::InitializeRequest request;
       request.set_initialize_time(clock_.getCurrentSimulationTime());
       request.set_lanelet2_map_path(configuration.lanelet2_map_path().string());
+      request.set_pointcloud_map_path(configuration.pointcloud_map_path().string());
       request.set_realtime_factor(clock_.realtime_factor);
       request.set_step_time(clock_.getStepTime());
       simulation_interface::toProto(
         clock_.getCurrentRosTime(), *request.mutable_initialize_ros_time());
-      if (not zeromq_client_.call(request).result().success()) {
+      if (const auto & response = zeromq_client_.call(request); response.result().success()) {
+        supports_step_ = response.supports_step();
+        supports_finalize_ = response.supports_finalize();
+      } else {
         throw common::SimulationError("Failed to initialize simulator by InitializeRequest");
       }
     }
@@ -131,7 +138,28 @@ public:
     return node.get_parameter("port").as_int();
   }
 
-  void closeZMQConnection() { zeromq_client_.closeConnection(); }
+  /**
+   * @brief Session of the simulator to run the scenario in, so that several scenarios can share
+   * one simulator process
+   */
+  template <typename Node>
+  std::uint32_t getSimulatorSession(Node & node)
+  {
+    if (!node.has_parameter("session")) node.declare_parameter("session", 0);
+    return node.get_parameter("session").as_int();
+  }
+
+  /**
+   * @note The session of the simulator is finalized first, so that a simulator hosting many
+   * scenarios one after another frees what it holds for this one.
+   */
+  void closeZMQConnection()
+  {
+    if (supports_finalize_) {
+      zeromq_client_.call(simulation_api_schema::FinalizeRequest());
+    }
+    zeromq_client_.closeConnection();
+  }
 
   void setVerbose(const bool verbose);
 
@@ -165,10 +193,11 @@ public:
         req.mutable_parameters()->set_name(name);
         req.set_asset_key(model3d);
         simulation_interface::toProto(entity->getMapPose(), *req.mutable_pose());
+        simulation_interface::toProto(entity->getEntitySubtype(), *req.mutable_subtype());
         req.set_is_ego(behavior == VehicleBehavior::autoware());
         /// @todo Should be filled from function API
         req.set_initial_speed(0.0);
-        return zeromq_client_.call(req).result().success();
+        return registerToSimulator(name, zeromq_client_.call(req));
       }
     };
 
@@ -199,7 +228,8 @@ public:
         req.mutable_parameters()->set_name(name);
         req.set_asset_key(model3d);
         simulation_interface::toProto(entity->getMapPose(), *req.mutable_pose());
-        return zeromq_client_.call(req).result().success();
+        simulation_interface::toProto(entity->getEntitySubtype(), *req.mutable_subtype());
+        return registerToSimulator(name, zeromq_client_.call(req));
       }
     };
 
@@ -229,7 +259,8 @@ public:
         req.mutable_parameters()->set_name(name);
         req.set_asset_key(model3d);
         simulation_interface::toProto(entity->getMapPose(), *req.mutable_pose());
-        return zeromq_client_.call(req).result().success();
+        simulation_interface::toProto(entity->getEntitySubtype(), *req.mutable_subtype());
+        return registerToSimulator(name, zeromq_client_.call(req));
       }
     };
 
@@ -239,6 +270,13 @@ public:
   bool despawn(const std::string & name);
   bool despawnEntities();
 
+  /**
+   * @note The entity is respawned by the entity manager, so its handle there changes, while the
+   * simulator still knows it by the same handle.
+   */
+  auto resetBehaviorPlugin(const std::string & name, const std::string & behavior_plugin_name)
+    -> void;
+
   auto setEntityStatus(const std::string & name, const EntityStatus & status) -> void;
   auto respawn(
     const std::string & name, const geometry_msgs::msg::PoseWithCovarianceStamped & new_pose,
@@ -387,7 +425,6 @@ public:
   FORWARD_TO_ENTITY_MANAGER(requestSynchronize);
   FORWARD_TO_ENTITY_MANAGER(requestWalkStraight);
   FORWARD_TO_ENTITY_MANAGER(requestClearRoute);
-  FORWARD_TO_ENTITY_MANAGER(resetBehaviorPlugin);
   FORWARD_TO_ENTITY_MANAGER(resetConventionalTrafficLightPublishRate);
   FORWARD_TO_ENTITY_MANAGER(resetV2ITrafficLightPublishRate);
   FORWARD_TO_ENTITY_MANAGER(setAcceleration);
@@ -415,6 +452,25 @@ private:
 
   bool updateTrafficLightsInSim();
 
+  bool stepInSim();
+
+  template <typename SpawnResponse>
+  auto registerToSimulator(const std::string & name, const SpawnResponse & response) -> bool
+  {
+    if (response.result().success() and response.handle() != 0) {
+      if (const auto handle = entity_manager_ptr_->getEntityHandle(name)) {
+        simulator_entities_[*handle] = SimulatorEntity{response.handle()};
+      }
+    }
+    return response.result().success();
+  }
+
+  void fillUpdateEntityStatusRequest(simulation_api_schema::UpdateEntityStatusRequest &);
+
+  void applyUpdateEntityStatusResponse(const simulation_api_schema::UpdateEntityStatusResponse &);
+
+  void fillUpdateFrameRequest(simulation_api_schema::UpdateFrameRequest &);
+
   const Configuration configuration;
 
   const rclcpp::node_interfaces::NodeParametersInterface::SharedPtr node_parameters_;
@@ -432,6 +488,40 @@ private:
   SimulationClock clock_;
 
   zeromq::MultiClient zeromq_client_;
+
+  // cleared and refilled every frame, so that their fields keep their allocations
+  simulation_api_schema::UpdateEntityStatusRequest update_entity_status_request_;
+
+  simulation_api_schema::UpdateFrameRequest update_frame_request_;
+
+  simulation_api_schema::StepRequest step_request_;
+
+  // whether the simulator takes the requests of a frame in one StepRequest
+  bool supports_step_ = false;
+
+  // whether the simulator ends the session of the scenario on a FinalizeRequest
+  bool supports_finalize_ = false;
+
+  /**
+   * @brief Entity as the simulator knows it
+   * @note The simulator keeps the static fields of the entity from its spawn request, so an
+   * update sends only the fields that have changed since the last one, keyed by the handle.
+   */
+  struct SimulatorEntity
+  {
+    std::uint32_t handle;
+
+    bool is_synchronized = false;
+
+    geometry_msgs::msg::Pose pose;
+
+    traffic_simulator_msgs::msg::ActionStatus action_status;
+  };
+
+  // entities spawned by a simulator that gave them a handle, by their handle in the entity manager
+  std::unordered_map<
+    entity::EntityRegistry::Handle, SimulatorEntity, entity::EntityRegistry::Handle::Hash>
+    simulator_entities_;
 };
 }  // namespace traffic_simulator
 
@@ -0,0 +1,197 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAFFIC_SIMULATOR__DATA_TYPE__ENTITY_STATUS_SNAPSHOT_HPP_
+#define TRAFFIC_SIMULATOR__DATA_TYPE__ENTITY_STATUS_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <geometry_msgs/msg/pose.hpp>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <traffic_simulator/data_type/entity_status.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace traffic_simulator
+{
+/**
+ * @brief Statuses of every entity at one point of a frame, which are never changed once taken
+ * @note The statuses are stored contiguously, and the handle of an entity is the index of its
+ * status. The version tells snapshots apart, and grows with each snapshot taken. The map pose and
+ * the lanelet of every entity, which the behaviors of every other entity scan in each frame, are
+ * also stored as one array per field, so that such a scan does not read the whole statuses.
+ */
+class EntityStatusSnapshot
+{
+public:
+  using value_type = std::pair<std::string, CanonicalizedEntityStatus>;
+
+  using Handle = std::size_t;
+
+  EntityStatusSnapshot() = default;
+
+  explicit EntityStatusSnapshot(std::uint64_t version, std::vector<value_type> && statuses);
+
+  auto version() const noexcept -> std::uint64_t { return version_; }
+
+  auto size() const noexcept -> std::size_t { return statuses_.size(); }
+
+  auto getHandle(const std::string & name) const -> std::optional<Handle>;
+
+  auto operator[](Handle handle) const -> const value_type & { return statuses_[handle]; }
+
+  auto getMapPose(Handle handle) const -> const geometry_msgs::msg::Pose &
+  {
+    return map_poses_[handle];
+  }
+
+  // std::nullopt if the entity is not matched to any lanelet
+  auto getLaneletId(Handle handle) const -> const std::optional<lanelet::Id> &
+  {
+    return lanelet_ids_[handle];
+  }
+
+  auto begin() const noexcept { return statuses_.begin(); }
+
+  auto end() const noexcept { return statuses_.end(); }
+
+private:
+  std::uint64_t version_ = 0;
+
+  std::vector<value_type> statuses_;
+
+  std::vector<geometry_msgs::msg::Pose> map_poses_;
+
+  std::vector<std::optional<lanelet::Id>> lanelet_ids_;
+
+  std::unordered_map<std::string, Handle> handles_;
+};
+
+/**
+ * @brief Statuses of every entity of a snapshot but one, as seen by that one entity
+ * @note Copying a view copies no status, so every entity and behavior node can hold its own. It
+ * is iterated and searched like the map of names to statuses it replaces.
+ */
+class OtherEntityStatusView
+{
+public:
+  using value_type = EntityStatusSnapshot::value_type;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EntityStatusSnapshot::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    explicit const_iterator(pointer position, pointer excluded)
+    : position_(position == excluded ? position + 1 : position), excluded_(excluded)
+    {
+    }
+
+    auto operator*() const -> reference { return *position_; }
+
+    auto operator->() const -> pointer { return position_; }
+
+    auto operator++() -> const_iterator &
+    {
+      if (++position_ == excluded_) {
+        ++position_;
+      }
+      return *this;
+    }
+
+    auto operator++(int) -> const_iterator
+    {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    auto operator==(const const_iterator & other) const { return position_ == other.position_; }
+
+    auto operator!=(const const_iterator & other) const { return position_ != other.position_; }
+
+  private:
+    pointer position_ = nullptr;
+
+    pointer excluded_ = nullptr;
+  };
+
+  using iterator = const_iterator;
+
+  OtherEntityStatusView() = default;
+
+  explicit OtherEntityStatusView(
+    const std::shared_ptr<const EntityStatusSnapshot> & snapshot, const std::string & name);
+
+  auto version() const noexcept -> std::uint64_t { return snapshot_ ? snapshot_->version() : 0; }
+
+  auto size() const noexcept -> std::size_t;
+
+  auto empty() const noexcept -> bool { return size() == 0; }
+
+  auto begin() const noexcept -> const_iterator;
+
+  auto end() const noexcept -> const_iterator;
+
+  auto find(const std::string & name) const -> const_iterator;
+
+  auto count(const std::string & name) const -> std::size_t { return find(name) != end(); }
+
+  /**
+   * @throw std::out_of_range if the entity is not in the view
+   */
+  auto at(const std::string & name) const -> const CanonicalizedEntityStatus &;
+
+  /**
+   * @brief Map pose of the entity an iterator of this view points to, read from its array in the
+   * snapshot
+   */
+  auto getMapPose(const const_iterator & iter) const -> const geometry_msgs::msg::Pose &
+  {
+    return snapshot_->getMapPose(getHandle(iter));
+  }
+
+  /**
+   * @brief Lanelet of the entity an iterator of this view points to, read from its array in the
+   * snapshot
+   * @return std::nullopt if the entity is not matched to any lanelet
+   */
+  auto getLaneletId(const const_iterator & iter) const -> const std::optional<lanelet::Id> &
+  {
+    return snapshot_->getLaneletId(getHandle(iter));
+  }
+
+private:
+  auto getHandle(const const_iterator & iter) const -> EntityStatusSnapshot::Handle
+  {
+    return static_cast<EntityStatusSnapshot::Handle>(&*iter - &(*snapshot_)[0]);
+  }
+
+  std::shared_ptr<const EntityStatusSnapshot> snapshot_;
+
+  std::optional<EntityStatusSnapshot::Handle> excluded_;
+};
+}  // namespace traffic_simulator
+
+#endif  // TRAFFIC_SIMULATOR__DATA_TYPE__ENTITY_STATUS_SNAPSHOT_HPP_
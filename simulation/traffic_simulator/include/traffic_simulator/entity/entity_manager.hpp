@@ -20,6 +20,7 @@
 #include <tf2_ros/transform_broadcaster.h>
 
 #include <autoware_perception_msgs/msg/traffic_signal_array.hpp>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <rclcpp/node_interfaces/get_node_topics_interface.hpp>
@@ -30,10 +31,12 @@
 #include <string>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #include <traffic_simulator/api/configuration.hpp>
+#include <traffic_simulator/data_type/entity_status_snapshot.hpp>
 #include <traffic_simulator/data_type/lane_change.hpp>
 #include <traffic_simulator/data_type/speed_change.hpp>
 #include <traffic_simulator/entity/ego_entity.hpp>
 #include <traffic_simulator/entity/entity_base.hpp>
+#include <traffic_simulator/entity/entity_registry.hpp>
 #include <traffic_simulator/entity/misc_object_entity.hpp>
 #include <traffic_simulator/entity/pedestrian_entity.hpp>
 #include <traffic_simulator/entity/vehicle_entity.hpp>
@@ -44,6 +47,7 @@
 #include <traffic_simulator/traffic_lights/traffic_light_publisher.hpp>
 #include <traffic_simulator/utils/node_parameters.hpp>
 #include <traffic_simulator/utils/pose.hpp>
+#include <traffic_simulator/utils/thread_pool.hpp>
 #include <traffic_simulator_msgs/msg/behavior_parameter.hpp>
 #include <traffic_simulator_msgs/msg/bounding_box.hpp>
 #include <traffic_simulator_msgs/msg/entity_status_with_trajectory_array.hpp>
@@ -83,10 +87,28 @@ class EntityManager
 
   const rclcpp::Clock::SharedPtr clock_ptr_;
 
-  std::unordered_map<std::string, std::shared_ptr<traffic_simulator::entity::EntityBase>> entities_;
+  EntityRegistry entities_;
 
   bool npc_logic_started_;
 
+  // updates the entities other than egos in parallel if the node parameter
+  // `parallel_entity_update` is true, and is null otherwise
+  const std::unique_ptr<ThreadPool> entity_update_thread_pool_;
+
+  /**
+   * @brief Update every entity, the entities other than egos being updated on the thread pool
+   * @note Every entity is updated even if another one throws. Then the exception thrown by the
+   * first entity in the iteration order of `entities_` is rethrown, as when updating entities one
+   * by one.
+   */
+  auto updateEntitiesInParallel(const double current_time, const double step_time) -> void;
+
+  // of the latest snapshot of the statuses of every entity, which every entity sees through a view
+  std::uint64_t entity_status_snapshot_version_ = 0;
+
+  auto takeEntityStatusSnapshot(std::vector<EntityStatusSnapshot::value_type> &&)
+    -> std::shared_ptr<const EntityStatusSnapshot>;
+
   using EntityStatusWithTrajectoryArray =
     traffic_simulator_msgs::msg::EntityStatusWithTrajectoryArray;
   const rclcpp::Publisher<EntityStatusWithTrajectoryArray>::SharedPtr entity_status_array_pub_ptr_;
@@ -155,6 +177,10 @@ public:
     base_link_broadcaster_(node),
     clock_ptr_(node->get_clock()),
     npc_logic_started_(false),
+    entity_update_thread_pool_(
+      getParameter<bool>(node_parameters_, "parallel_entity_update", false)
+        ? std::make_unique<ThreadPool>()
+        : nullptr),
     entity_status_array_pub_ptr_(rclcpp::create_publisher<EntityStatusWithTrajectoryArray>(
       node, "entity/status", EntityMarkerQoS(),
       rclcpp::PublisherOptionsWithAllocator<AllocatorT>())),
@@ -309,6 +335,10 @@ public:
   auto updateNpcLogic(const std::string & name, const double current_time, const double step_time)
     -> const CanonicalizedEntityStatus &;
 
+  auto updateNpcLogic(
+    const std::shared_ptr<EntityBase> & entity, const double current_time, const double step_time)
+    -> const CanonicalizedEntityStatus &;
+
   void broadcastEntityTransform();
 
   void broadcastTransform(
@@ -323,9 +353,34 @@ public:
 
   auto getEntityNames() const -> const std::vector<std::string>;
 
+  /**
+   * @brief Every entity in the order they are updated
+   * @note Iterating the entities this way looks no name up, unlike calling the functions taking
+   * the name of an entity for each name of `getEntityNames`.
+   */
+  auto getEntities() const noexcept -> const EntityRegistry & { return entities_; }
+
   auto getEntity(const std::string & name) const
     -> std::shared_ptr<traffic_simulator::entity::EntityBase>;
 
+  /**
+   * @brief Handle of the entity, by which it is then reached without looking its name up again
+   * @return std::nullopt if no entity has the name
+   */
+  auto getEntityHandle(const std::string & name) const -> std::optional<EntityRegistry::Handle>
+  {
+    return entities_.getHandle(name);
+  }
+
+  /**
+   * @return nullptr if the entity of the handle has been despawned
+   */
+  auto getEntity(const EntityRegistry::Handle & handle) const
+    -> std::shared_ptr<traffic_simulator::entity::EntityBase>
+  {
+    return entities_.get(handle);
+  }
+
   auto getEntityStatus(const std::string & name) const -> const CanonicalizedEntityStatus &;
 
   auto getHdmapUtils() -> const std::shared_ptr<hdmap_utils::HdMapUtils> &;
@@ -0,0 +1,138 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAFFIC_SIMULATOR__ENTITY__ENTITY_REGISTRY_HPP_
+#define TRAFFIC_SIMULATOR__ENTITY__ENTITY_REGISTRY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <traffic_simulator/entity/entity_base.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace traffic_simulator
+{
+namespace entity
+{
+/**
+ * @brief Every spawned entity, stored contiguously, and reached by name or by handle
+ * @note A handle is a slot and the generation of that slot. Despawning an entity frees its slot
+ * for the next entity spawned and bumps the generation of the slot, so a handle stays valid
+ * exactly as long as its entity exists, and a stale handle reaches no entity. The entities are
+ * iterated in a dense array, into which despawning an entity moves the last one. A name is
+ * hashed once to the index of its entity in that array, and a handle reaches it through its
+ * slot without hashing anything.
+ */
+class EntityRegistry
+{
+public:
+  using value_type = std::pair<std::string, std::shared_ptr<EntityBase>>;
+
+  struct Handle
+  {
+    std::uint32_t slot;
+
+    std::uint32_t generation;
+
+    auto operator==(const Handle & other) const noexcept
+    {
+      return slot == other.slot and generation == other.generation;
+    }
+
+    auto operator!=(const Handle & other) const noexcept { return not(*this == other); }
+
+    struct Hash
+    {
+      auto operator()(const Handle & handle) const noexcept -> std::size_t
+      {
+        return std::hash<std::uint64_t>()(
+          static_cast<std::uint64_t>(handle.slot) << 32 | handle.generation);
+      }
+    };
+  };
+
+  using iterator = std::vector<value_type>::iterator;
+
+  using const_iterator = std::vector<value_type>::const_iterator;
+
+  auto size() const noexcept -> std::size_t { return entities_.size(); }
+
+  auto empty() const noexcept -> bool { return entities_.empty(); }
+
+  auto begin() noexcept -> iterator { return entities_.begin(); }
+
+  auto begin() const noexcept -> const_iterator { return entities_.begin(); }
+
+  auto end() noexcept -> iterator { return entities_.end(); }
+
+  auto end() const noexcept -> const_iterator { return entities_.end(); }
+
+  auto getHandle(const std::string & name) const -> std::optional<Handle>;
+
+  /**
+   * @brief Handle of the entity an iterator of this registry points to, found without hashing
+   */
+  auto getHandle(const_iterator iter) const noexcept -> Handle;
+
+  /**
+   * @return the entity of the handle, or nullptr if it has been despawned
+   */
+  auto get(const Handle & handle) const noexcept -> const std::shared_ptr<EntityBase> &;
+
+  auto find(const std::string & name) const -> const_iterator;
+
+  /**
+   * @throw std::out_of_range if no entity has the name
+   */
+  auto at(const std::string & name) const -> const std::shared_ptr<EntityBase> &;
+
+  /**
+   * @return the entity of the name and false if there already is one, or the entity given and
+   * true otherwise
+   */
+  auto emplace(const std::string & name, std::shared_ptr<EntityBase> entity)
+    -> std::pair<const_iterator, bool>;
+
+  auto erase(const std::string & name) -> std::size_t;
+
+private:
+  struct Slot
+  {
+    std::uint32_t generation = 0;
+
+    // index of the entity in entities_, if the slot is used
+    std::optional<std::size_t> index;
+  };
+
+  std::vector<value_type> entities_;
+
+  // slot of each element of entities_
+  std::vector<std::uint32_t> entity_slots_;
+
+  std::vector<Slot> slots_;
+
+  std::vector<std::uint32_t> free_slots_;
+
+  // index in entities_ of the entity of each name
+  std::unordered_map<std::string, std::size_t> indices_;
+};
+}  // namespace entity
+}  // namespace traffic_simulator
+
+#endif  // TRAFFIC_SIMULATOR__ENTITY__ENTITY_REGISTRY_HPP_
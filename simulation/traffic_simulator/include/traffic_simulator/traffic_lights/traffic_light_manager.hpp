@@ -17,6 +17,7 @@
 
 #include <iomanip>
 #include <memory>
+#include <mutex>
 #include <rclcpp/rclcpp.hpp>
 #include <simulation_interface/conversions.hpp>
 #include <stdexcept>  // std::out_of_range
@@ -37,6 +38,9 @@ protected:
 
   TrafficLightMap traffic_lights_;
 
+  // guards the traffic lights added by getTrafficLight, which entities updated in parallel call
+  std::mutex traffic_lights_mutex_;
+
   const std::shared_ptr<hdmap_utils::HdMapUtils> hdmap_;
 
 public:
@@ -0,0 +1,141 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAFFIC_SIMULATOR__UTILS__THREAD_POOL_HPP_
+#define TRAFFIC_SIMULATOR__UTILS__THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace traffic_simulator
+{
+/**
+ * @brief Long-lived pool of worker threads, so that no thread is created while a frame is being
+ * simulated.
+ */
+class ThreadPool
+{
+public:
+  explicit ThreadPool(std::size_t thread_count = defaultThreadCount());
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  static auto defaultThreadCount() -> std::size_t;
+
+  auto size() const noexcept -> std::size_t { return workers_.size(); }
+
+  template <typename F>
+  auto submit(F && f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+  {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    push([task]() { (*task)(); });
+    return future;
+  }
+
+  /**
+   * @brief Call `f(i)` for every `i` in [0, size) and wait for all of them to finish.
+   * @note Indices are handed out one at a time through an atomic counter, so threads that finish
+   * early keep taking the remaining work of the slower ones. The calling thread takes part as
+   * well, which keeps nested calls from inside a task free of deadlocks.
+   */
+  template <typename F>
+  auto parallelFor(const std::size_t size, F && f) -> void
+  {
+    if (size == 0) {
+      return;
+    }
+
+    struct State
+    {
+      explicit State(std::size_t size) : size(size) {}
+      const std::size_t size;
+      std::atomic<std::size_t> next{0};
+      std::atomic<std::size_t> done{0};
+      std::mutex mutex;
+      std::condition_variable finished;
+      std::exception_ptr exception;
+    };
+
+    auto state = std::make_shared<State>(size);
+
+    /*
+       Helpers may still be queued when every index has been processed. They only dereference `f`
+       after taking an index below `size`, so the reference never outlives this call.
+    */
+    auto run = [state, &f]() {
+      for (auto i = state->next++; i < state->size; i = state->next++) {
+        try {
+          f(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          if (not state->exception) {
+            state->exception = std::current_exception();
+          }
+        }
+        if (++state->done == state->size) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->finished.notify_all();
+        }
+      }
+    };
+
+    for (std::size_t i = 0; i < std::min(size - 1, workers_.size()); ++i) {
+      push(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->size; });
+    if (state->exception) {
+      std::rethrow_exception(state->exception);
+    }
+  }
+
+private:
+  auto push(std::function<void()> task) -> void;
+
+  auto work() -> void;
+
+  std::vector<std::thread> workers_;
+
+  std::deque<std::function<void()>> tasks_;
+
+  std::mutex mutex_;
+
+  std::condition_variable task_available_;
+
+  bool stopped_ = false;
+};
+}  // namespace traffic_simulator
+
+#endif  // TRAFFIC_SIMULATOR__UTILS__THREAD_POOL_HPP_
@@ -14,7 +14,9 @@
 
 #include <tf2/LinearMath/Quaternion.h>
 
+#include <future>
 #include <geometry/quaternion/euler_to_quaternion.hpp>
+#include <iomanip>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -25,6 +27,7 @@
 #include <traffic_simulator/api/api.hpp>
 #include <traffic_simulator/traffic/traffic_source.hpp>
 #include <traffic_simulator/utils/pose.hpp>
+#include <vector>
 
 namespace traffic_simulator
 {
@@ -32,11 +35,15 @@ void API::setVerbose(const bool verbose) { entity_manager_ptr_->setVerbose(verbo
 
 bool API::despawn(const std::string & name)
 {
+  const auto handle = entity_manager_ptr_->getEntityHandle(name);
   const auto result = entity_manager_ptr_->despawnEntity(name);
   if (!result) {
     return false;
   }
   if (not configuration.standalone_mode) {
+    if (handle) {
+      simulator_entities_.erase(*handle);
+    }
     simulation_api_schema::DespawnEntityRequest req;
     req.set_name(name);
     return zeromq_client_.call(req).result().success();
@@ -46,9 +53,31 @@ bool API::despawn(const std::string & name)
 
 bool API::despawnEntities()
 {
-  auto entities = getEntityNames();
-  return std::all_of(
-    entities.begin(), entities.end(), [&](const auto & entity) { return despawn(entity); });
+  /*
+     The simulator handles the requests in the order they are sent, so all of
+     them are sent before waiting for any response, which costs one round trip
+     instead of one for each entity.
+  */
+  std::vector<std::future<simulation_api_schema::DespawnEntityResponse>> responses;
+  auto result = true;
+  for (const auto & name : getEntityNames()) {
+    const auto handle = entity_manager_ptr_->getEntityHandle(name);
+    if (not entity_manager_ptr_->despawnEntity(name)) {
+      result = false;
+      break;
+    } else if (not configuration.standalone_mode) {
+      if (handle) {
+        simulator_entities_.erase(*handle);
+      }
+      simulation_api_schema::DespawnEntityRequest req;
+      req.set_name(name);
+      responses.push_back(zeromq_client_.callAsync(req));
+    }
+  }
+  for (auto & response : responses) {
+    result = response.get().result().success() and result;
+  }
+  return result;
 }
 
 auto API::respawn(
@@ -73,7 +102,7 @@ auto API::respawn(
     entity_manager_ptr_->setControlledBySimulator(name, false);
 
     // check response
-    if (const auto res = zeromq_client_.call(req); not res.result().success()) {
+    if (const auto & res = zeromq_client_.call(req); not res.result().success()) {
       throw common::SimulationError(
         "UpdateEntityStatus request failed for \"" + name + "\" entity during respawn.");
     } else if (const auto res_status = res.status().begin(); res.status().size() != 1) {
@@ -120,6 +149,21 @@ auto API::setEntityStatus(
   }
 }
 
+auto API::resetBehaviorPlugin(const std::string & name, const std::string & behavior_plugin_name)
+  -> void
+{
+  const auto handle = entity_manager_ptr_->getEntityHandle(name);
+  entity_manager_ptr_->resetBehaviorPlugin(name, behavior_plugin_name);
+  if (handle) {
+    if (auto node = simulator_entities_.extract(*handle)) {
+      if (const auto new_handle = entity_manager_ptr_->getEntityHandle(name)) {
+        node.key() = *new_handle;
+        simulator_entities_.insert(std::move(node));
+      }
+    }
+  }
+}
+
 auto API::setEntityStatus(const std::string & name, const EntityStatus & status) -> void
 {
   if (const auto entity = getEntity(name)) {
@@ -277,14 +321,18 @@ bool API::attachLidarSensor(
     lidar_sensor_delay));
 }
 
-bool API::updateTimeInSim()
+void API::fillUpdateFrameRequest(simulation_api_schema::UpdateFrameRequest & request)
 {
-  simulation_api_schema::UpdateFrameRequest request;
   request.set_current_simulation_time(clock_.getCurrentSimulationTime());
   request.set_current_scenario_time(getCurrentTime());
   simulation_interface::toProto(
     clock_.getCurrentRosTimeAsMsg().clock, *request.mutable_current_ros_time());
-  return zeromq_client_.call(request).result().success();
+}
+
+bool API::updateTimeInSim()
+{
+  fillUpdateFrameRequest(update_frame_request_);
+  return zeromq_client_.call(update_frame_request_).result().success();
 }
 
 bool API::updateTrafficLightsInSim()
@@ -297,36 +345,93 @@ bool API::updateTrafficLightsInSim()
   return simulation_api_schema::UpdateTrafficLightsResponse().result().success();
 }
 
-bool API::updateEntitiesStatusInSim()
+void API::fillUpdateEntityStatusRequest(simulation_api_schema::UpdateEntityStatusRequest & req)
 {
-  simulation_api_schema::UpdateEntityStatusRequest req;
+  req.Clear();
   req.set_npc_logic_started(entity_manager_ptr_->isNpcLogicStarted());
-  for (const auto & entity_name : entity_manager_ptr_->getEntityNames()) {
-    const auto entity_status =
-      static_cast<EntityStatus>(entity_manager_ptr_->getEntityStatus(entity_name));
-    simulation_interface::toProto(entity_status, *req.add_status());
-    if (entity_manager_ptr_->is<entity::EgoEntity>(entity_name)) {
-      req.set_overwrite_ego_status(entity_manager_ptr_->isControlledBySimulator(entity_name));
+  const auto & entities = entity_manager_ptr_->getEntities();
+  for (auto entity_iter = entities.begin(); entity_iter != entities.end(); ++entity_iter) {
+    const auto & entity_ptr = entity_iter->second;
+    const auto entity_status = static_cast<EntityStatus>(entity_ptr->getCanonicalizedStatus());
+    const auto is_ego = dynamic_cast<entity::EgoEntity const *>(entity_ptr.get()) != nullptr;
+    if (const auto iter = simulator_entities_.find(entities.getHandle(entity_iter));
+        iter == simulator_entities_.end()) {
+      simulation_interface::toProto(entity_status, *req.add_status());
+    } else {
+      auto & entity = iter->second;
+      // the ego is sent even if unchanged, because that is what steps its simulation
+      const auto pose_changed =
+        is_ego or not entity.is_synchronized or entity.pose != entity_status.pose;
+      const auto action_status_changed = is_ego or not entity.is_synchronized or
+                                         entity.action_status != entity_status.action_status;
+      if (pose_changed or action_status_changed) {
+        auto & delta = *req.add_delta();
+        delta.set_handle(entity.handle);
+        if (pose_changed) {
+          simulation_interface::toProto(entity_status.pose, *delta.mutable_pose());
+          entity.pose = entity_status.pose;
+        }
+        if (action_status_changed) {
+          simulation_interface::toProto(
+            entity_status.action_status, *delta.mutable_action_status());
+          entity.action_status = entity_status.action_status;
+        }
+        entity.is_synchronized = true;
+      }
+    }
+    if (is_ego) {
+      req.set_overwrite_ego_status(entity_ptr->isControlledBySimulator());
     }
   }
+}
 
-  simulation_api_schema::UpdateEntityStatusResponse res;
-  if (auto res = zeromq_client_.call(req); res.result().success()) {
-    for (const auto & res_status : res.status()) {
-      auto entity_name = res_status.name();
-      auto entity_status =
-        static_cast<EntityStatus>(entity_manager_ptr_->getEntityStatus(entity_name));
-      simulation_interface::toMsg(res_status.pose(), entity_status.pose);
-      simulation_interface::toMsg(res_status.action_status(), entity_status.action_status);
-
-      if (entity_manager_ptr_->is<entity::EgoEntity>(entity_name)) {
-        setMapPose(entity_name, entity_status.pose);
-        setTwist(entity_name, entity_status.action_status.twist);
-        setAcceleration(entity_name, entity_status.action_status.accel);
-      } else {
-        setEntityStatus(entity_name, entity_status);
-      }
+void API::applyUpdateEntityStatusResponse(
+  const simulation_api_schema::UpdateEntityStatusResponse & res)
+{
+  for (const auto & res_status : res.status()) {
+    // the name is looked up once, and the entity is then updated in place
+    const auto entity = getEntity(res_status.name());
+    if (not entity) {
+      THROW_SEMANTIC_ERROR("entity ", std::quoted(res_status.name()), " does not exist.");
+    }
+    auto entity_status = static_cast<EntityStatus>(entity->getCanonicalizedStatus());
+    simulation_interface::toMsg(res_status.pose(), entity_status.pose);
+    simulation_interface::toMsg(res_status.action_status(), entity_status.action_status);
+
+    if (dynamic_cast<entity::EgoEntity const *>(entity.get())) {
+      entity->setMapPose(entity_status.pose);
+      entity->setTwist(entity_status.action_status.twist);
+      entity->setAcceleration(entity_status.action_status.accel);
+    } else {
+      entity->setStatus(entity_status);
     }
+  }
+}
+
+bool API::updateEntitiesStatusInSim()
+{
+  fillUpdateEntityStatusRequest(update_entity_status_request_);
+  if (const auto & res = zeromq_client_.call(update_entity_status_request_);
+      res.result().success()) {
+    applyUpdateEntityStatusResponse(res);
+    return true;
+  }
+  return false;
+}
+
+bool API::stepInSim()
+{
+  auto & request = step_request_;
+  fillUpdateEntityStatusRequest(*request.mutable_update_entity_status());
+  if (entity_manager_ptr_->trafficLightsChanged()) {
+    *request.mutable_update_traffic_lights() =
+      entity_manager_ptr_->generateUpdateRequestForConventionalTrafficLights();
+  } else {
+    request.clear_update_traffic_lights();
+  }
+  fillUpdateFrameRequest(*request.mutable_update_frame());
+  if (const auto & response = zeromq_client_.call(request); response.result().success()) {
+    applyUpdateEntityStatusResponse(response.update_entity_status());
     return true;
   }
   return false;
@@ -338,14 +443,25 @@ bool API::updateFrame()
     THROW_SEMANTIC_ERROR("Ego simulation is no longer supported in standalone mode");
   }
 
-  if (!updateEntitiesStatusInSim()) {
+  if (supports_step_) {
+    /*
+       The simulator only renders the statuses it was sent, and neither the
+       entity manager nor the traffic controller sends it anything, so all
+       three requests of this frame can go in one round trip up front. The
+       only difference is that entities spawned or despawned by the traffic
+       controller reach the sensors one frame later.
+    */
+    if (!stepInSim()) {
+      return false;
+    }
+  } else if (!updateEntitiesStatusInSim()) {
     return false;
   }
 
   entity_manager_ptr_->update(getCurrentTime(), clock_.getStepTime());
   traffic_controller_ptr_->execute(getCurrentTime(), clock_.getStepTime());
 
-  if (not configuration.standalone_mode) {
+  if (not configuration.standalone_mode and not supports_step_) {
     if (!updateTrafficLightsInSim() || !updateTimeInSim()) {
       return false;
     }
@@ -0,0 +1,98 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+#include <traffic_simulator/data_type/entity_status_snapshot.hpp>
+
+namespace traffic_simulator
+{
+EntityStatusSnapshot::EntityStatusSnapshot(
+  std::uint64_t version, std::vector<value_type> && statuses)
+: version_(version), statuses_(std::move(statuses))
+{
+  handles_.reserve(statuses_.size());
+  map_poses_.reserve(statuses_.size());
+  lanelet_ids_.reserve(statuses_.size());
+  for (Handle handle = 0; handle < statuses_.size(); ++handle) {
+    const auto & [name, status] = statuses_[handle];
+    handles_.emplace(name, handle);
+    map_poses_.push_back(status.getMapPose());
+    if (status.laneMatchingSucceed()) {
+      lanelet_ids_.emplace_back(status.getLaneletId());
+    } else {
+      lanelet_ids_.emplace_back(std::nullopt);
+    }
+  }
+}
+
+auto EntityStatusSnapshot::getHandle(const std::string & name) const -> std::optional<Handle>
+{
+  if (const auto iter = handles_.find(name); iter != handles_.end()) {
+    return iter->second;
+  } else {
+    return std::nullopt;
+  }
+}
+
+OtherEntityStatusView::OtherEntityStatusView(
+  const std::shared_ptr<const EntityStatusSnapshot> & snapshot, const std::string & name)
+: snapshot_(snapshot), excluded_(snapshot ? snapshot->getHandle(name) : std::nullopt)
+{
+}
+
+auto OtherEntityStatusView::size() const noexcept -> std::size_t
+{
+  return snapshot_ ? snapshot_->size() - (excluded_ ? 1 : 0) : 0;
+}
+
+auto OtherEntityStatusView::begin() const noexcept -> const_iterator
+{
+  if (snapshot_ and snapshot_->size() != 0) {
+    const auto data = &(*snapshot_)[0];
+    return const_iterator(data, excluded_ ? data + *excluded_ : nullptr);
+  } else {
+    return const_iterator();
+  }
+}
+
+auto OtherEntityStatusView::end() const noexcept -> const_iterator
+{
+  if (snapshot_ and snapshot_->size() != 0) {
+    const auto data = &(*snapshot_)[0];
+    return const_iterator(data + snapshot_->size(), nullptr);
+  } else {
+    return const_iterator();
+  }
+}
+
+auto OtherEntityStatusView::find(const std::string & name) const -> const_iterator
+{
+  if (snapshot_) {
+    if (const auto handle = snapshot_->getHandle(name); handle and handle != excluded_) {
+      const auto data = &(*snapshot_)[0];
+      return const_iterator(data + *handle, excluded_ ? data + *excluded_ : nullptr);
+    }
+  }
+  return end();
+}
+
+auto OtherEntityStatusView::at(const std::string & name) const -> const CanonicalizedEntityStatus &
+{
+  if (const auto iter = find(name); iter != end()) {
+    return iter->second;
+  } else {
+    throw std::out_of_range("OtherEntityStatusView::at: no entity named " + name);
+  }
+}
+}  // namespace traffic_simulator
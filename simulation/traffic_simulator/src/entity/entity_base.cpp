@@ -514,11 +514,9 @@ void EntityBase::setDynamicConstraints(
   setBehaviorParameter(behavior_parameter);
 }
 
-void EntityBase::setOtherStatus(
-  const std::unordered_map<std::string, CanonicalizedEntityStatus> & status)
+void EntityBase::setOtherStatus(const std::shared_ptr<const EntityStatusSnapshot> & snapshot)
 {
-  other_status_ = status;
-  other_status_.erase(name);
+  other_status_ = OtherEntityStatusView(snapshot, name);
 }
 
 auto EntityBase::setStatus(const EntityStatus & status, const lanelet::Ids & lanelet_ids) -> void
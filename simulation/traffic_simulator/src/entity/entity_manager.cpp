@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstdint>
+#include <exception>
 #include <geometry/bounding_box.hpp>
 #include <geometry/distance.hpp>
 #include <geometry/intersection/collision.hpp>
@@ -150,6 +151,7 @@ bool EntityManager::entityExists(const std::string & name)
 auto EntityManager::getEntityNames() const -> const std::vector<std::string>
 {
   std::vector<std::string> names{};
+  names.reserve(entities_.size());
   for (const auto & each : entities_) {
     names.push_back(each.first);
   }
@@ -190,8 +192,8 @@ auto EntityManager::getHdmapUtils() -> const std::shared_ptr<hdmap_utils::HdMapU
 
 auto EntityManager::getNumberOfEgo() const -> std::size_t
 {
-  return std::count_if(std::begin(entities_), std::end(entities_), [this](const auto & each) {
-    return is<EgoEntity>(each.first);
+  return std::count_if(std::begin(entities_), std::end(entities_), [](const auto & each) {
+    return dynamic_cast<EgoEntity const *>(each.second.get()) != nullptr;
   });
 }
 
@@ -352,22 +354,81 @@ auto EntityManager::updateNpcLogic(
   const std::string & name, const double current_time, const double step_time)
   -> const CanonicalizedEntityStatus &
 {
-  if (configuration.verbose) {
-    std::cout << "update " << name << " behavior" << std::endl;
-  }
   if (const auto entity = getEntity(name)) {
-    // Update npc completely if logic has started, otherwise update Autoware only - if it is Ego
-    if (npc_logic_started_) {
-      entity->onUpdate(current_time, step_time);
-    } else if (const auto ego_entity = std::dynamic_pointer_cast<const EgoEntity>(entity)) {
-      ego_entity->updateFieldOperatorApplication();
-    }
-    return entity->getCanonicalizedStatus();
+    return updateNpcLogic(entity, current_time, step_time);
   } else {
     THROW_SEMANTIC_ERROR("entity ", std::quoted(name), " does not exist.");
   }
 }
 
+auto EntityManager::updateNpcLogic(
+  const std::shared_ptr<EntityBase> & entity, const double current_time, const double step_time)
+  -> const CanonicalizedEntityStatus &
+{
+  if (configuration.verbose) {
+    std::cout << "update " << entity->name << " behavior" << std::endl;
+  }
+  // Update npc completely if logic has started, otherwise update Autoware only - if it is Ego
+  if (npc_logic_started_) {
+    entity->onUpdate(current_time, step_time);
+  } else if (const auto ego_entity = std::dynamic_pointer_cast<const EgoEntity>(entity)) {
+    ego_entity->updateFieldOperatorApplication();
+  }
+  return entity->getCanonicalizedStatus();
+}
+
+auto EntityManager::takeEntityStatusSnapshot(
+  std::vector<EntityStatusSnapshot::value_type> && statuses)
+  -> std::shared_ptr<const EntityStatusSnapshot>
+{
+  return std::make_shared<const EntityStatusSnapshot>(
+    ++entity_status_snapshot_version_, std::move(statuses));
+}
+
+auto EntityManager::updateEntitiesInParallel(const double current_time, const double step_time)
+  -> void
+{
+  /*
+     An entity reads the others only through the snapshot taken before the
+     update, and writes only its own status, so updating entities in any
+     order gives the same statuses as updating them one by one. Egos drive
+     Autoware through ROS, so they are still updated on this thread.
+  */
+  std::vector<std::shared_ptr<EntityBase>> entities;
+  entities.reserve(entities_.size());
+  for (auto && [name, entity] : entities_) {
+    entities.push_back(entity);
+  }
+
+  std::vector<std::exception_ptr> exceptions(entities.size());
+
+  auto update = [&](std::size_t index) {
+    try {
+      entities[index]->onUpdate(current_time, step_time);
+    } catch (...) {
+      exceptions[index] = std::current_exception();
+    }
+  };
+
+  std::vector<std::size_t> npc_indices;
+  for (std::size_t index = 0; index < entities.size(); ++index) {
+    if (std::dynamic_pointer_cast<const EgoEntity>(entities[index])) {
+      update(index);
+    } else {
+      npc_indices.push_back(index);
+    }
+  }
+
+  entity_update_thread_pool_->parallelFor(
+    npc_indices.size(), [&](std::size_t i) { update(npc_indices[i]); });
+
+  for (const auto & exception : exceptions) {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
 void EntityManager::update(const double current_time, const double step_time)
 {
   traffic_simulator::helper::StopWatch<std::chrono::milliseconds> stop_watch_update(
@@ -378,32 +439,68 @@ void EntityManager::update(const double current_time, const double step_time)
       configuration.conventional_traffic_light_publish_rate);
     v2i_traffic_light_updater_.createTimer(configuration.v2i_traffic_light_publish_rate);
   }
-  std::unordered_map<std::string, CanonicalizedEntityStatus> all_status;
+  /*
+     Every entity sees the others through a view of one snapshot shared by
+     all of them, so each status is copied once per snapshot, not once per
+     entity that sees it.
+  */
+  std::vector<EntityStatusSnapshot::value_type> statuses;
+  statuses.reserve(entities_.size());
   for (auto && [name, entity] : entities_) {
-    all_status.emplace(name, entity->getCanonicalizedStatus());
+    statuses.emplace_back(name, entity->getCanonicalizedStatus());
   }
+  const auto status_before_update = takeEntityStatusSnapshot(std::move(statuses));
   for (auto && [name, entity] : entities_) {
-    entity->setOtherStatus(all_status);
+    entity->setOtherStatus(status_before_update);
   }
-  all_status.clear();
-  for (auto && [name, entity] : entities_) {
-    all_status.emplace(name, updateNpcLogic(name, current_time, step_time));
+  statuses.clear();
+  statuses.reserve(entities_.size());
+  if (entity_update_thread_pool_ and npc_logic_started_) {
+    updateEntitiesInParallel(current_time, step_time);
+    for (auto && [name, entity] : entities_) {
+      statuses.emplace_back(name, entity->getCanonicalizedStatus());
+    }
+  } else {
+    /*
+       As with parallel updates, an entity that throws does not keep the
+       others from being updated, so that the statuses do not depend on the
+       option.
+    */
+    std::exception_ptr exception;
+    for (auto && [name, entity] : entities_) {
+      try {
+        statuses.emplace_back(name, updateNpcLogic(entity, current_time, step_time));
+      } catch (...) {
+        if (not exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
   }
+  const auto status_after_update = takeEntityStatusSnapshot(std::move(statuses));
   for (auto && [name, entity] : entities_) {
-    entity->setOtherStatus(all_status);
+    entity->setOtherStatus(status_after_update);
   }
   traffic_simulator_msgs::msg::EntityStatusWithTrajectoryArray status_array_msg;
-  for (auto && [name, status] : all_status) {
+  status_array_msg.data.reserve(entities_.size());
+  // the snapshot was taken in the iteration order of entities_, so no name is looked up here
+  auto snapshot_iter = status_after_update->begin();
+  for (auto && [name, entity] : entities_) {
+    const auto & status = (snapshot_iter++)->second;
     traffic_simulator_msgs::msg::EntityStatusWithTrajectory status_with_trajectory;
-    status_with_trajectory.waypoint = getWaypoints(name);
-    for (const auto & goal : getGoalPoses<geometry_msgs::msg::Pose>(name)) {
-      status_with_trajectory.goal_pose.push_back(goal);
-    }
-    if (const auto obstacle = getObstacle(name); obstacle) {
-      status_with_trajectory.obstacle = obstacle.value();
-      status_with_trajectory.obstacle_find = true;
-    } else {
-      status_with_trajectory.obstacle_find = false;
+    status_with_trajectory.obstacle_find = false;
+    if (npc_logic_started_) {
+      status_with_trajectory.waypoint = entity->getWaypoints();
+      for (const auto & goal : entity->getGoalPoses()) {
+        status_with_trajectory.goal_pose.push_back(pose::toMapPose(goal));
+      }
+      if (const auto obstacle = entity->getObstacle(); obstacle) {
+        status_with_trajectory.obstacle = obstacle.value();
+        status_with_trajectory.obstacle_find = true;
+      }
     }
     status_with_trajectory.status = static_cast<EntityStatus>(status);
     status_with_trajectory.status.time = current_time + step_time;
@@ -0,0 +1,113 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iterator>
+#include <stdexcept>
+#include <traffic_simulator/entity/entity_registry.hpp>
+
+namespace traffic_simulator
+{
+namespace entity
+{
+auto EntityRegistry::getHandle(const std::string & name) const -> std::optional<Handle>
+{
+  if (const auto iter = indices_.find(name); iter != indices_.end()) {
+    return getHandle(entities_.begin() + iter->second);
+  } else {
+    return std::nullopt;
+  }
+}
+
+auto EntityRegistry::getHandle(const_iterator iter) const noexcept -> Handle
+{
+  const auto slot = entity_slots_[iter - entities_.begin()];
+  return Handle{slot, slots_[slot].generation};
+}
+
+auto EntityRegistry::get(const Handle & handle) const noexcept
+  -> const std::shared_ptr<EntityBase> &
+{
+  static const std::shared_ptr<EntityBase> none = nullptr;
+  if (handle.slot < slots_.size()) {
+    if (const auto & slot = slots_[handle.slot];
+        slot.index and slot.generation == handle.generation) {
+      return entities_[*slot.index].second;
+    }
+  }
+  return none;
+}
+
+auto EntityRegistry::find(const std::string & name) const -> const_iterator
+{
+  if (const auto iter = indices_.find(name); iter != indices_.end()) {
+    return entities_.begin() + iter->second;
+  } else {
+    return entities_.end();
+  }
+}
+
+auto EntityRegistry::at(const std::string & name) const -> const std::shared_ptr<EntityBase> &
+{
+  if (const auto iter = find(name); iter != entities_.end()) {
+    return iter->second;
+  } else {
+    throw std::out_of_range("EntityRegistry::at: no entity named " + name);
+  }
+}
+
+auto EntityRegistry::emplace(const std::string & name, std::shared_ptr<EntityBase> entity)
+  -> std::pair<const_iterator, bool>
+{
+  if (const auto [iter, inserted] = indices_.emplace(name, entities_.size()); not inserted) {
+    return {entities_.begin() + iter->second, false};
+  }
+
+  std::uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = static_cast<std::uint32_t>(slots_.size());
+    slots_.emplace_back();
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  slots_[slot].index = entities_.size();
+  entities_.emplace_back(name, std::move(entity));
+  entity_slots_.push_back(slot);
+  return {std::prev(entities_.cend()), true};
+}
+
+auto EntityRegistry::erase(const std::string & name) -> std::size_t
+{
+  if (const auto iter = indices_.find(name); iter != indices_.end()) {
+    const auto index = iter->second;
+    auto & slot = slots_[entity_slots_[index]];
+    free_slots_.push_back(entity_slots_[index]);
+    slot.index = std::nullopt;
+    ++slot.generation;
+    indices_.erase(iter);
+    if (const auto last = entities_.size() - 1; index != last) {
+      entities_[index] = std::move(entities_[last]);
+      entity_slots_[index] = entity_slots_[last];
+      slots_[entity_slots_[index]].index = index;
+      indices_[entities_[index].first] = index;
+    }
+    entities_.pop_back();
+    entity_slots_.pop_back();
+    return 1;
+  } else {
+    return 0;
+  }
+}
+}  // namespace entity
+}  // namespace traffic_simulator
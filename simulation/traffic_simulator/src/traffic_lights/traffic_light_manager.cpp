@@ -39,6 +39,8 @@ auto TrafficLightManager::hasAnyLightChanged() -> bool
 
 auto TrafficLightManager::getTrafficLight(const lanelet::Id traffic_light_id) -> TrafficLight &
 {
+  // the reference outlives the lock, as adding an element does not move the others
+  std::lock_guard<std::mutex> lock(traffic_lights_mutex_);
   if (auto iter = traffic_lights_.find(traffic_light_id); iter != std::end(traffic_lights_)) {
     return iter->second;
   } else {
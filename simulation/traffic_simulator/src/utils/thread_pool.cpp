@@ -0,0 +1,73 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <traffic_simulator/utils/thread_pool.hpp>
+#include <utility>
+
+namespace traffic_simulator
+{
+ThreadPool::ThreadPool(std::size_t thread_count)
+{
+  workers_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  task_available_.notify_all();
+  for (auto & worker : workers_) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::defaultThreadCount() -> std::size_t
+{
+  // Run as many threads as physical cores (which is usually /2 virtual threads)
+  // In heavy loads virtual threads (hyper-threading) add little to the overall performance
+  return std::max<std::size_t>(std::thread::hardware_concurrency() / 2, 1);
+}
+
+auto ThreadPool::push(std::function<void()> task) -> void
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  task_available_.notify_one();
+}
+
+auto ThreadPool::work() -> void
+{
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock, [this]() { return stopped_ or not tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+}  // namespace traffic_simulator
@@ -0,0 +1,137 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <traffic_simulator/data_type/entity_status_snapshot.hpp>
+#include <vector>
+
+#include "../helper_functions.hpp"
+
+using traffic_simulator::EntityStatusSnapshot;
+using traffic_simulator::OtherEntityStatusView;
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+class EntityStatusSnapshotTest : public testing::Test
+{
+protected:
+  EntityStatusSnapshotTest() : hdmap_utils(makeHdMapUtilsSharedPointer())
+  {
+    std::vector<EntityStatusSnapshot::value_type> statuses;
+    for (const auto & name : {"first", "second", "third"}) {
+      statuses.emplace_back(
+        name, makeCanonicalizedEntityStatus(
+                hdmap_utils, makePose(makePoint(3810.0, 73745.0)), makeBoundingBox(), 1.0, 0.0,
+                name));
+    }
+    snapshot = std::make_shared<const EntityStatusSnapshot>(7, std::move(statuses));
+  }
+
+  std::shared_ptr<hdmap_utils::HdMapUtils> hdmap_utils;
+
+  std::shared_ptr<const EntityStatusSnapshot> snapshot;
+};
+
+/**
+ * @note Test that every entity has the handle of its status.
+ */
+TEST_F(EntityStatusSnapshotTest, getHandle)
+{
+  EXPECT_EQ(snapshot->version(), std::uint64_t(7));
+  ASSERT_EQ(snapshot->size(), std::size_t(3));
+  for (const auto & name : {"first", "second", "third"}) {
+    const auto handle = snapshot->getHandle(name);
+    ASSERT_TRUE(handle);
+    EXPECT_EQ((*snapshot)[*handle].first, name);
+    EXPECT_EQ((*snapshot)[*handle].second.getName(), name);
+  }
+  EXPECT_FALSE(snapshot->getHandle("fourth"));
+}
+
+/**
+ * @note Test that the arrays of map poses and lanelets hold the fields of the statuses, and are
+ * read through a view by the iterators of that view.
+ */
+TEST_F(EntityStatusSnapshotTest, columns)
+{
+  for (EntityStatusSnapshot::Handle handle = 0; handle < snapshot->size(); ++handle) {
+    const auto & status = (*snapshot)[handle].second;
+    EXPECT_POSE_EQ(snapshot->getMapPose(handle), status.getMapPose());
+    if (status.laneMatchingSucceed()) {
+      EXPECT_EQ(snapshot->getLaneletId(handle), status.getLaneletId());
+    } else {
+      EXPECT_FALSE(snapshot->getLaneletId(handle));
+    }
+  }
+
+  const auto view = OtherEntityStatusView(snapshot, "second");
+  for (auto iter = view.begin(); iter != view.end(); ++iter) {
+    const auto handle = snapshot->getHandle(iter->first).value();
+    EXPECT_POSE_EQ(view.getMapPose(iter), snapshot->getMapPose(handle));
+    EXPECT_EQ(view.getLaneletId(iter), snapshot->getLaneletId(handle));
+  }
+}
+
+/**
+ * @note Test that a view skips the entity it is seen by, wherever its status is in the snapshot.
+ */
+TEST_F(EntityStatusSnapshotTest, OtherEntityStatusView)
+{
+  for (const auto & excluded : {"first", "second", "third"}) {
+    const auto view = OtherEntityStatusView(snapshot, excluded);
+    EXPECT_EQ(view.version(), std::uint64_t(7));
+    EXPECT_EQ(view.size(), std::size_t(2));
+    std::vector<std::string> names;
+    for (const auto & [name, status] : view) {
+      EXPECT_EQ(status.getName(), name);
+      names.push_back(name);
+    }
+    EXPECT_EQ(names.size(), std::size_t(2));
+    EXPECT_EQ(std::count(names.begin(), names.end(), excluded), 0);
+    EXPECT_TRUE(view.find(excluded) == view.end());
+    EXPECT_THROW(view.at(excluded), std::out_of_range);
+    for (const auto & name : names) {
+      ASSERT_TRUE(view.find(name) != view.end());
+      EXPECT_EQ(view.find(name)->first, name);
+      EXPECT_EQ(view.at(name).getName(), name);
+    }
+  }
+}
+
+/**
+ * @note Test that a view of an entity not in the snapshot sees every entity, and that a view of
+ * no snapshot sees none.
+ */
+TEST_F(EntityStatusSnapshotTest, OtherEntityStatusView_noExclusion)
+{
+  const auto view = OtherEntityStatusView(snapshot, "fourth");
+  EXPECT_EQ(view.size(), std::size_t(3));
+  EXPECT_EQ(std::distance(view.begin(), view.end()), 3);
+
+  const auto empty = OtherEntityStatusView();
+  EXPECT_TRUE(empty.empty());
+  EXPECT_TRUE(empty.begin() == empty.end());
+  EXPECT_TRUE(empty.find("first") == empty.end());
+}
@@ -0,0 +1,181 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <rclcpp/rclcpp.hpp>
+#include <scenario_simulator_exception/exception.hpp>
+#include <string>
+#include <traffic_simulator/api/configuration.hpp>
+#include <traffic_simulator/entity/entity_manager.hpp>
+#include <traffic_simulator/entity/misc_object_entity.hpp>
+#include <vector>
+
+#include "../helper_functions.hpp"
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  testing::InitGoogleTest(&argc, argv);
+  const auto result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
+
+/**
+ * @brief Entity whose speed depends on the statuses of the others it sees, and which throws on
+ * every update if it is named "throwing"
+ */
+class MovingEntity : public traffic_simulator::entity::MiscObjectEntity
+{
+public:
+  using MiscObjectEntity::MiscObjectEntity;
+
+  void onUpdate(double current_time, double step_time) override
+  {
+    MiscObjectEntity::onUpdate(current_time, step_time);
+    if (name == "throwing") {
+      THROW_SIMULATION_ERROR("entity ", std::quoted(name), " failed to update at ", current_time);
+    }
+    auto status = static_cast<traffic_simulator::EntityStatus>(getCanonicalizedStatus());
+    auto speed = 1.0;
+    for (const auto & [other_name, other_status] : other_status_) {
+      speed += 0.01 * std::hypot(
+                        other_status.getMapPose().position.x - status.pose.position.x,
+                        other_status.getMapPose().position.y - status.pose.position.y);
+    }
+    status.pose.position.x += speed * step_time;
+    status.action_status.twist.linear.x = speed;
+    status.time = current_time + step_time;
+    setStatus(status);
+  }
+};
+
+class EntityManagerTest : public testing::Test
+{
+protected:
+  EntityManagerTest() : map_path(std::filesystem::temp_directory_path() / "test_entity_manager")
+  {
+    // the configuration requires a pointcloud map next to the lanelet map, which is not read here
+    std::filesystem::remove_all(map_path);
+    std::filesystem::create_directories(map_path);
+    std::filesystem::copy_file(
+      ament_index_cpp::get_package_share_directory("traffic_simulator") +
+        "/map/standard_map/lanelet2_map.osm",
+      map_path / "lanelet2_map.osm");
+    std::ofstream(map_path / "pointcloud_map.pcd");
+  }
+
+  ~EntityManagerTest() { std::filesystem::remove_all(map_path); }
+
+  auto makeEntityManager(bool parallel_entity_update, const std::vector<std::string> & names)
+    -> std::shared_ptr<traffic_simulator::entity::EntityManager>
+  {
+    const auto node = std::make_shared<rclcpp::Node>(
+      parallel_entity_update ? "parallel_entity_manager" : "serial_entity_manager",
+      rclcpp::NodeOptions().parameter_overrides(
+        {rclcpp::Parameter("parallel_entity_update", parallel_entity_update),
+         rclcpp::Parameter("origin_latitude", 35.9037067912303),
+         rclcpp::Parameter("origin_longitude", 139.9337945139059)}));
+    nodes.push_back(node);
+    const auto entity_manager = std::make_shared<traffic_simulator::entity::EntityManager>(
+      node, traffic_simulator::Configuration(map_path.string()),
+      node->get_node_parameters_interface());
+    auto parameters = traffic_simulator_msgs::msg::MiscObjectParameters();
+    parameters.bounding_box = makeBoundingBox();
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      entity_manager->spawnEntity<MovingEntity>(
+        names[i], makeCanonicalizedLaneletPose(entity_manager->getHdmapUtils(), 120659, 5.0 * i),
+        parameters, 0.0);
+    }
+    entity_manager->startNpcLogic(0.0);
+    return entity_manager;
+  }
+
+  static auto expectSameStatuses(
+    const traffic_simulator::entity::EntityManager & serial,
+    const traffic_simulator::entity::EntityManager & parallel) -> void
+  {
+    ASSERT_EQ(serial.getEntityNames(), parallel.getEntityNames());
+    for (const auto & name : serial.getEntityNames()) {
+      EXPECT_TRUE(
+        static_cast<traffic_simulator::EntityStatus>(serial.getEntityStatus(name)) ==
+        static_cast<traffic_simulator::EntityStatus>(parallel.getEntityStatus(name)))
+        << "status of " << std::quoted(name) << " differs";
+    }
+  }
+
+  // the message of the exception thrown by the update, if any
+  static auto update(
+    traffic_simulator::entity::EntityManager & entity_manager, double current_time,
+    double step_time) -> std::optional<std::string>
+  {
+    try {
+      entity_manager.update(current_time, step_time);
+      return std::nullopt;
+    } catch (const common::SimulationError & error) {
+      return error.what();
+    }
+  }
+
+  const std::filesystem::path map_path;
+
+  std::vector<rclcpp::Node::SharedPtr> nodes;
+
+  const double step_time = 0.1;
+};
+
+/**
+ * @note Test that updating the entities in parallel gives exactly the statuses of updating them
+ * one by one.
+ */
+TEST_F(EntityManagerTest, update_parallelEntityUpdate)
+{
+  const auto names = std::vector<std::string>{"npc_0", "npc_1", "npc_2", "npc_3", "npc_4"};
+  const auto serial = makeEntityManager(false, names);
+  const auto parallel = makeEntityManager(true, names);
+  for (auto frame = 0; frame < 10; ++frame) {
+    const auto current_time = frame * step_time;
+    EXPECT_FALSE(update(*serial, current_time, step_time));
+    EXPECT_FALSE(update(*parallel, current_time, step_time));
+    expectSameStatuses(*serial, *parallel);
+  }
+}
+
+/**
+ * @note Test that updating the entities in parallel throws the exception of updating them one by
+ * one, and leaves every entity with the same status, when the update of an entity throws.
+ */
+TEST_F(EntityManagerTest, update_parallelEntityUpdate_throwing)
+{
+  const auto names = std::vector<std::string>{"npc_0", "throwing", "npc_1", "npc_2"};
+  const auto serial = makeEntityManager(false, names);
+  const auto parallel = makeEntityManager(true, names);
+  for (auto frame = 0; frame < 3; ++frame) {
+    const auto current_time = frame * step_time;
+    const auto serial_error = update(*serial, current_time, step_time);
+    const auto parallel_error = update(*parallel, current_time, step_time);
+    ASSERT_TRUE(serial_error);
+    ASSERT_TRUE(parallel_error);
+    EXPECT_EQ(*serial_error, *parallel_error);
+    expectSameStatuses(*serial, *parallel);
+  }
+}
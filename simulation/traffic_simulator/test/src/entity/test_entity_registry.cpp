@@ -0,0 +1,136 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <traffic_simulator/entity/entity_registry.hpp>
+#include <traffic_simulator/entity/misc_object_entity.hpp>
+#include <vector>
+
+#include "../helper_functions.hpp"
+
+using traffic_simulator::entity::EntityRegistry;
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+class EntityRegistryTest : public testing::Test
+{
+protected:
+  EntityRegistryTest() : hdmap_utils_ptr(makeHdMapUtilsSharedPointer())
+  {
+    for (const auto & name : {"first", "second", "third"}) {
+      EXPECT_TRUE(registry.emplace(name, makeEntity(name)).second);
+    }
+  }
+
+  auto makeEntity(const std::string & name) const
+    -> std::shared_ptr<traffic_simulator::entity::EntityBase>
+  {
+    return std::make_shared<traffic_simulator::entity::MiscObjectEntity>(
+      name,
+      makeCanonicalizedEntityStatus(
+        hdmap_utils_ptr, makeCanonicalizedLaneletPose(hdmap_utils_ptr, 120659), makeBoundingBox(),
+        0.0, name),
+      hdmap_utils_ptr, traffic_simulator_msgs::msg::MiscObjectParameters{});
+  }
+
+  auto getNames() const -> std::vector<std::string>
+  {
+    std::vector<std::string> names;
+    for (const auto & [name, entity] : registry) {
+      names.push_back(name);
+    }
+    return names;
+  }
+
+  std::shared_ptr<hdmap_utils::HdMapUtils> hdmap_utils_ptr;
+
+  EntityRegistry registry;
+};
+
+/**
+ * @note Test that entities are iterated in the order they were spawned, and that the handle of an
+ * entity reaches it.
+ */
+TEST_F(EntityRegistryTest, getHandle)
+{
+  EXPECT_EQ(getNames(), (std::vector<std::string>{"first", "second", "third"}));
+  for (const auto & name : {"first", "second", "third"}) {
+    const auto handle = registry.getHandle(name);
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(registry.get(*handle), registry.at(name));
+    EXPECT_EQ(registry.get(*handle)->name, name);
+  }
+  EXPECT_FALSE(registry.getHandle("fourth"));
+  EXPECT_TRUE(registry.find("fourth") == registry.end());
+  EXPECT_THROW(registry.at("fourth"), std::out_of_range);
+}
+
+/**
+ * @note Test that an entity is not replaced by another of the same name.
+ */
+TEST_F(EntityRegistryTest, emplace_sameName)
+{
+  const auto first = registry.at("first");
+  const auto [iter, success] = registry.emplace("first", makeEntity("first"));
+  EXPECT_FALSE(success);
+  EXPECT_EQ(iter->second, first);
+  EXPECT_EQ(registry.size(), std::size_t(3));
+}
+
+/**
+ * @note Test that erasing an entity keeps the handles of the others, and makes its own handle
+ * reach no entity, even once its slot is reused.
+ */
+TEST_F(EntityRegistryTest, erase)
+{
+  const auto first = registry.getHandle("first").value();
+  const auto second = registry.getHandle("second").value();
+  const auto third = registry.getHandle("third").value();
+
+  EXPECT_EQ(registry.erase("first"), std::size_t(1));
+  EXPECT_EQ(registry.erase("first"), std::size_t(0));
+  EXPECT_EQ(registry.size(), std::size_t(2));
+  EXPECT_FALSE(registry.getHandle("first"));
+  EXPECT_EQ(registry.get(first), nullptr);
+  EXPECT_EQ(registry.get(second)->name, "second");
+  EXPECT_EQ(registry.get(third)->name, "third");
+  EXPECT_EQ(registry.getHandle("second"), second);
+  EXPECT_EQ(registry.getHandle("third"), third);
+  for (const auto & name : {"second", "third"}) {
+    ASSERT_TRUE(registry.find(name) != registry.end());
+    EXPECT_EQ(registry.find(name)->first, name);
+    EXPECT_EQ(registry.getHandle(registry.find(name)), registry.getHandle(name));
+  }
+
+  EXPECT_TRUE(registry.emplace("fourth", makeEntity("fourth")).second);
+  const auto fourth = registry.getHandle("fourth").value();
+  EXPECT_EQ(fourth.slot, first.slot);
+  EXPECT_NE(fourth, first);
+  EXPECT_EQ(registry.get(first), nullptr);
+  EXPECT_EQ(registry.get(fourth)->name, "fourth");
+
+  auto names = getNames();
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, (std::vector<std::string>{"fourth", "second", "third"}));
+}
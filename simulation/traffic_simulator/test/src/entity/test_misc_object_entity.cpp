@@ -114,13 +114,13 @@ TEST_F(MiscObjectEntityTest_HdMapUtils, requestSpeedChange_relative)
       traffic_simulator_msgs::msg::EntityType::MISC_OBJECT),
     hdmap_utils_ptr, traffic_simulator_msgs::msg::MiscObjectParameters{});
 
-  std::unordered_map<std::string, traffic_simulator::entity_status::CanonicalizedEntityStatus>
-    others;
-  others.emplace(
+  std::vector<traffic_simulator::EntityStatusSnapshot::value_type> others;
+  others.emplace_back(
     "other_entity", makeCanonicalizedEntityStatus(
                       hdmap_utils_ptr, pose, bbox, 17.0, "other_entity_name",
                       traffic_simulator_msgs::msg::EntityType::MISC_OBJECT));
-  blob.setOtherStatus(others);
+  blob.setOtherStatus(
+    std::make_shared<const traffic_simulator::EntityStatusSnapshot>(1, std::move(others)));
 
   EXPECT_THROW(
     blob.requestSpeedChange(
@@ -347,13 +347,13 @@ TEST_F(MiscObjectEntityTest_FullObject, requestLaneChange_relativeTargetLaneletP
 {
   const std::string target_name = "target_name";
 
-  auto other_status =
-    std::unordered_map<std::string, traffic_simulator::CanonicalizedEntityStatus>{};
-  other_status.emplace(
+  auto other_status = std::vector<traffic_simulator::EntityStatusSnapshot::value_type>{};
+  other_status.emplace_back(
     target_name,
     makeCanonicalizedEntityStatus(hdmap_utils_ptr, makePose(makePoint(3810.0, 73745.0)), bbox));
 
-  entity_base->setOtherStatus(other_status);
+  entity_base->setOtherStatus(
+    std::make_shared<const traffic_simulator::EntityStatusSnapshot>(1, std::move(other_status)));
 
   EXPECT_THROW(entity_base->requestLaneChange(
     traffic_simulator::lane_change::RelativeTarget(
@@ -372,14 +372,14 @@ TEST_F(MiscObjectEntityTest_FullObject, requestLaneChange_relativeTargetName)
 {
   const std::string target_name = "target_name";
 
-  auto other_status =
-    std::unordered_map<std::string, traffic_simulator::CanonicalizedEntityStatus>{};
-  other_status.emplace(
+  auto other_status = std::vector<traffic_simulator::EntityStatusSnapshot::value_type>{};
+  other_status.emplace_back(
     target_name,
     makeCanonicalizedEntityStatus(
       hdmap_utils_ptr, makeCanonicalizedLaneletPose(hdmap_utils_ptr, 34468, 5.0), bbox));
 
-  entity_base->setOtherStatus(other_status);
+  entity_base->setOtherStatus(
+    std::make_shared<const traffic_simulator::EntityStatusSnapshot>(1, std::move(other_status)));
   EXPECT_THROW(
     entity_base->requestLaneChange(
       traffic_simulator::lane_change::RelativeTarget(
@@ -399,14 +399,14 @@ TEST_F(MiscObjectEntityTest_FullObject, requestLaneChange_relativeTargetInvalid)
 {
   const std::string target_name = "target_name";
 
-  auto other_status =
-    std::unordered_map<std::string, traffic_simulator::CanonicalizedEntityStatus>{};
-  other_status.emplace(
+  auto other_status = std::vector<traffic_simulator::EntityStatusSnapshot::value_type>{};
+  other_status.emplace_back(
     target_name,
     makeCanonicalizedEntityStatus(
       hdmap_utils_ptr, makeCanonicalizedLaneletPose(hdmap_utils_ptr, 34468, 5.0), bbox));
 
-  entity_base->setOtherStatus(other_status);
+  entity_base->setOtherStatus(
+    std::make_shared<const traffic_simulator::EntityStatusSnapshot>(1, std::move(other_status)));
   EXPECT_THROW(
     entity_base->requestLaneChange(
       traffic_simulator::lane_change::RelativeTarget(
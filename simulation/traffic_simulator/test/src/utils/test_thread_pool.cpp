@@ -0,0 +1,100 @@
+// Copyright 2015 TIER IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <traffic_simulator/utils/thread_pool.hpp>
+#include <stdexcept>
+#include <vector>
+
+using traffic_simulator::ThreadPool;
+
+/**
+ * @note Test basic functionality. Test that a submitted task runs and its result is returned.
+ */
+TEST(ThreadPool, submit)
+{
+  ThreadPool pool(2);
+
+  auto future = pool.submit([]() { return 42; });
+
+  EXPECT_EQ(future.get(), 42);
+}
+
+/**
+ * @note Test basic functionality. Test that every index is visited exactly once.
+ */
+TEST(ThreadPool, parallelFor_allIndices)
+{
+  ThreadPool pool(4);
+  std::vector<std::atomic<int>> visits(1000);
+
+  pool.parallelFor(visits.size(), [&](std::size_t i) { ++visits[i]; });
+
+  for (const auto & count : visits) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+/**
+ * @note Test function behavior when the pool has no worker - the calling thread does all the work.
+ */
+TEST(ThreadPool, parallelFor_noWorker)
+{
+  ThreadPool pool(0);
+  std::vector<int> values(100, 0);
+
+  pool.parallelFor(values.size(), [&](std::size_t i) { values[i] = static_cast<int>(i); });
+
+  EXPECT_EQ(std::accumulate(values.begin(), values.end(), 0), 4950);
+}
+
+/**
+ * @note Test function behavior when parallelFor is called from inside a task of the same pool.
+ */
+TEST(ThreadPool, parallelFor_nested)
+{
+  ThreadPool pool(2);
+  std::atomic<int> sum = 0;
+
+  pool.parallelFor(4, [&](std::size_t) { pool.parallelFor(4, [&](std::size_t) { ++sum; }); });
+
+  EXPECT_EQ(sum, 16);
+}
+
+/**
+ * @note Test function behavior when a task throws - the exception has to reach the caller.
+ */
+TEST(ThreadPool, parallelFor_exception)
+{
+  ThreadPool pool(2);
+
+  EXPECT_THROW(
+    pool.parallelFor(
+      10,
+      [](std::size_t i) {
+        if (i == 5) {
+          throw std::runtime_error("failure");
+        }
+      }),
+    std::runtime_error);
+}
+
+int main(int argc, char ** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}